@@ -4,8 +4,12 @@ echo "Compiling HLSL shaders..."
 
 dxc -T vs_6_0 -E vsmain -Fo bin/vertex.cso vertex.hlsl
 
+dxc -T vs_6_0 -E vsmain -D PACKED_VERTEX -Fo bin/vertex_packed.cso vertex.hlsl
+
 dxc -T ps_6_0 -E psmain -Fo bin/pixel.cso pixel.hlsl
 
+dxc -T vs_6_0 -E vsmain -Fo bin/depth_vs.cso depth_vs.hlsl
+
 dxc -T vs_6_0 -E vsmain -Fo bin/grid_vs.cso grid_vs.hlsl
 
 dxc -T ps_6_0 -E psmain -Fo bin/grid_ps.cso grid_ps.hlsl
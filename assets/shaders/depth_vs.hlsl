@@ -0,0 +1,14 @@
+// Depth-only vertex shader for prepass / shadow pipelines, reads the position stream only
+// (Mesh::drawDepth, input layout from getDepthInputLayout())
+
+cbuffer ModelViewProjectionCB : register(b0)
+{
+    matrix model;
+    matrix viewProj;
+};
+
+float4 vsmain(float3 position : POSITION) : SV_POSITION
+{
+    float4 worldPosition = mul(float4(position, 1.0), model);
+    return mul(worldPosition, viewProj);
+}
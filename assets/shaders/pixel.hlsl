@@ -34,12 +34,26 @@ cbuffer LightCB : register(b2)
     float  padding[2];
 };
 
+// Channel-packed occlusion / roughness / metalness / specular from the texture
+// cooker: which channel of MaskMap holds each, -1 when the material has none
+cbuffer MaskCB : register(b4)
+{
+    int4 maskChannels; // x = occlusion, y = roughness, z = metalness, w = specular
+};
+
 // Texture/Sampler
 Texture2D TextureMap   : register(t0);
 Texture2D NormalMap    : register(t1);
 Texture2D SpecularMap  : register(t2);
+Texture2D MaskMap      : register(t3);
 SamplerState SamplerWrap : register(s0);
 
+// Reads the channel of a packed mask, fallback when the map isn't there
+float maskValue(float4 mask, int channel, float fallback)
+{
+    return channel >= 0 ? mask[channel] : fallback;
+}
+
 // struct PixelInputType {
 //     float4 position    : SV_POSITION; // clip-space
 //     float3 worldPos    : WORLDPOS;    // world-space pos
@@ -68,8 +82,11 @@ float4 psmain(PixelInputType IN) : SV_TARGET
     float3 N;
     if (material.useNormalMap > 0.5f)
     {
-        // Sample and unpack normal map (tangent space)
-        float3 normalTex = NormalMap.Sample(SamplerWrap, IN.uv).xyz * 2.0f - 1.0f;
+        // Sample and unpack normal map (tangent space). Z is rebuilt from X/Y
+        // so BC5 maps (two channels) and RGB maps both work
+        float3 normalTex;
+        normalTex.xy = NormalMap.Sample(SamplerWrap, IN.uv).xy * 2.0f - 1.0f;
+        normalTex.z = sqrt(saturate(1.0f - dot(normalTex.xy, normalTex.xy)));
         // Transform to world space using TBN
         N = normalize(mul(normalTex, TBN));
     }
@@ -79,6 +96,18 @@ float4 psmain(PixelInputType IN) : SV_TARGET
         N = normalize(IN.worldNormal);
     }
 
+    // Packed mask, one fetch for every map the material has
+    float4 mask = float4(1.0f, 1.0f, 1.0f, 1.0f);
+    if (any(maskChannels >= 0))
+        mask = MaskMap.Sample(SamplerWrap, IN.uv);
+
+    float occlusion = maskValue(mask, maskChannels.x, 1.0f);
+    float roughness = maskValue(mask, maskChannels.y, 0.0f);
+    float metalness = maskValue(mask, maskChannels.z, 0.0f);
+
+    // Rough surfaces spread the highlight: shininess falls towards 2 as roughness goes to 1
+    float shininess = lerp(material.specularPower, 2.0f, roughness);
+
     // Lighting
     computeLighting(
         lights,
@@ -86,7 +115,7 @@ float4 psmain(PixelInputType IN) : SV_TARGET
         eyePosition.xyz,
         globalAmbient.xyz,
         (useBlinnPhong > 0.5f),
-        material.specularPower,
+        shininess,
         IN.worldPos,
         N,
         ambient,
@@ -102,10 +131,13 @@ float4 psmain(PixelInputType IN) : SV_TARGET
     if (material.useSpecularMap > 0.5f)
         specColor = SpecularMap.Sample(SamplerWrap, IN.uv).rgb;
 
+    // Metals tint their highlight with the surface color, the specular map scales it
+    specColor = lerp(specColor, texColor.rgb, metalness) * maskValue(mask, maskChannels.w, 1.0f);
+
     // Final Lighting Combination
     float3 lit =    material.emissive.rgb     // emissive glow
-                    + material.ambient.rgb      // material ambient
-                    + ambient                   // global ambient
+                    + (material.ambient.rgb     // material ambient
+                    + ambient) * occlusion      // global ambient, both occluded
                     + diffuse                   // diffuse term
                     + (specular * specColor);   // specular term
 
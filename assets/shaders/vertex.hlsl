@@ -1,9 +1,19 @@
+// PACKED_VERTEX -> 20-byte PackedVertex (see vertex_format.h), otherwise the full VertexStruct
+#ifdef PACKED_VERTEX
+struct VertexInput {
+    float4 position : POSITION; // unorm over mesh bounds, w = handedness 0/1
+    float2 normal   : NORMAL0;  // octahedral
+    float2 tangent  : TANGENT;  // octahedral
+    float2 uv       : TEXCOORD0;
+};
+#else
 struct VertexInput {
     float4 position : POSITION;
     float3 normal   : NORMAL0;
     float4 tangent  : TANGENT;
     float2 uv       : TEXCOORD0;
 };
+#endif
 
 struct VertexOutput {
     float4 position    : SV_POSITION;
@@ -22,6 +32,26 @@ cbuffer ModelViewProjectionCB : register(b0)
     matrix viewProj;
 };
 
+#ifdef PACKED_VERTEX
+// Per-mesh dequantization, root constants
+cbuffer VertexDequantCB : register(b3)
+{
+    float3 positionScale;
+    float  dequantPad0;
+    float3 positionOffset;
+    float  dequantPad1;
+};
+
+float3 octDecode(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
+
 float3x3 inverse3x3(float3x3 m)
 {
     float3 a = m[0];
@@ -40,20 +70,30 @@ VertexOutput vsmain(VertexInput input)
 {
     VertexOutput output;
 
-    float4 worldPosition = mul(input.position, model);
+#ifdef PACKED_VERTEX
+    float4 position = float4(input.position.xyz * positionScale + positionOffset, 1.0);
+    float3 normal = octDecode(input.normal);
+    float4 tangent = float4(octDecode(input.tangent), input.position.w * 2.0 - 1.0);
+#else
+    float4 position = input.position;
+    float3 normal = input.normal;
+    float4 tangent = input.tangent;
+#endif
+
+    float4 worldPosition = mul(position, model);
     output.position = mul(worldPosition, viewProj);
     output.worldPos = worldPosition.xyz;
     output.uv = input.uv;
 
     float3x3 normalMatrix = transpose(inverse3x3((float3x3)model));
 
-    float3 worldNormal    = normalize(mul(input.normal, normalMatrix));
-    float3 worldTangent   = normalize(mul(input.tangent.xyz, (float3x3)model));
+    float3 worldNormal    = normalize(mul(normal, normalMatrix));
+    float3 worldTangent   = normalize(mul(tangent.xyz, (float3x3)model));
 
     // Orthonormalize
     worldTangent = normalize(worldTangent - worldNormal * dot(worldNormal, worldTangent));
 
-    float3 worldBitangent = cross(worldNormal, worldTangent) * input.tangent.w;
+    float3 worldBitangent = cross(worldNormal, worldTangent) * tangent.w;
 
     output.worldNormal = worldNormal;
 
@@ -3,13 +3,20 @@
 
 #include "engine/device.h"
 #include "engine/command_queue.h"
+#include "engine/frame_scheduler.h"
 #include "engine/swapchain.h"
 #include "engine/mesh.h"
 #include "engine/shader.h"
 #include "engine/pipeline.h"
 #include "engine/model.h"
+#include "engine/geometry/vertex_format.h"
 
 #include "engine/resources/constant.h"
+#include "engine/resources/geometry_pool.h"
+#include "engine/resources/gpu_allocator.h"
+#include "engine/resources/texture_cache.h"
+#include "engine/resources/texture_streamer.h"
+#include "engine/resources/upload_ring.h"
 
 #include "engine/scene/camera.h"
 #include "engine/scene/lighting.h"
@@ -18,6 +25,25 @@
 #include "utils/events.h"
 #include "utils/frame_timer.h"
 
+namespace {
+    // GPU memory streamed texture mips may take, small base mips included
+    constexpr uint64_t TEXTURE_STREAMING_BUDGET = 256ull << 20;
+
+    // Staging memory shared by every texture upload, and the most one submission carries
+    constexpr uint64_t UPLOAD_RING_SIZE = 64ull << 20;
+    constexpr uint64_t UPLOAD_BATCH_SIZE = 16ull << 20;
+
+    // Same for vertex and index data, copied on the copy queue
+    constexpr uint64_t GEOMETRY_RING_SIZE = 32ull << 20;
+    constexpr uint64_t GEOMETRY_BATCH_SIZE = 8ull << 20;
+
+    // Shared vertex / index buffers every mesh is suballocated from
+    constexpr uint64_t GEOMETRY_ARENA_SIZE = 64ull << 20;
+
+    // Constants written per frame (MVP, lights, grid), per frame in flight
+    constexpr uint64_t FRAME_CONSTANTS_SIZE = 1ull << 20;
+}
+
 Application::Application(
     HINSTANCE hInstance, 
     WindowConfig &config
@@ -65,11 +91,11 @@ void Application::init() {
     // );
     // LOG_INFO(L"Engine->DirectX 12 computeCommandQueue initialized.");
 
-    // copyCommandQueue = std::make_unique<CommandQueue>(
-    //     device->getDevice(),
-    //     D3D12_COMMAND_LIST_TYPE_COPY
-    // );
-    // LOG_INFO(L"Engine->DirectX 12 copyCommandQueue initialized.");
+    copyCommandQueue = std::make_unique<CommandQueue>(
+        device->getDevice(),
+        D3D12_COMMAND_LIST_TYPE_COPY
+    );
+    LOG_INFO(L"Application -> copyCommandQueue initialized!");
 
     swapchain = std::make_unique<Swapchain>(
         window->getHwnd(),
@@ -88,22 +114,78 @@ void Application::init() {
     LOG_INFO(L"-- Resources --");
 
     // create buffers
-    model = std::make_unique<Model>(
+    ImportSettings modelSettings;
+    modelSettings.vertexFormat = VertexFormat::Packed;
+
+    // Imported in parallel, the first one is the model drawn below
+    const std::vector<std::string> modelPaths = {
+        // "assets/models/building1/building.obj",
+        // "assets/models/cat/cat.obj",
+        "assets/models/mountain1/mountain.obj",
+        // "assets/models/weapon1/sniper.obj",
+    };
+
+    // One mapped upload buffer instead of a staging buffer per texture
+    uploadRing = std::make_unique<UploadRing>(
         device->getDevice(),
         directCommandQueue.get(),
+        UPLOAD_RING_SIZE,
+        UPLOAD_BATCH_SIZE
+    );
+
+    // Geometry goes to default heaps, copied while the direct queue keeps drawing
+    geometryRing = std::make_unique<UploadRing>(
+        device->getDevice(),
+        copyCommandQueue.get(),
+        GEOMETRY_RING_SIZE,
+        GEOMETRY_BATCH_SIZE
+    );
+
+    // Meshes are ranges in a few large buffers, so draws rarely rebind them
+    geometryPool = std::make_unique<GeometryPool>(
+        device->getDevice(),
+        geometryRing.get(),
+        directCommandQueue.get(),
+        GEOMETRY_ARENA_SIZE
+    );
+
+    // Cooked textures start with their small mips, the rest follow what the camera sees
+    textureStreamer = std::make_unique<TextureStreamer>(
+        device->getDevice(),
+        uploadRing.get(),
         swapchain->getSRVHeap(),
-        // "assets/models/building1/building.obj"
-        // "assets/models/cat/cat.obj"
-        "assets/models/mountain1/mountain.obj"
-        // "assets/models/weapon1/sniper.obj"
+        TEXTURE_STREAMING_BUDGET
     );
+
+    // One SRV and one upload per distinct image across all models
+    textureCache = std::make_unique<TextureCache>(
+        device->getDevice(),
+        swapchain->getSRVHeap(),
+        true, // also match identical files under different names
+        MipFilter::Box,
+        textureStreamer.get()
+    );
+
+    std::vector<std::unique_ptr<Model>> models = Model::loadMany(
+        device->getDevice(),
+        uploadRing.get(),
+        geometryPool.get(),
+        textureCache.get(),
+        modelPaths,
+        modelSettings
+    );
+    model = std::move(models.front());
     LOG_INFO(L"Model Resource initialized!");
 
-    mvpBuffer = std::make_unique<ConstantBuffer>(
+    // Allocator, constants and descriptors per frame in flight, so onUpdate never
+    // writes what the GPU still reads and the CPU only waits when it is that far ahead
+    frames = std::make_unique<FrameScheduler>(
         device->getDevice(),
-        static_cast<UINT>(sizeof(MVPConstantStruct))
+        directCommandQueue.get(),
+        config.framesInFlight,
+        FRAME_CONSTANTS_SIZE
     );
-    LOG_INFO(L"mvpBuffer Resource initialized!");
+    LOG_INFO(L"frames Resource initialized!");
 
     materialBuffer = std::make_unique<ConstantBuffer>(
         device->getDevice(),
@@ -124,17 +206,19 @@ void Application::init() {
 
     camera1->frameModel(modelCenter, modelRadius);
 
-    lighting1 = std::make_unique<Lighting>(
-        device->getDevice()
-    );
+    lighting1 = std::make_unique<Lighting>();
     LOG_INFO(L"Lighting initialized!");
 
     sceneGrid = std::make_unique<Grid>(
         device->getDevice(),
         directCommandQueue.get(),
+        geometryPool.get(),
         swapchain->getSRVHeap()
     );
 
+    // Model and grid geometry, the first frame waits for it on the GPU
+    geometryFence = geometryPool->submit();
+
     // pipeline
     // Root parameters: TODO: make it dynamic?
 
@@ -171,6 +255,21 @@ void Application::init() {
     CD3DX12_ROOT_PARAMETER specularSrvParam;
     specularSrvParam.InitAsDescriptorTable(1, &specularSrvRange, D3D12_SHADER_VISIBILITY_PIXEL);
 
+    // Vertex dequantization = b3 (VS), 8 root constants, only read by the packed shader
+    CD3DX12_ROOT_PARAMETER dequantParam;
+    dequantParam.InitAsConstants(sizeof(VertexDequant) / 4, 3, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+
+    // Texture = t3 (PS), channel-packed occlusion / roughness / metalness / specular
+    CD3DX12_DESCRIPTOR_RANGE maskSrvRange;
+    maskSrvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 3);
+
+    CD3DX12_ROOT_PARAMETER maskSrvParam;
+    maskSrvParam.InitAsDescriptorTable(1, &maskSrvRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+    // Mask channel layout = b4 (PS), 4 root constants set per material
+    CD3DX12_ROOT_PARAMETER maskChannelsParam;
+    maskChannelsParam.InitAsConstants(MASK_CHANNEL_COUNT, 4, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+
     // Combine
     std::vector<D3D12_ROOT_PARAMETER> rootParams = {
         cbvMvpParam,
@@ -178,17 +277,18 @@ void Application::init() {
         cbvLightParam,
         srvRootParam,
         normalSrvParam,
-        specularSrvParam
+        specularSrvParam,
+        dequantParam,
+        maskSrvParam,
+        maskChannelsParam
     };
 
-    std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-    };
+    const VertexFormat vertexFormat = model->getVertexFormat();
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout = getInputLayout(vertexFormat);
 
-    auto vertexShader = Shader(L"assets/shaders/vertex.cso");
+    auto vertexShader = Shader(vertexFormat == VertexFormat::Packed 
+        ? L"assets/shaders/vertex_packed.cso" 
+        : L"assets/shaders/vertex.cso");
     auto pixelShader = Shader(L"assets/shaders/pixel.cso");
 
     
@@ -264,8 +364,6 @@ void Application::init() {
         { 1.0f, 0.9f, 0.8f },
         1.0f
     );
-
-    lighting1->updateGPU();
 }
 
 int Application::run() {
@@ -309,6 +407,11 @@ int Application::run() {
 
 void Application::onUpdate(UpdateEventArgs& args)
 {
+    // Oldest frame context, waits only if the GPU hasn't finished the frame that last used it
+    frames->beginFrame();
+    LOG_INFO(L"Application -> Frame %u of %u in flight, CPU waited %.3f ms",
+        frames->getFrameIndex(), frames->getFramesInFlight(), frames->getStats().lastWaitMs);
+
     camera1->update(static_cast<float>(args.totalTime));
 
     // Rotate the cube over time
@@ -320,11 +423,22 @@ void Application::onUpdate(UpdateEventArgs& args)
     MVPConstantStruct mvpData;
     mvpData.model = XMMatrixTranspose(model);        
     mvpData.viewProj = XMMatrixTranspose(view * projection);
-    mvpBuffer->update(&mvpData, sizeof(mvpData));
+    mvpAddress = frames->getConstants().push(mvpData);
+
+    // LOD per mesh first, meshes that stay at LOD 0 then get meshlet culled
+    this->model->selectLods(model, projection, camera1->getPosition(), viewport.Height);
+
+    // Texture mips for the same view, uploaded ahead of this frame's command list
+    this->model->requestTextureMips(model, projection, camera1->getPosition(), viewport.Height);
+    textureStreamer->update();
+
+    // Meshlet culling into this frame's index buffers, GPU is done with them
+    // since beginFrame() waited on this context's last fence
+    this->model->cull(model, view * projection, camera1->getPosition(), frames->getFrameIndex());
 
     XMFLOAT3 camPos = camera1->getPosition();
     lighting1->setEyePosition(camPos);
-    lighting1->updateGPU(); // Push the light buffer to GPU
+    lighting1->updateGPU(frames->getConstants()); // Push the light buffer to GPU
 
     sceneGrid->updateMVP(view * projection);
 }
@@ -333,8 +447,8 @@ void Application::onRender(RenderEventArgs& args)
 {
     LOG_INFO(L"Application -> Rendering frame...");
 
-    // Get a command list from the queue; allocator is managed internally
-    auto commandList = directCommandQueue->getCommandList();
+    // Recorded on this frame's allocator, reset by beginFrame() once it is free
+    auto commandList = frames->getCommandList();
     LOG_INFO(L"Application -> CommandList acquired.");
 
     auto commandQueue = directCommandQueue->getCommandQueue();
@@ -382,7 +496,7 @@ void Application::onRender(RenderEventArgs& args)
     );
     LOG_INFO(L"Application -> Render target and depth-stencil cleared.");
 
-    sceneGrid->draw(commandList.Get());
+    sceneGrid->draw(commandList.Get(), frames->getConstants());
     LOG_INFO(L"Application -> sceneGrid->draw.");
 
     
@@ -396,20 +510,26 @@ void Application::onRender(RenderEventArgs& args)
     LOG_INFO(L"Application -> Primitive topology set to TRIANGLELIST.");
 
     // Set constant buffer (MVP updated in onUpdate)
-    commandList->SetGraphicsRootConstantBufferView(0, mvpBuffer->getGPUAddress());
+    commandList->SetGraphicsRootConstantBufferView(0, mvpAddress);
     LOG_INFO(L"Application -> Constant buffer bound.");
 
     commandList->SetGraphicsRootConstantBufferView(1, materialBuffer->getGPUAddress());
 
     // Root parameter 1 = light CBV
-    commandList->SetGraphicsRootConstantBufferView(2, lighting1->getCBV()->getGPUAddress());
+    commandList->SetGraphicsRootConstantBufferView(2, lighting1->getGPUAddress());
     LOG_INFO(L"Application -> Lighting CBV bound.");
 
     // call mesh/model draw
+    MaterialSlots materialSlots;
+    materialSlots.texture = 3;      // Root parameter index for the SRV (t0)
+    materialSlots.maskTexture = 7;  // Root parameter index for the packed mask SRV (t3)
+    materialSlots.maskChannels = 8; // Root parameter index for the mask channel constants (b4)
+
     model->draw(
         commandList.Get(),
         srvHeap->getHeap().Get(),
-        3 // Root parameter index for the SRV (t0)
+        materialSlots,
+        6  // Root parameter index for the vertex dequant constants (b3)
     );
     
     LOG_INFO(L"Application -> Model drawn.");
@@ -420,8 +540,16 @@ void Application::onRender(RenderEventArgs& args)
                        D3D12_RESOURCE_STATE_PRESENT);
     LOG_INFO(L"Application -> Back buffer transitioned to PRESENT.");
 
-    // Execute command list
-    fenceValues[currentBackBufferIndex] = directCommandQueue->executeCommandList(commandList);
+    // Geometry still copying: the direct queue waits for it on the GPU. Later frames are
+    // queued behind that wait anyway, so it only goes in once.
+    if (geometryFence != 0) {
+        if (!copyCommandQueue->isFenceComplete(geometryFence))
+            directCommandQueue->waitForQueue(*copyCommandQueue, geometryFence);
+        geometryFence = 0;
+    }
+
+    // Execute command list, geometry freed meanwhile waits for its fence
+    geometryPool->endFrame(frames->endFrame(commandList));
     LOG_INFO(L"Application -> CommandList executed.");
 
     // Present
@@ -430,11 +558,8 @@ void Application::onRender(RenderEventArgs& args)
     throwFailed(swapchain->getSwapchain()->Present(syncInterval, presentFlags));
     LOG_INFO(L"Application -> Frame presented.");
 
+    // No wait here, the next beginFrame() blocks only when too far ahead
     currentBackBufferIndex = swapchain->getSwapchain()->GetCurrentBackBufferIndex();
-
-    // Wait for GPU to finish frame
-    directCommandQueue->fenceWait(fenceValues[currentBackBufferIndex]);
-    LOG_INFO(L"Application -> GPU finished frame.");
 }
 
 void Application::transitionResource(
@@ -536,6 +661,9 @@ void Application::cleanUp()
         directCommandQueue->flush();
     }
 
+    if (copyCommandQueue)
+        copyCommandQueue->flush();
+
     // Release GPU-dependent objects first
     if (sceneGrid) {
         sceneGrid.reset();
@@ -547,9 +675,40 @@ void Application::cleanUp()
         LOG_INFO(L"Model released.");
     }
 
-    if (mvpBuffer) {
-        mvpBuffer.reset();
-        LOG_INFO(L"MVP constant buffer released.");
+    if (textureCache) {
+        textureCache->logStats();
+        textureCache.reset();
+        LOG_INFO(L"Texture cache released.");
+    }
+
+    if (textureStreamer) {
+        textureStreamer->logStats();
+        textureStreamer.reset();
+        LOG_INFO(L"Texture streamer released.");
+    }
+
+    if (uploadRing) {
+        uploadRing->logStats();
+        uploadRing.reset();
+        LOG_INFO(L"Upload ring released.");
+    }
+
+    if (geometryPool) {
+        geometryPool->logStats();
+        geometryPool.reset();
+        LOG_INFO(L"Geometry pool released.");
+    }
+
+    if (geometryRing) {
+        geometryRing->logStats();
+        geometryRing.reset();
+        LOG_INFO(L"Geometry upload ring released.");
+    }
+
+    if (frames) {
+        frames->logStats();
+        frames.reset();
+        LOG_INFO(L"Frame contexts released.");
     }
 
     if (materialBuffer) {
@@ -577,6 +736,15 @@ void Application::cleanUp()
         LOG_INFO(L"Swapchain released.");
     }
 
+    // Nothing is placed in the heaps anymore, they go before the device
+    GpuAllocator::instance().logStats();
+    GpuAllocator::instance().trim();
+
+    if (copyCommandQueue) {
+        copyCommandQueue.reset();
+        LOG_INFO(L"Copy queue released.");
+    }
+
     if (directCommandQueue) {
         directCommandQueue.reset();
         LOG_INFO(L"Command queue released.");
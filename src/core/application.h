@@ -7,7 +7,12 @@ class Device;
 class CommandQueue;
 class Swapchain;
 class Model;
+class TextureCache;
+class TextureStreamer;
+class UploadRing;
+class GeometryPool;
 class ConstantBuffer;
+class FrameScheduler;
 class Pipeline;
 class Camera;
 class Lighting;
@@ -53,7 +58,7 @@ class Application
         RECT windowRect = {};
 
         UINT currentBackBufferIndex;
-        uint64_t fenceValues[FRAMEBUFFERCOUNT] {};
+        uint64_t geometryFence = 0; // copy queue value the next frame waits on, 0 once waited
 
         D3D12_VIEWPORT viewport;
         D3D12_RECT scissorRect;
@@ -63,10 +68,16 @@ class Application
         std::unique_ptr<Device> device;
         std::unique_ptr<CommandQueue> directCommandQueue;
         // std::unique_ptr<CommandQueue> computeCommandQueue;
-        // std::unique_ptr<CommandQueue> copyCommandQueue;
+        std::unique_ptr<CommandQueue> copyCommandQueue;
         std::unique_ptr<Swapchain> swapchain;
+        std::unique_ptr<UploadRing> uploadRing;
+        std::unique_ptr<UploadRing> geometryRing;
+        std::unique_ptr<GeometryPool> geometryPool;
+        std::unique_ptr<TextureStreamer> textureStreamer;
+        std::unique_ptr<TextureCache> textureCache;
         std::unique_ptr<Model> model;
-        std::unique_ptr<ConstantBuffer> mvpBuffer;
+        std::unique_ptr<FrameScheduler> frames;
+        D3D12_GPU_VIRTUAL_ADDRESS mvpAddress = 0; // this frame's, from frames->getConstants()
         std::unique_ptr<ConstantBuffer> materialBuffer;
         std::unique_ptr<Pipeline> pipeline1;
         std::unique_ptr<Camera> camera1;
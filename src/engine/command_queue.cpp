@@ -61,43 +61,50 @@ ComPtr<ID3D12GraphicsCommandList2> CommandQueue::getCommandList() {
         alloc = createCommandAllocator();
     }
 
-    // Acquire command list
+    ComPtr<ID3D12GraphicsCommandList2> cmdList = openCommandList(alloc);
+    liveListAllocMap[cmdList.Get()] = alloc;
+    return cmdList;
+}
+
+ComPtr<ID3D12GraphicsCommandList2> CommandQueue::getCommandList(ComPtr<ID3D12CommandAllocator> allocator) {
+    LOG_INFO(L"Requesting CommandList on a caller-owned allocator");
+    return openCommandList(allocator);
+}
+
+ComPtr<ID3D12GraphicsCommandList2> CommandQueue::openCommandList(ComPtr<ID3D12CommandAllocator> allocator) {
     ComPtr<ID3D12GraphicsCommandList2> cmdList;
     if (!listQueue.empty()) {
         ListEntry entry = listQueue.front();
         listQueue.pop();
         cmdList = entry.list;
-        throwFailed(cmdList->Reset(alloc.Get(), nullptr));
+        throwFailed(cmdList->Reset(allocator.Get(), nullptr));
         LOG_INFO(L"Reusing CommandList from pool (reset)");
     } else {
-        cmdList = createCommandList(alloc);
+        cmdList = createCommandList(allocator);
         LOG_INFO(L"Created new CommandList (open)");
     }
-
-    liveListAllocMap[cmdList.Get()] = alloc;
     return cmdList;
 }
 
 UINT64 CommandQueue::executeCommandList(ComPtr<ID3D12GraphicsCommandList2> cmdList) {
     throwFailed(cmdList->Close());
 
-    // Retrieve allocator
+    // Retrieve allocator, lists on a caller-owned one have none here
     auto it = liveListAllocMap.find(cmdList.Get());
     ComPtr<ID3D12CommandAllocator> allocatorForList = nullptr;
     if (it != liveListAllocMap.end()) {
         allocatorForList = it->second;
         liveListAllocMap.erase(it);
-    } else {
-        LOG_ERROR(L"Allocator not found for executed command list!");
     }
 
     // Execute
     ID3D12CommandList* lists[] = { cmdList.Get() };
     queue->ExecuteCommandLists(1, lists);
 
-    // Signal fence
+    // Signal fence, pooled allocators come back once it passes
     UINT64 val = signalFence();
-    allocatorQueue.push({ val, allocatorForList });
+    if (allocatorForList)
+        allocatorQueue.push({ val, allocatorForList });
 
     // Return list to pool
     listQueue.push({ cmdList, allocatorForList });
@@ -129,3 +136,7 @@ void CommandQueue::fenceFlush(UINT64 value) {
 void CommandQueue::flush() {
     fenceWait(signalFence());
 }
+
+void CommandQueue::waitForQueue(const CommandQueue& other, UINT64 value) {
+    throwFailed(queue->Wait(other.fence.Get(), value));
+}
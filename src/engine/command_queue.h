@@ -15,6 +15,9 @@ public:
     // Command List
     ComPtr<ID3D12GraphicsCommandList2> createCommandList(ComPtr<ID3D12CommandAllocator> allocator);
     ComPtr<ID3D12GraphicsCommandList2> getCommandList();
+
+    // On an allocator the caller owns and resets (one per frame in flight), not the pool's
+    ComPtr<ID3D12GraphicsCommandList2> getCommandList(ComPtr<ID3D12CommandAllocator> allocator);
     UINT64 executeCommandList(ComPtr<ID3D12GraphicsCommandList2> commandList);
 
     // Fence
@@ -24,6 +27,9 @@ public:
     bool isFenceComplete(UINT64 value);
     void flush();
 
+    // GPU side wait, work executed here afterwards starts once other's fence reaches value
+    void waitForQueue(const CommandQueue& other, UINT64 value);
+
     // Getters
     ComPtr<ID3D12CommandQueue> getCommandQueue() const { return queue; }
     ComPtr<ID3D12Fence> getFence() const { return fence; }
@@ -31,6 +37,9 @@ public:
     HANDLE getFenceHandle() const { return fenceEvent; }
 
 private:
+    // An idle list reset onto allocator, or a new one
+    ComPtr<ID3D12GraphicsCommandList2> openCommandList(ComPtr<ID3D12CommandAllocator> allocator);
+
     struct AllocatorEntry {
         UINT64 fenceValue = 0;
         ComPtr<ID3D12CommandAllocator> allocator;
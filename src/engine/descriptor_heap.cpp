@@ -5,7 +5,9 @@ DescriptorHeap::DescriptorHeap(
     D3D12_DESCRIPTOR_HEAP_TYPE type, 
     UINT numDescriptors, 
     bool shaderVisible
-) : type(type)
+) : 
+    type(type),
+    capacity(numDescriptors)
 {
     D3D12_DESCRIPTOR_HEAP_DESC desc = {};
     desc.NumDescriptors = numDescriptors;
@@ -18,6 +20,25 @@ DescriptorHeap::DescriptorHeap(
     LOG_INFO(L"DescriptorHeap Initialized: type=%d, numDescriptors=%d", type, numDescriptors);
 }
 
+UINT DescriptorHeap::allocate() {
+    if (!freeIndices.empty()) {
+        UINT index = freeIndices.back();
+        freeIndices.pop_back();
+        return index;
+    }
+
+    if (nextIndex >= capacity) {
+        LOG_ERROR(L"DescriptorHeap -> Out of descriptors (%u)", capacity);
+        throw std::runtime_error("Descriptor heap is full");
+    }
+
+    return nextIndex++;
+}
+
+void DescriptorHeap::release(UINT index) {
+    freeIndices.push_back(index);
+}
+
 CD3DX12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::getCPUHandle(UINT index) const {
     CD3DX12_CPU_DESCRIPTOR_HANDLE handle(heap->GetCPUDescriptorHandleForHeapStart());
     handle.Offset(index, descriptorSize);
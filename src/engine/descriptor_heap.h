@@ -11,6 +11,15 @@ class DescriptorHeap {
             bool shaderVisible = false
         );
 
+        // Hands out free slots, reusing released ones first. Throws when the heap is full.
+        // Not thread safe, allocate from the thread that creates the views.
+        UINT allocate();
+        void release(UINT index);
+
+        UINT getAllocatedCount() const {
+            return nextIndex - static_cast<UINT>(freeIndices.size());
+        }
+
         CD3DX12_CPU_DESCRIPTOR_HANDLE getCPUHandle(UINT index) const;
         D3D12_GPU_DESCRIPTOR_HANDLE getGPUHandle(UINT index) const;
 
@@ -26,4 +35,8 @@ class DescriptorHeap {
         ComPtr<ID3D12DescriptorHeap> heap;
         UINT descriptorSize;
         D3D12_DESCRIPTOR_HEAP_TYPE type;
+
+        UINT capacity = 0;
+        UINT nextIndex = 0;
+        std::vector<UINT> freeIndices;
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "frame_scheduler.h"
+#include "command_queue.h"
+
+#include <algorithm>
+#include <chrono>
+
+FrameScheduler::FrameScheduler(
+    ComPtr<ID3D12Device2> device,
+    CommandQueue* queue,
+    UINT framesInFlight,
+    UINT64 constantBytes
+) :
+    queue(queue),
+    contexts(std::clamp(framesInFlight, 1u, FRAMEBUFFERCOUNT)),
+    constants(device, constantBytes, static_cast<UINT>(contexts.size()))
+{
+    for (Context& context : contexts) {
+        context.allocator = queue->createCommandAllocator();
+    }
+
+    LOG_INFO(L"FrameScheduler -> %zu frames in flight", contexts.size());
+}
+
+FrameScheduler::~FrameScheduler() {
+    queue->flush();
+}
+
+void FrameScheduler::beginFrame() {
+    current = (current + 1) % static_cast<UINT>(contexts.size());
+    Context& context = contexts[current];
+
+    // The only place the CPU waits for the GPU each frame
+    stats.lastWaitMs = 0.0;
+    if (!queue->isFenceComplete(context.fenceValue)) {
+        auto start = std::chrono::high_resolution_clock::now();
+        queue->fenceWait(context.fenceValue);
+        stats.lastWaitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        stats.waits++;
+    }
+    stats.totalWaitMs += stats.lastWaitMs;
+    stats.maxWaitMs = std::max(stats.maxWaitMs, stats.lastWaitMs);
+
+    throwFailed(context.allocator->Reset());
+    constants.beginFrame(queue->getFence()->GetCompletedValue());
+}
+
+ComPtr<ID3D12GraphicsCommandList2> FrameScheduler::getCommandList() {
+    return queue->getCommandList(contexts[current].allocator);
+}
+
+UINT64 FrameScheduler::endFrame(ComPtr<ID3D12GraphicsCommandList2> cmdList) {
+    UINT64 fenceValue = queue->executeCommandList(cmdList);
+
+    contexts[current].fenceValue = fenceValue;
+    constants.endFrame(fenceValue);
+    stats.frames++;
+    return fenceValue;
+}
+
+void FrameScheduler::logStats() const {
+    LOG_INFO(L"FrameScheduler -> %zu frames, %zu waited on the GPU: %.2f ms total, %.3f ms average, %.2f ms worst",
+        stats.frames, stats.waits, stats.totalWaitMs, stats.frames ? stats.totalWaitMs / stats.frames : 0.0, stats.maxWaitMs);
+    constants.logStats();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "engine/resources/constant_allocator.h"
+
+class CommandQueue;
+
+struct FrameSchedulerStats {
+    size_t frames = 0;
+    size_t waits = 0;          // frames that found their context still in flight
+    double lastWaitMs = 0.0;   // CPU time blocked in the latest beginFrame()
+    double totalWaitMs = 0.0;
+    double maxWaitMs = 0.0;
+};
+
+// State for the frames the GPU may still be working on: each context has its
+// own command allocator and region of constants.
+// beginFrame() reuses the oldest context, so the CPU only blocks once it is
+// framesInFlight frames ahead of the GPU.
+class FrameScheduler {
+    public:
+        // framesInFlight is clamped to 1..FRAMEBUFFERCOUNT, 1 keeps CPU and GPU in lockstep
+        FrameScheduler(
+            ComPtr<ID3D12Device2> device,
+            CommandQueue* queue,
+            UINT framesInFlight,
+            UINT64 constantBytes
+        );
+
+        // Waits for every frame in flight
+        ~FrameScheduler();
+
+        FrameScheduler(const FrameScheduler&) = delete;
+        FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+        // Waits until the next context's last frame is done, then resets it
+        void beginFrame();
+
+        // Open list on this frame's allocator
+        ComPtr<ID3D12GraphicsCommandList2> getCommandList();
+
+        // Executes the frame's list, its fence frees the context again
+        UINT64 endFrame(ComPtr<ID3D12GraphicsCommandList2> cmdList);
+
+        // 0..framesInFlight - 1, for per-frame resources kept elsewhere
+        UINT getFrameIndex() const {
+            return current;
+        }
+
+        UINT getFramesInFlight() const {
+            return static_cast<UINT>(contexts.size());
+        }
+
+        ConstantAllocator& getConstants() {
+            return constants;
+        }
+
+        const FrameSchedulerStats& getStats() const {
+            return stats;
+        }
+
+        void logStats() const;
+
+    private:
+        struct Context {
+            ComPtr<ID3D12CommandAllocator> allocator;
+            UINT64 fenceValue = 0;
+        };
+
+        CommandQueue* queue = nullptr;
+
+        std::vector<Context> contexts;
+        UINT current = 0;
+
+        ConstantAllocator constants;
+
+        FrameSchedulerStats stats;
+};
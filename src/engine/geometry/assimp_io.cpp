@@ -0,0 +1,86 @@
+#include "assimp_io.h"
+
+MappedIOStream::MappedIOStream(MappedFile&& file) :
+    file(std::move(file))
+{}
+
+size_t MappedIOStream::Read(void* buffer, size_t size, size_t count) {
+    if (size == 0 || count == 0)
+        return 0;
+
+    // Whole elements only, like fread
+    size_t available = (file.getSize() - cursor) / size;
+    size_t elements = std::min(count, available);
+
+    std::memcpy(buffer, file.getData() + cursor, elements * size);
+    cursor += elements * size;
+    return elements;
+}
+
+size_t MappedIOStream::Write(const void*, size_t, size_t) {
+    return 0;
+}
+
+aiReturn MappedIOStream::Seek(size_t offset, aiOrigin origin) {
+    size_t target = 0;
+    switch (origin) {
+        case aiOrigin_SET:
+            target = offset;
+            break;
+        case aiOrigin_CUR:
+            target = cursor + offset;
+            break;
+        case aiOrigin_END:
+            // Assimp passes the distance back from the end here
+            if (offset > file.getSize())
+                return aiReturn_FAILURE;
+            target = file.getSize() - offset;
+            break;
+        default:
+            return aiReturn_FAILURE;
+    }
+
+    if (target > file.getSize())
+        return aiReturn_FAILURE;
+
+    cursor = target;
+    return aiReturn_SUCCESS;
+}
+
+size_t MappedIOStream::Tell() const {
+    return cursor;
+}
+
+size_t MappedIOStream::FileSize() const {
+    return file.getSize();
+}
+
+void MappedIOStream::Flush() {}
+
+bool MappedIOSystem::Exists(const char* path) const {
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path, ec);
+}
+
+char MappedIOSystem::getOsSeparator() const {
+#ifdef _WIN32
+    return '\\';
+#else
+    return '/';
+#endif
+}
+
+Assimp::IOStream* MappedIOSystem::Open(const char* path, const char* mode) {
+    if (mode && (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+')))
+        return nullptr;
+
+    MappedFile file;
+    if (!file.open(path))
+        return nullptr;
+
+    return new MappedIOStream(std::move(file));
+}
+
+void MappedIOSystem::Close(Assimp::IOStream* stream) {
+    delete stream;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "utils/mapped_file.h"
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+// Assimp file access over MappedFile instead of buffered stdio.
+// Reads are a memcpy out of the mapping and seeks just move the cursor,
+// which is what the binary importers (.fbx, .3ds, .blend) do most of.
+// Read-only: opening with a write mode fails.
+
+class MappedIOStream : public Assimp::IOStream {
+    public:
+        explicit MappedIOStream(MappedFile&& file);
+        ~MappedIOStream() override = default;
+
+        size_t Read(void* buffer, size_t size, size_t count) override;
+        size_t Write(const void* buffer, size_t size, size_t count) override;
+        aiReturn Seek(size_t offset, aiOrigin origin) override;
+        size_t Tell() const override;
+        size_t FileSize() const override;
+        void Flush() override;
+
+    private:
+        MappedFile file;
+        size_t cursor = 0;
+};
+
+class MappedIOSystem : public Assimp::IOSystem {
+    public:
+        MappedIOSystem() = default;
+        ~MappedIOSystem() override = default;
+
+        bool Exists(const char* path) const override;
+        char getOsSeparator() const override;
+        Assimp::IOStream* Open(const char* path, const char* mode = "rb") override;
+        void Close(Assimp::IOStream* stream) override;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "utils/hash.h"
+#include "vertex_weld.h"
+#include "vertex_format.h"
+#include "meshlet.h"
+
+// Knobs for the CPU side of model import. Everything in here changes the
+// cooked output, so it all feeds the mesh cache key through hash(),
+// except vertexFormat, depthStream and textureAtlas which only apply when the
+// GPU resources are made.
+struct ImportSettings {
+    // .obj files go through loadObj() instead of Assimp
+    bool nativeObj = true;
+
+    bool weldVertices = true;
+    WeldSettings weld;
+
+    // Vertex cache + overdraw + vertex fetch ordering, see mesh_optimizer.h
+    bool optimizeMeshes = true;
+    float overdrawThreshold = 1.05f;
+
+    // Meshlets for cluster culling, built last on the final index order
+    bool buildMeshlets = true;
+    uint32_t meshletMaxVertices = MESHLET_MAX_VERTICES;
+    uint32_t meshletMaxTriangles = MESHLET_MAX_TRIANGLES;
+
+    // LOD chain, LOD 0 included. Each level aims for lodReduction of the previous
+    // triangle count and stops early once the error would pass lodMaxError
+    // (fraction of the mesh bounding radius) or simplification stalls.
+    uint32_t lodCount = 4;
+    float lodReduction = 0.5f;
+    float lodMaxError = 0.05f;
+
+    // GPU vertex layout, the pipeline drawing the model must use the matching input layout
+    VertexFormat vertexFormat = VertexFormat::Full;
+
+    // Extra position-only welded stream per mesh for depth/shadow passes (Mesh::drawDepth)
+    bool depthStream = false;
+
+    // Small diffuse textures share atlases (TextureCache::getAtlas), UVs of their
+    // meshes are remapped when the buffers are made. Only meshes with UVs in [0, 1].
+    bool textureAtlas = true;
+
+    uint64_t hash() const {
+        uint64_t h = hashBytes(&nativeObj, sizeof(nativeObj));
+        h = hashCombine(h, hashBytes(&weldVertices, sizeof(weldVertices)));
+        h = hashCombine(h, hashBytes(&weld.positionEpsilon, sizeof(float)));
+        h = hashCombine(h, hashBytes(&weld.normalEpsilon, sizeof(float)));
+        h = hashCombine(h, hashBytes(&weld.uvEpsilon, sizeof(float)));
+        h = hashCombine(h, hashBytes(&weld.removeDegenerates, sizeof(bool)));
+        h = hashCombine(h, hashBytes(&optimizeMeshes, sizeof(bool)));
+        h = hashCombine(h, hashBytes(&overdrawThreshold, sizeof(float)));
+        h = hashCombine(h, hashBytes(&buildMeshlets, sizeof(bool)));
+        h = hashCombine(h, hashBytes(&meshletMaxVertices, sizeof(uint32_t)));
+        h = hashCombine(h, hashBytes(&meshletMaxTriangles, sizeof(uint32_t)));
+        h = hashCombine(h, hashBytes(&lodCount, sizeof(uint32_t)));
+        h = hashCombine(h, hashBytes(&lodReduction, sizeof(float)));
+        h = hashCombine(h, hashBytes(&lodMaxError, sizeof(float)));
+        return h;
+    }
+};
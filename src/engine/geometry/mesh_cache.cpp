@@ -0,0 +1,347 @@
+#include "mesh_cache.h"
+#include "utils/hash.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool rangeFits(uint64_t offset, uint64_t bytes, uint64_t fileSize) {
+        return offset <= fileSize && bytes <= fileSize - offset;
+    }
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Libraries an OBJ names on its mtllib lines, the rest of the line trimmed
+    // the same way the loader reads it
+    std::vector<std::string> findMaterialLibraries(const char* p, const char* end) {
+        static constexpr std::string_view KEYWORD = "mtllib";
+
+        std::vector<std::string> libraries;
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!lineEnd)
+                lineEnd = end;
+
+            while (p < lineEnd && isBlank(*p))
+                ++p;
+
+            if (static_cast<size_t>(lineEnd - p) > KEYWORD.size() && std::string_view(p, KEYWORD.size()) == KEYWORD && isBlank(p[KEYWORD.size()])) {
+                const char* name = p + KEYWORD.size();
+                const char* nameEnd = lineEnd;
+                while (name < nameEnd && isBlank(*name))
+                    ++name;
+                while (nameEnd > name && isBlank(nameEnd[-1]))
+                    --nameEnd;
+                if (name < nameEnd)
+                    libraries.emplace_back(name, nameEnd);
+            }
+
+            p = lineEnd + 1;
+        }
+        return libraries;
+    }
+}
+
+MeshCache::Key MeshCache::makeKey(const std::string& sourcePath, uint32_t importFlags, uint64_t settingsHash) {
+    MappedFile source;
+    if (!source.open(sourcePath)) {
+        LOG_ERROR(L"MeshCache -> Failed to open source model: %hs", sourcePath.c_str());
+        throw std::runtime_error("Failed to open source model");
+    }
+
+    Key key;
+    key.sourceHash = hashBytes(source.getData(), source.getSize());
+    key.sourceSize = source.getSize();
+
+    // Materials come from the .mtl files an OBJ names, so editing one has to
+    // make the cache stale too. A missing library hashes as empty.
+    fs::path sourceFile(sourcePath);
+    std::string extension = sourceFile.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == ".obj") {
+        const char* data = reinterpret_cast<const char*>(source.getData());
+        for (const std::string& library : findMaterialLibraries(data, data + source.getSize())) {
+            MappedFile file;
+            const uint64_t libraryHash = file.open((sourceFile.parent_path() / library).string()) ? hashBytes(file.getData(), file.getSize()) : 0;
+            key.sourceHash = hashCombine(key.sourceHash, libraryHash);
+        }
+    }
+
+    key.importFlags = importFlags;
+    key.settingsHash = settingsHash;
+    return key;
+}
+
+std::string MeshCache::getCachePath(const std::string& sourcePath) {
+    std::string name = fs::path(sourcePath).lexically_normal().generic_string();
+    for (char& c : name) {
+        if (c == '/' || c == '\\' || c == ':' || c == ' ')
+            c = '_';
+    }
+    return (fs::path("cache") / (name + ".meshcache")).string();
+}
+
+bool MeshCache::open(const std::string& cachePath, const Key& key) {
+    meshes.clear();
+
+    if (!file.open(cachePath)) {
+        LOG_INFO(L"MeshCache -> No cache at %hs", cachePath.c_str());
+        return false;
+    }
+
+    const uint8_t* base = file.getData();
+    const uint64_t fileSize = file.getSize();
+
+    if (fileSize < sizeof(Header)) {
+        LOG_WARNING(L"MeshCache -> Truncated cache %hs", cachePath.c_str());
+        file.close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, base, sizeof(Header));
+
+    if (header.magic != MAGIC || header.version != VERSION) {
+        LOG_INFO(L"MeshCache -> Cache version mismatch (found %u, want %u), rebuilding", header.version, VERSION);
+        file.close();
+        return false;
+    }
+
+    if (header.sourceHash != key.sourceHash ||
+        header.sourceSize != key.sourceSize ||
+        header.importFlags != key.importFlags ||
+        header.settingsHash != key.settingsHash) {
+        LOG_INFO(L"MeshCache -> Cache is stale for %hs", cachePath.c_str());
+        file.close();
+        return false;
+    }
+
+    const uint64_t recordsBytes = static_cast<uint64_t>(header.meshCount) * sizeof(MeshRecord);
+    if (!rangeFits(sizeof(Header), recordsBytes, fileSize) ||
+        !rangeFits(header.stringTableOffset, header.stringTableSize, fileSize)) {
+        LOG_WARNING(L"MeshCache -> Corrupt cache %hs", cachePath.c_str());
+        file.close();
+        return false;
+    }
+
+    const char* strings = reinterpret_cast<const char*>(base + header.stringTableOffset);
+    auto readString = [&](uint32_t offset, uint32_t length, std::string_view& out) {
+        if (!rangeFits(offset, length, header.stringTableSize))
+            return false;
+        out = std::string_view(strings + offset, length);
+        return true;
+    };
+
+    meshes.reserve(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; ++i) {
+        MeshRecord record;
+        std::memcpy(&record, base + sizeof(Header) + i * sizeof(MeshRecord), sizeof(MeshRecord));
+
+        const uint64_t vertexBytes = static_cast<uint64_t>(record.vertexCount) * sizeof(VertexStruct);
+        const uint64_t indexBytes = static_cast<uint64_t>(record.indexCount) * sizeof(uint32_t);
+        const uint64_t meshletBytes = static_cast<uint64_t>(record.meshletCount) * sizeof(Meshlet);
+        const uint64_t meshletVertexBytes = static_cast<uint64_t>(record.meshletVertexCount) * sizeof(uint32_t);
+        const uint64_t lodBytes = static_cast<uint64_t>(record.lodCount) * sizeof(MeshLod);
+
+        MeshView view;
+        bool valid =
+            rangeFits(record.vertexOffset, vertexBytes, fileSize) &&
+            rangeFits(record.indexOffset, indexBytes, fileSize) &&
+            rangeFits(record.meshletOffset, meshletBytes, fileSize) &&
+            rangeFits(record.meshletVertexOffset, meshletVertexBytes, fileSize) &&
+            rangeFits(record.meshletTriangleOffset, record.meshletTriangleBytes, fileSize) &&
+            rangeFits(record.lodOffset, lodBytes, fileSize) &&
+            record.vertexOffset % BLOB_ALIGNMENT == 0 &&
+            record.indexOffset % BLOB_ALIGNMENT == 0 &&
+            record.meshletOffset % BLOB_ALIGNMENT == 0 &&
+            record.meshletVertexOffset % BLOB_ALIGNMENT == 0 &&
+            record.lodOffset % BLOB_ALIGNMENT == 0 &&
+            readString(record.nameOffset, record.nameLength, view.name) &&
+            readString(record.diffuseOffset, record.diffuseLength, view.diffuseTexture);
+
+        if (!valid) {
+            LOG_WARNING(L"MeshCache -> Corrupt mesh record %u in %hs", i, cachePath.c_str());
+            meshes.clear();
+            file.close();
+            return false;
+        }
+
+        view.vertices = std::span<const VertexStruct>(
+            reinterpret_cast<const VertexStruct*>(base + record.vertexOffset),
+            record.vertexCount
+        );
+        view.indices = std::span<const uint32_t>(
+            reinterpret_cast<const uint32_t*>(base + record.indexOffset),
+            record.indexCount
+        );
+        view.meshlets = std::span<const Meshlet>(
+            reinterpret_cast<const Meshlet*>(base + record.meshletOffset),
+            record.meshletCount
+        );
+        view.meshletVertices = std::span<const uint32_t>(
+            reinterpret_cast<const uint32_t*>(base + record.meshletVertexOffset),
+            record.meshletVertexCount
+        );
+        view.meshletTriangles = std::span<const uint8_t>(
+            base + record.meshletTriangleOffset,
+            record.meshletTriangleBytes
+        );
+        view.lods = std::span<const MeshLod>(
+            reinterpret_cast<const MeshLod*>(base + record.lodOffset),
+            record.lodCount
+        );
+        // Culling and LOD selection read index ranges straight from these, so they must stay in bounds
+        bool rangesValid = true;
+        for (const Meshlet& meshlet : view.meshlets) {
+            rangesValid &= static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount <= record.indexCount / 3;
+        }
+        for (const MeshLod& lod : view.lods) {
+            rangesValid &= static_cast<uint64_t>(lod.indexOffset) + lod.indexCount <= record.indexCount;
+        }
+
+        if (!rangesValid) {
+            LOG_WARNING(L"MeshCache -> Corrupt meshlet/LOD ranges in record %u of %hs", i, cachePath.c_str());
+            meshes.clear();
+            file.close();
+            return false;
+        }
+
+        view.boundsMin = { record.boundsMin[0], record.boundsMin[1], record.boundsMin[2] };
+        view.boundsMax = { record.boundsMax[0], record.boundsMax[1], record.boundsMax[2] };
+        view.materialIndex = record.materialIndex;
+
+        meshes.push_back(view);
+    }
+
+    LOG_INFO(L"MeshCache -> Opened %hs (%u meshes, %llu bytes)", cachePath.c_str(), header.meshCount, fileSize);
+    return true;
+}
+
+void MeshCache::close() {
+    meshes.clear();
+    file.close();
+}
+
+bool MeshCache::write(const std::string& cachePath, const Key& key, const std::vector<MeshData>& meshes) {
+    // Lay out string table and blobs first so the file can be written front to back
+    std::string stringTable;
+    std::vector<MeshRecord> records(meshes.size());
+
+    auto addString = [&](const std::string& s, uint32_t& offset, uint32_t& length) {
+        offset = static_cast<uint32_t>(stringTable.size());
+        length = static_cast<uint32_t>(s.size());
+        stringTable += s;
+    };
+
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const MeshData& mesh = meshes[i];
+        MeshRecord& record = records[i];
+        record = {};
+
+        record.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        record.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        record.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+        record.meshletVertexCount = static_cast<uint32_t>(mesh.meshletVertices.size());
+        record.meshletTriangleBytes = static_cast<uint32_t>(mesh.meshletTriangles.size());
+        record.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        record.boundsMin[0] = mesh.boundsMin.x;
+        record.boundsMin[1] = mesh.boundsMin.y;
+        record.boundsMin[2] = mesh.boundsMin.z;
+        record.boundsMax[0] = mesh.boundsMax.x;
+        record.boundsMax[1] = mesh.boundsMax.y;
+        record.boundsMax[2] = mesh.boundsMax.z;
+        record.materialIndex = mesh.materialIndex;
+
+        addString(mesh.name, record.nameOffset, record.nameLength);
+        addString(mesh.diffuseTexture, record.diffuseOffset, record.diffuseLength);
+    }
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.sourceHash = key.sourceHash;
+    header.sourceSize = key.sourceSize;
+    header.importFlags = key.importFlags;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.settingsHash = key.settingsHash;
+    header.stringTableOffset = sizeof(Header) + records.size() * sizeof(MeshRecord);
+    header.stringTableSize = stringTable.size();
+
+    uint64_t cursor = alignUp(header.stringTableOffset + header.stringTableSize, BLOB_ALIGNMENT);
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        records[i].vertexOffset = cursor;
+        cursor = alignUp(cursor + meshes[i].vertices.size() * sizeof(VertexStruct), BLOB_ALIGNMENT);
+        records[i].indexOffset = cursor;
+        cursor = alignUp(cursor + meshes[i].indices.size() * sizeof(uint32_t), BLOB_ALIGNMENT);
+        records[i].meshletOffset = cursor;
+        cursor = alignUp(cursor + meshes[i].meshlets.size() * sizeof(Meshlet), BLOB_ALIGNMENT);
+        records[i].meshletVertexOffset = cursor;
+        cursor = alignUp(cursor + meshes[i].meshletVertices.size() * sizeof(uint32_t), BLOB_ALIGNMENT);
+        records[i].meshletTriangleOffset = cursor;
+        cursor = alignUp(cursor + meshes[i].meshletTriangles.size(), BLOB_ALIGNMENT);
+        records[i].lodOffset = cursor;
+        cursor = alignUp(cursor + meshes[i].lods.size() * sizeof(MeshLod), BLOB_ALIGNMENT);
+    }
+
+    std::error_code ec;
+    fs::create_directories(fs::path(cachePath).parent_path(), ec);
+
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            LOG_WARNING(L"MeshCache -> Can't create %hs", tempPath.c_str());
+            return false;
+        }
+
+        static const char zeros[BLOB_ALIGNMENT] = {};
+        auto padTo = [&](uint64_t offset) {
+            uint64_t pos = static_cast<uint64_t>(out.tellp());
+            out.write(zeros, static_cast<std::streamsize>(offset - pos));
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(MeshRecord));
+        out.write(stringTable.data(), stringTable.size());
+
+        auto writeBlob = [&](uint64_t offset, const void* data, size_t bytes) {
+            padTo(offset);
+            out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        };
+
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const MeshData& mesh = meshes[i];
+            writeBlob(records[i].vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(VertexStruct));
+            writeBlob(records[i].indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+            writeBlob(records[i].meshletOffset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+            writeBlob(records[i].meshletVertexOffset, mesh.meshletVertices.data(), mesh.meshletVertices.size() * sizeof(uint32_t));
+            writeBlob(records[i].meshletTriangleOffset, mesh.meshletTriangles.data(), mesh.meshletTriangles.size());
+            writeBlob(records[i].lodOffset, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+        }
+        padTo(cursor);
+
+        if (!out) {
+            LOG_WARNING(L"MeshCache -> Write failed for %hs", tempPath.c_str());
+            out.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    fs::rename(tempPath, cachePath, ec);
+    if (ec) {
+        LOG_WARNING(L"MeshCache -> Can't replace %hs: %hs", cachePath.c_str(), ec.message().c_str());
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    LOG_INFO(L"MeshCache -> Wrote %hs (%zu meshes, %llu bytes)", cachePath.c_str(), meshes.size(), cursor);
+    return true;
+}
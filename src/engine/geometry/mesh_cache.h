@@ -0,0 +1,92 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "utils/mapped_file.h"
+#include "mesh_data.h"
+
+// Cooked binary copy of an imported model.
+//
+// Layout: header | mesh records | string table | vertex/index/meshlet/LOD blobs.
+// Blobs are 16-byte aligned and stored exactly as uploaded, so a warm start
+// maps the file and memcpy's straight from the mapping into upload memory.
+// The cache is keyed by the source file hash + size (with an OBJ's mtllib
+// files folded into the hash), the Assimp flags and the ImportSettings hash;
+// any mismatch (or a version bump) makes it stale.
+class MeshCache {
+    public:
+        static constexpr uint32_t MAGIC = 0x434D5844; // 'DXMC'
+        static constexpr uint32_t VERSION = 5;
+
+        struct Key {
+            uint64_t sourceHash = 0;
+            uint64_t sourceSize = 0;
+            uint32_t importFlags = 0;
+            uint64_t settingsHash = 0;
+        };
+
+        MeshCache() = default;
+        ~MeshCache() = default;
+
+        // Hashes the source model file and an OBJ's material libraries. Throws if the source can't be read.
+        static Key makeKey(const std::string& sourcePath, uint32_t importFlags, uint64_t settingsHash);
+
+        // cache/<sanitized source path>.meshcache
+        static std::string getCachePath(const std::string& sourcePath);
+
+        // Maps the cache file. Returns false if it is missing, stale or malformed.
+        bool open(const std::string& cachePath, const Key& key);
+
+        // Writes a fresh cache file. Returns false (and leaves no partial file) on failure.
+        static bool write(const std::string& cachePath, const Key& key, const std::vector<MeshData>& meshes);
+
+        // Unmaps the file, every view from getMeshes() dangles afterwards
+        void close();
+
+        // Views point into the mapping and stay valid while this object is alive
+        const std::vector<MeshView>& getMeshes() const {
+            return meshes;
+        }
+
+    private:
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;
+            uint64_t sourceSize;
+            uint32_t importFlags;
+            uint32_t meshCount;
+            uint64_t settingsHash;
+            uint64_t reserved;
+            uint64_t stringTableOffset;
+            uint64_t stringTableSize;
+        };
+
+        struct MeshRecord {
+            uint64_t vertexOffset;
+            uint64_t indexOffset;
+            uint64_t meshletOffset;
+            uint64_t meshletVertexOffset;
+            uint64_t meshletTriangleOffset;
+            uint64_t lodOffset;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t meshletCount;
+            uint32_t meshletVertexCount;
+            uint32_t meshletTriangleBytes;
+            uint32_t lodCount;
+            float boundsMin[3];
+            float boundsMax[3];
+            uint32_t materialIndex;
+            uint32_t nameOffset;
+            uint32_t nameLength;
+            uint32_t diffuseOffset;
+            uint32_t diffuseLength;
+            uint32_t reserved;
+        };
+
+        static_assert(sizeof(Header) % 16 == 0, "MeshCache header must keep blobs aligned");
+        static_assert(sizeof(MeshRecord) % 8 == 0, "MeshCache record must stay 8-byte aligned");
+
+        MappedFile file;
+        std::vector<MeshView> meshes;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "meshlet.h"
+#include "mesh_simplifier.h"
+
+#include <cfloat>
+#include <span>
+#include <string_view>
+
+// Read-only view of one mesh ready for upload.
+// Points either into a MeshData or straight into a mapped cache file.
+struct MeshView {
+    std::string_view name;
+    std::span<const VertexStruct> vertices;
+    std::span<const uint32_t> indices;  // every LOD back to back, LOD 0 first
+    XMFLOAT3 boundsMin;
+    XMFLOAT3 boundsMax;
+    uint32_t materialIndex = 0;
+    std::string_view diffuseTexture; // as named by the material, relative to the model
+
+    // Empty when meshlets are disabled
+    std::span<const Meshlet> meshlets;
+    std::span<const uint32_t> meshletVertices;
+    std::span<const uint8_t> meshletTriangles;
+
+    // Ranges of indices, empty when LODs are disabled (then all of indices is LOD 0)
+    std::span<const MeshLod> lods;
+};
+
+// CPU side result of importing one mesh
+struct MeshData {
+    std::string name;
+    std::vector<VertexStruct> vertices;
+    std::vector<uint32_t> indices;
+    XMFLOAT3 boundsMin = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    XMFLOAT3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    uint32_t materialIndex = 0;
+    std::string diffuseTexture;
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+
+    std::vector<MeshLod> lods;
+
+    MeshView view() const {
+        MeshView v;
+        v.name = name;
+        v.vertices = vertices;
+        v.indices = indices;
+        v.boundsMin = boundsMin;
+        v.boundsMax = boundsMax;
+        v.materialIndex = materialIndex;
+        v.diffuseTexture = diffuseTexture;
+        v.meshlets = meshlets;
+        v.meshletVertices = meshletVertices;
+        v.meshletTriangles = meshletTriangles;
+        v.lods = lods;
+        return v;
+    }
+};
@@ -0,0 +1,437 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+    // ---- FIFO cache simulation, shared by the analyzer and the overdraw pass ----
+
+    class FifoCache {
+        public:
+            FifoCache(size_t vertexCount, uint32_t cacheSize) :
+                timestamps(vertexCount, 0),
+                cacheSize(cacheSize),
+                timestamp(cacheSize + 1)
+            {}
+
+            // Returns 1 on a miss
+            uint32_t touch(uint32_t vertex) {
+                if (timestamp - timestamps[vertex] > cacheSize) {
+                    timestamps[vertex] = timestamp++;
+                    return 1;
+                }
+                return 0;
+            }
+
+            uint32_t touchTriangle(const uint32_t* tri) {
+                return touch(tri[0]) + touch(tri[1]) + touch(tri[2]);
+            }
+
+            // Pushes every cached vertex out
+            void clear() {
+                timestamp += cacheSize + 1;
+            }
+
+        private:
+            std::vector<uint32_t> timestamps;
+            uint32_t cacheSize;
+            uint32_t timestamp;
+    };
+
+    // ---- Forsyth scoring ----
+
+    constexpr int FORSYTH_CACHE_SIZE = 32;
+    constexpr int FORSYTH_MAX_VALENCE = 32;
+
+    struct ForsythTables {
+        float cache[FORSYTH_CACHE_SIZE + 3];
+        float valence[FORSYTH_MAX_VALENCE + 1];
+
+        ForsythTables() {
+            constexpr float decayPower = 1.5f;
+            constexpr float lastTriScore = 0.75f;
+            constexpr float valenceBoostScale = 2.0f;
+            constexpr float valenceBoostPower = 0.5f;
+
+            for (int i = 0; i < FORSYTH_CACHE_SIZE + 3; ++i) {
+                if (i < 3) {
+                    // the three vertices of the last triangle get a fixed score so we don't
+                    // always pick the triangle that shares an edge with it
+                    cache[i] = lastTriScore;
+                } else if (i < FORSYTH_CACHE_SIZE) {
+                    float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                    cache[i] = std::pow(1.0f - (i - 3) * scaler, decayPower);
+                } else {
+                    cache[i] = 0.0f;
+                }
+            }
+
+            valence[0] = 0.0f;
+            for (int i = 1; i <= FORSYTH_MAX_VALENCE; ++i) {
+                valence[i] = valenceBoostScale * std::pow(static_cast<float>(i), -valenceBoostPower);
+            }
+        }
+
+        float score(int cachePosition, uint32_t remaining) const {
+            if (remaining == 0)
+                return -1.0f; // no triangles left, never worth picking
+
+            float s = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+            return s + valence[std::min<uint32_t>(remaining, FORSYTH_MAX_VALENCE)];
+        }
+    };
+
+    const ForsythTables& forsythTables() {
+        static const ForsythTables tables;
+        return tables;
+    }
+
+    struct Vec3 {
+        float x, y, z;
+    };
+
+    Vec3 loadPosition(const float* positions, size_t stride, uint32_t index) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + stride * index);
+        return { p[0], p[1], p[2] };
+    }
+}
+
+VertexCacheStats analyzeVertexCache(
+    std::span<const uint32_t> indices,
+    size_t vertexCount,
+    uint32_t cacheSize
+) {
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+
+    if (stats.triangles == 0 || vertexCount == 0)
+        return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        stats.misses += cache.touchTriangle(&indices[i]);
+        referenced[indices[i + 0]] = 1;
+        referenced[indices[i + 1]] = 1;
+        referenced[indices[i + 2]] = 1;
+    }
+
+    stats.vertices = std::count(referenced.begin(), referenced.end(), uint8_t(1));
+    stats.acmr = static_cast<float>(stats.misses) / stats.triangles;
+    stats.atvr = stats.vertices ? static_cast<float>(stats.misses) / stats.vertices : 0.0f;
+    return stats;
+}
+
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0)
+        return;
+
+    const ForsythTables& tables = forsythTables();
+
+    // Vertex -> triangle adjacency (CSR), with a live count we shrink as triangles get emitted
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        liveTriangles[indices[i]]++;
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = tables.score(-1, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+
+    size_t bestTriangle = SIZE_MAX;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<uint32_t> source(indices.begin(), indices.begin() + triangleCount * 3);
+
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t nextCache[FORSYTH_CACHE_SIZE + 3];
+    int cacheCount = 0;
+
+    size_t cursor = 0; // fallback scan position when the cache has no live neighbours
+
+    for (size_t out = 0; out < triangleCount; ++out) {
+        if (bestTriangle == SIZE_MAX) {
+            while (emitted[cursor])
+                ++cursor;
+            bestTriangle = cursor;
+        }
+
+        const uint32_t* tri = &source[bestTriangle * 3];
+        indices[out * 3 + 0] = tri[0];
+        indices[out * 3 + 1] = tri[1];
+        indices[out * 3 + 2] = tri[2];
+        emitted[bestTriangle] = 1;
+
+        // Drop the triangle from its vertices' live lists
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            uint32_t* begin = &adjacency[offsets[v]];
+            uint32_t* end = begin + liveTriangles[v];
+            uint32_t* it = std::find(begin, end, static_cast<uint32_t>(bestTriangle));
+            if (it != end) {
+                std::swap(*it, *(end - 1));
+                liveTriangles[v]--;
+            }
+        }
+
+        // New cache: emitted triangle at the front, then the old contents minus those three
+        int nextCount = 0;
+        nextCache[nextCount++] = tri[0];
+        nextCache[nextCount++] = tri[1];
+        nextCache[nextCount++] = tri[2];
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                nextCache[nextCount++] = v;
+        }
+
+        // Rescore everything that was touched; vertices past the cache size fall out
+        for (int i = 0; i < nextCount; ++i) {
+            uint32_t v = nextCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+            vertexScore[v] = tables.score(cachePosition[v], liveTriangles[v]);
+        }
+
+        bestTriangle = SIZE_MAX;
+        bestScore = -1.0f;
+        for (int i = 0; i < nextCount; ++i) {
+            uint32_t v = nextCache[i];
+            for (uint32_t a = 0; a < liveTriangles[v]; ++a) {
+                uint32_t t = adjacency[offsets[v] + a];
+                float score =
+                    vertexScore[source[t * 3 + 0]] +
+                    vertexScore[source[t * 3 + 1]] +
+                    vertexScore[source[t * 3 + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(nextCount, FORSYTH_CACHE_SIZE);
+        std::copy(nextCache, nextCache + cacheCount, cache);
+    }
+}
+
+void optimizeOverdraw(
+    std::span<uint32_t> indices,
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    float threshold,
+    uint32_t cacheSize
+) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0)
+        return;
+
+    // 1. Hard boundaries: points where the cache was effectively flushed (3 misses)
+    std::vector<size_t> hardClusters;
+    {
+        FifoCache cache(vertexCount, cacheSize);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (cache.touchTriangle(&indices[t * 3]) == 3 || t == 0)
+                hardClusters.push_back(t);
+        }
+    }
+
+    // 2. Soft boundaries: split hard clusters wherever the running ACMR is already
+    //    within threshold of the whole cluster's, so sorting costs little cache efficiency
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertexCount, cacheSize);
+        for (size_t c = 0; c < hardClusters.size(); ++c) {
+            size_t start = hardClusters[c];
+            size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+
+            cache.clear();
+            size_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t) {
+                clusterMisses += cache.touchTriangle(&indices[t * 3]);
+            }
+            float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+            cache.clear();
+            clusters.push_back(start);
+            size_t runningMisses = 0;
+            size_t runningSize = 0;
+            for (size_t t = start; t < end; ++t) {
+                runningMisses += cache.touchTriangle(&indices[t * 3]);
+                runningSize++;
+
+                if (t + 1 < end && static_cast<float>(runningMisses) <= clusterThreshold * runningSize) {
+                    clusters.push_back(t + 1);
+                    cache.clear();
+                    runningMisses = 0;
+                    runningSize = 0;
+                }
+            }
+        }
+    }
+
+    // 3. Sort clusters by how far their area-weighted centroid sits along their
+    //    average normal, measured from the mesh centroid -> outer shells first
+    Vec3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        Vec3 p = loadPosition(positions, positionStride, indices[i]);
+        meshCentroid.x += p.x;
+        meshCentroid.y += p.y;
+        meshCentroid.z += p.z;
+    }
+    float inv = 1.0f / static_cast<float>(triangleCount * 3);
+    meshCentroid = { meshCentroid.x * inv, meshCentroid.y * inv, meshCentroid.z * inv };
+
+    const size_t clusterCount = clusters.size();
+    std::vector<float> sortKey(clusterCount);
+
+    for (size_t c = 0; c < clusterCount; ++c) {
+        size_t start = clusters[c];
+        size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+
+        Vec3 centroid = { 0.0f, 0.0f, 0.0f };
+        Vec3 normal = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+
+        for (size_t t = start; t < end; ++t) {
+            Vec3 a = loadPosition(positions, positionStride, indices[t * 3 + 0]);
+            Vec3 b = loadPosition(positions, positionStride, indices[t * 3 + 1]);
+            Vec3 c2 = loadPosition(positions, positionStride, indices[t * 3 + 2]);
+
+            Vec3 e1 = { b.x - a.x, b.y - a.y, b.z - a.z };
+            Vec3 e2 = { c2.x - a.x, c2.y - a.y, c2.z - a.z };
+            Vec3 n = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+            float w = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            centroid.x += (a.x + b.x + c2.x) * (w / 3.0f);
+            centroid.y += (a.y + b.y + c2.y) * (w / 3.0f);
+            centroid.z += (a.z + b.z + c2.z) * (w / 3.0f);
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += w;
+        }
+
+        if (area > 0.0f) {
+            centroid = { centroid.x / area, centroid.y / area, centroid.z / area };
+        }
+
+        float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if (length > 0.0f) {
+            normal = { normal.x / length, normal.y / length, normal.z / length };
+        }
+
+        sortKey[c] =
+            (centroid.x - meshCentroid.x) * normal.x +
+            (centroid.y - meshCentroid.y) * normal.y +
+            (centroid.z - meshCentroid.z) * normal.z;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sortKey[a] > sortKey[b];
+    });
+
+    std::vector<uint32_t> source(indices.begin(), indices.begin() + triangleCount * 3);
+    size_t write = 0;
+    for (size_t c : order) {
+        size_t start = clusters[c];
+        size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+        std::copy(source.begin() + start * 3, source.begin() + end * 3, indices.begin() + write);
+        write += (end - start) * 3;
+    }
+}
+
+size_t optimizeVertexFetchRemap(
+    std::span<uint32_t> indices,
+    size_t vertexCount,
+    std::vector<uint32_t>& remap
+) {
+    remap.assign(vertexCount, UINT32_MAX);
+
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == UINT32_MAX)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    return next;
+}
+
+size_t generatePositionRemap(
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    std::vector<uint32_t>& remap
+) {
+    struct PositionKey {
+        uint32_t bits[3];
+
+        bool operator==(const PositionKey& other) const {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+        }
+    };
+
+    struct PositionHash {
+        size_t operator()(const PositionKey& key) const {
+            uint64_t h = key.bits[0] * 0x9E3779B97F4A7C15ull;
+            h ^= (h >> 29) ^ (key.bits[1] * 0xC2B2AE3D27D4EB4Full);
+            h ^= (h >> 31) ^ (key.bits[2] * 0x165667B19E3779F9ull);
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+    };
+
+    remap.resize(vertexCount);
+
+    std::unordered_map<PositionKey, uint32_t, PositionHash> unique;
+    unique.reserve(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        Vec3 p = loadPosition(positions, positionStride, static_cast<uint32_t>(i));
+
+        // fold -0 into +0 so they weld
+        PositionKey key;
+        float values[3] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+        std::memcpy(key.bits, values, sizeof(values));
+
+        auto [it, inserted] = unique.try_emplace(key, static_cast<uint32_t>(unique.size()));
+        remap[i] = it->second;
+    }
+
+    return unique.size();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Index/vertex order optimizations for triangle lists. Pure C++ on raw
+// index and position arrays so the offline tools can run them too.
+//
+// Run order matters: vertex cache -> overdraw -> vertex fetch.
+
+struct VertexCacheStats {
+    size_t triangles = 0;
+    size_t vertices = 0;     // distinct vertices referenced
+    size_t misses = 0;
+    float acmr = 0.0f;       // average cache miss ratio, misses per triangle (0.5 .. 3)
+    float atvr = 0.0f;       // average transformed vertex ratio, misses per vertex (1 is ideal)
+};
+
+// Simulates a FIFO post-transform cache over the index list
+VertexCacheStats analyzeVertexCache(
+    std::span<const uint32_t> indices,
+    size_t vertexCount,
+    uint32_t cacheSize = 16
+);
+
+// Forsyth's linear-speed vertex cache optimization, in place
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+
+// View-independent overdraw ordering (Sander/Nehab/Barczak "Tipsify" style).
+// Splits the cache-optimized list into clusters at cache boundaries, then sorts
+// clusters so outward-facing ones draw first. threshold lets ACMR grow by that
+// factor in exchange for finer clusters (1.05 = 5%).
+void optimizeOverdraw(
+    std::span<uint32_t> indices,
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    float threshold = 1.05f,
+    uint32_t cacheSize = 16
+);
+
+// Builds an old -> new vertex remap in first-use order and rewrites the
+// indices with it. Unreferenced vertices map to UINT32_MAX.
+// Returns the number of vertices that are still referenced.
+size_t optimizeVertexFetchRemap(
+    std::span<uint32_t> indices,
+    size_t vertexCount,
+    std::vector<uint32_t>& remap
+);
+
+// Maps every vertex to the first one with the same position (bitwise, -0 == 0),
+// compacted in first-seen order. For depth-only streams where normal/UV seams
+// don't matter. Returns the number of unique positions.
+size_t generatePositionRemap(
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    std::vector<uint32_t>& remap
+);
+
+// Applies a remap produced by optimizeVertexFetchRemap to a vertex array
+template<typename Vertex>
+void remapVertexBuffer(std::vector<Vertex>& vertices, std::span<const uint32_t> remap, size_t newCount) {
+    std::vector<Vertex> result(newCount);
+    for (size_t i = 0; i < remap.size(); ++i) {
+        if (remap[i] != UINT32_MAX)
+            result[remap[i]] = vertices[i];
+    }
+    vertices.swap(result);
+}
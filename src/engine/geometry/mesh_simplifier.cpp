@@ -0,0 +1,303 @@
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+    struct Vec3 {
+        double x, y, z;
+    };
+
+    Vec3 loadPosition(const float* positions, size_t stride, uint32_t index) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + stride * index);
+        return { p[0], p[1], p[2] };
+    }
+
+    Vec3 sub(const Vec3& a, const Vec3& b) {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    Vec3 cross(const Vec3& a, const Vec3& b) {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    double dot(const Vec3& a, const Vec3& b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // Symmetric 4x4 plane quadric, 10 unique terms, plus the summed weight so
+    // evaluate() is a mean squared distance instead of growing with area
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double weight = 0;
+
+        void addPlane(double a, double b, double c, double d, double weight) {
+            a2 += a * a * weight; ab += a * b * weight; ac += a * c * weight; ad += a * d * weight;
+            b2 += b * b * weight; bc += b * c * weight; bd += b * d * weight;
+            c2 += c * c * weight; cd += c * d * weight;
+            d2 += d * d * weight;
+            this->weight += weight;
+        }
+
+        void add(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+            weight += q.weight;
+        }
+
+        double evaluate(const Vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double r =
+                a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                c2 * z * z + 2 * cd * z +
+                d2;
+            return weight > 0.0 ? std::max(r, 0.0) / weight : 0.0;
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    // Would moving 'from' onto 'to' flip or collapse any remaining triangle around 'from'?
+    bool flipsTriangles(
+        uint32_t from,
+        uint32_t to,
+        const std::vector<uint32_t>& indices,
+        const std::vector<uint32_t>& adjacencyOffsets,
+        const std::vector<uint32_t>& adjacency,
+        const std::vector<Vec3>& points
+    ) {
+        for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a) {
+            const uint32_t* tri = &indices[adjacency[a] * 3];
+
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue; // goes away with the collapse
+
+            Vec3 p[3] = { points[tri[0]], points[tri[1]], points[tri[2]] };
+            Vec3 before = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+
+            for (int k = 0; k < 3; ++k) {
+                if (tri[k] == from)
+                    p[k] = points[to];
+            }
+            Vec3 after = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+
+            if (dot(before, after) <= 0.0)
+                return true;
+        }
+        return false;
+    }
+}
+
+SimplifyResult simplifyMesh(
+    std::span<const uint32_t> sourceIndices,
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    size_t targetIndexCount,
+    float maxError
+) {
+    SimplifyResult result;
+    result.indices.assign(sourceIndices.begin(), sourceIndices.end());
+
+    std::vector<uint32_t>& indices = result.indices;
+    if (indices.size() <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    // Position ids find seams and key the border edges
+    std::vector<uint32_t> positionId;
+    size_t positionCount = generatePositionRemap(positions, vertexCount, positionStride, positionId);
+
+    std::vector<uint32_t> wedgeCount(positionCount, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        wedgeCount[positionId[v]]++;
+    }
+
+    std::vector<Vec3> points(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        points[v] = loadPosition(positions, positionStride, v);
+    }
+
+    // Locked: seams (more than one vertex at the position) and open borders
+    std::vector<uint8_t> locked(vertexCount, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (wedgeCount[positionId[v]] > 1)
+            locked[v] = 1;
+    }
+
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUse;
+        edgeUse.reserve(indices.size());
+        auto key = [&](uint32_t a, uint32_t b) {
+            uint32_t pa = positionId[a], pb = positionId[b];
+            if (pa > pb)
+                std::swap(pa, pb);
+            return (static_cast<uint64_t>(pa) << 32) | pb;
+        };
+
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                edgeUse[key(indices[i + k], indices[i + (k + 1) % 3])]++;
+            }
+        }
+
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+                if (edgeUse[key(a, b)] == 1) {
+                    locked[a] = 1;
+                    locked[b] = 1;
+                }
+            }
+        }
+    }
+
+    // Area weighted plane quadrics per vertex
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const Vec3& p0 = points[indices[i]];
+        const Vec3& p1 = points[indices[i + 1]];
+        const Vec3& p2 = points[indices[i + 2]];
+
+        Vec3 n = cross(sub(p1, p0), sub(p2, p0));
+        double length = std::sqrt(dot(n, n));
+        if (length <= 0.0)
+            continue;
+
+        n = { n.x / length, n.y / length, n.z / length };
+        double d = -dot(n, p0);
+        double area = length * 0.5;
+
+        for (int k = 0; k < 3; ++k) {
+            quadrics[indices[i + k]].addPlane(n.x, n.y, n.z, d, area);
+        }
+    }
+
+    const double maxCost = static_cast<double>(maxError) * maxError;
+    double worstCost = 0.0;
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    // Passes: collect edge collapses, apply the cheapest independent ones, compact, repeat
+    while (indices.size() > targetIndexCount) {
+        // vertex -> triangle adjacency
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : indices) {
+            adjacencyOffsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = indices[i + k];
+                uint32_t b = indices[i + (k + 1) % 3];
+                if (a > b)
+                    continue; // each shared edge once (open edges are locked anyway)
+
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+
+                double costAB = locked[a] ? DBL_MAX : q.evaluate(points[b]);
+                double costBA = locked[b] ? DBL_MAX : q.evaluate(points[a]);
+
+                if (costAB == DBL_MAX && costBA == DBL_MAX)
+                    continue;
+
+                if (costAB <= costBA)
+                    collapses.push_back({ a, b, costAB });
+                else
+                    collapses.push_back({ b, a, costBA });
+            }
+        }
+
+        if (collapses.empty())
+            break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) {
+            return l.cost < r.cost;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        // Each collapse removes about two triangles
+        size_t trianglesToRemove = (indices.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const Collapse& c : collapses) {
+            if (removed >= trianglesToRemove || c.cost > maxCost)
+                break;
+
+            if (touched[c.from] || touched[c.to])
+                continue;
+
+            if (flipsTriangles(c.from, c.to, indices, adjacencyOffsets, adjacency, points))
+                continue;
+
+            remap[c.from] = c.to;
+            quadrics[c.to].add(quadrics[c.from]);
+
+            // Keep the 1-ring of both ends stable for the rest of this pass
+            for (uint32_t v : { c.from, c.to }) {
+                for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a) {
+                    const uint32_t* tri = &indices[adjacency[a] * 3];
+                    touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+                }
+            }
+
+            worstCost = std::max(worstCost, c.cost);
+            removed += 2;
+            applied++;
+        }
+
+        if (applied == 0)
+            break;
+
+        // Apply and drop triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            uint32_t a = remap[indices[i]];
+            uint32_t b = remap[indices[i + 1]];
+            uint32_t c = remap[indices[i + 2]];
+
+            if (a == b || b == c || a == c)
+                continue;
+
+            indices[write++] = a;
+            indices[write++] = b;
+            indices[write++] = c;
+        }
+        indices.resize(write);
+    }
+
+    result.error = static_cast<float>(std::sqrt(worstCost));
+    return result;
+}
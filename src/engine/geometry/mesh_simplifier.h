@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Quadric error metric (Garland/Heckbert) edge-collapse simplifier.
+// Vertices only ever collapse onto other existing vertices, so every level
+// indexes the original vertex buffer. Vertices on open borders and on
+// attribute seams (several vertices sharing a position) are locked, which
+// keeps silhouettes and UV layouts intact at the cost of some reduction.
+
+struct SimplifyResult {
+    std::vector<uint32_t> indices;
+    float error = 0.0f; // largest collapse error, distance in model units
+};
+
+SimplifyResult simplifyMesh(
+    std::span<const uint32_t> indices,
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    size_t targetIndexCount,
+    float maxError
+);
+
+// One level of detail inside a shared index buffer
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;          // geometric error vs. LOD 0, model units
+};
+
+static_assert(sizeof(MeshLod) == 12, "MeshLod layout is stored in the mesh cache");
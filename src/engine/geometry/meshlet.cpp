@@ -0,0 +1,258 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    const float* loadPosition(const float* positions, size_t stride, uint32_t index) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + stride * index);
+    }
+
+    void computeBounds(
+        Meshlet& meshlet,
+        const MeshletBuildResult& result,
+        const float* positions,
+        size_t positionStride
+    ) {
+        float minP[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float maxP[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            const float* p = loadPosition(positions, positionStride, result.vertices[meshlet.vertexOffset + i]);
+            for (int k = 0; k < 3; ++k) {
+                minP[k] = std::min(minP[k], p[k]);
+                maxP[k] = std::max(maxP[k], p[k]);
+            }
+        }
+
+        float radiusSq = 0.0f;
+        for (int k = 0; k < 3; ++k) {
+            meshlet.aabbMin[k] = minP[k];
+            meshlet.aabbMax[k] = maxP[k];
+            meshlet.center[k] = (minP[k] + maxP[k]) * 0.5f;
+        }
+
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            const float* p = loadPosition(positions, positionStride, result.vertices[meshlet.vertexOffset + i]);
+            float dx = p[0] - meshlet.center[0];
+            float dy = p[1] - meshlet.center[1];
+            float dz = p[2] - meshlet.center[2];
+            radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+        }
+        meshlet.radius = std::sqrt(radiusSq);
+
+        // Normal cone from the unit face normals
+        std::vector<float> normals;
+        normals.reserve(meshlet.triangleCount * 3);
+
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+            const uint8_t* tri = &result.triangles[(meshlet.triangleOffset + t) * 3];
+            const float* a = loadPosition(positions, positionStride, result.vertices[meshlet.vertexOffset + tri[0]]);
+            const float* b = loadPosition(positions, positionStride, result.vertices[meshlet.vertexOffset + tri[1]]);
+            const float* c = loadPosition(positions, positionStride, result.vertices[meshlet.vertexOffset + tri[2]]);
+
+            float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float n[3] = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]
+            };
+
+            float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length <= 0.0f)
+                continue;
+
+            for (int k = 0; k < 3; ++k) {
+                n[k] /= length;
+                axis[k] += n[k];
+                normals.push_back(n[k]);
+            }
+        }
+
+        meshlet.coneAxis[0] = 0.0f;
+        meshlet.coneAxis[1] = 0.0f;
+        meshlet.coneAxis[2] = 0.0f;
+        meshlet.coneCutoff = 1.0f;
+
+        float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        if (normals.empty() || axisLength <= 0.0f)
+            return;
+
+        for (int k = 0; k < 3; ++k) {
+            axis[k] /= axisLength;
+        }
+
+        float minDot = 1.0f;
+        for (size_t i = 0; i < normals.size(); i += 3) {
+            minDot = std::min(minDot, normals[i] * axis[0] + normals[i + 1] * axis[1] + normals[i + 2] * axis[2]);
+        }
+
+        meshlet.coneAxis[0] = axis[0];
+        meshlet.coneAxis[1] = axis[1];
+        meshlet.coneAxis[2] = axis[2];
+
+        // Spread past ~84 degrees leaves nothing worth testing
+        if (minDot > 0.1f)
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+MeshletBuildResult buildMeshlets(
+    std::span<const uint32_t> indices,
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    uint32_t maxVertices,
+    uint32_t maxTriangles
+) {
+    MeshletBuildResult result;
+
+    // meshlet-local indices are uint8
+    maxVertices = std::clamp<uint32_t>(maxVertices, 3, 255);
+    maxTriangles = std::max<uint32_t>(maxTriangles, 1);
+
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return result;
+
+    result.meshlets.reserve(triangleCount / maxTriangles + 1);
+    result.vertices.reserve(triangleCount);
+    result.triangles.reserve(triangleCount * 3);
+
+    std::vector<uint8_t> localIndex(vertexCount, 0xFF);
+
+    Meshlet current{};
+
+    auto flush = [&]() {
+        if (current.triangleCount == 0)
+            return;
+
+        for (uint32_t i = 0; i < current.vertexCount; ++i) {
+            localIndex[result.vertices[current.vertexOffset + i]] = 0xFF;
+        }
+
+        computeBounds(current, result, positions, positionStride);
+        result.meshlets.push_back(current);
+
+        Meshlet next{};
+        next.vertexOffset = static_cast<uint32_t>(result.vertices.size());
+        next.triangleOffset = current.triangleOffset + current.triangleCount;
+        current = next;
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* tri = &indices[t * 3];
+
+        uint32_t newVertices =
+            (localIndex[tri[0]] == 0xFF) +
+            (localIndex[tri[1]] == 0xFF && tri[1] != tri[0]) +
+            (localIndex[tri[2]] == 0xFF && tri[2] != tri[0] && tri[2] != tri[1]);
+
+        if (current.vertexCount + newVertices > maxVertices || current.triangleCount + 1 > maxTriangles) {
+            flush();
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            if (localIndex[v] == 0xFF) {
+                localIndex[v] = static_cast<uint8_t>(current.vertexCount++);
+                result.vertices.push_back(v);
+            }
+            result.triangles.push_back(localIndex[v]);
+        }
+        current.triangleCount++;
+    }
+
+    flush();
+
+    return result;
+}
+
+CullFrustum makeCullFrustum(const float m[4][4]) {
+    // clip = v * M, so each clip component is a column of M
+    auto column = [&](int c, float out[4]) {
+        out[0] = m[0][c];
+        out[1] = m[1][c];
+        out[2] = m[2][c];
+        out[3] = m[3][c];
+    };
+
+    float x[4], y[4], z[4], w[4];
+    column(0, x);
+    column(1, y);
+    column(2, z);
+    column(3, w);
+
+    CullFrustum frustum;
+    for (int k = 0; k < 4; ++k) {
+        frustum.planes[0][k] = w[k] + x[k]; // left
+        frustum.planes[1][k] = w[k] - x[k]; // right
+        frustum.planes[2][k] = w[k] + y[k]; // bottom
+        frustum.planes[3][k] = w[k] - y[k]; // top
+        frustum.planes[4][k] = z[k];        // near (D3D depth starts at 0)
+        frustum.planes[5][k] = w[k] - z[k]; // far
+    }
+
+    for (auto& plane : frustum.planes) {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            for (float& v : plane) {
+                v /= length;
+            }
+        }
+    }
+
+    return frustum;
+}
+
+MeshletCullStats cullMeshlets(
+    std::span<const Meshlet> meshlets,
+    std::span<const uint32_t> indices,
+    const CullFrustum& frustum,
+    const float eye[3],
+    std::vector<uint32_t>& out
+) {
+    MeshletCullStats stats;
+    stats.meshletsTotal = meshlets.size();
+
+    for (const Meshlet& meshlet : meshlets) {
+        stats.trianglesTotal += meshlet.triangleCount;
+
+        bool visible = true;
+        for (const auto& plane : frustum.planes) {
+            float distance =
+                plane[0] * meshlet.center[0] +
+                plane[1] * meshlet.center[1] +
+                plane[2] * meshlet.center[2] +
+                plane[3];
+
+            if (distance < -meshlet.radius) {
+                visible = false;
+                break;
+            }
+        }
+
+        if (visible && meshlet.coneCutoff < 1.0f) {
+            float d[3] = { meshlet.center[0] - eye[0], meshlet.center[1] - eye[1], meshlet.center[2] - eye[2] };
+            float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            float along = d[0] * meshlet.coneAxis[0] + d[1] * meshlet.coneAxis[1] + d[2] * meshlet.coneAxis[2];
+
+            if (along >= meshlet.coneCutoff * distance + meshlet.radius)
+                visible = false;
+        }
+
+        if (!visible)
+            continue;
+
+        const uint32_t* first = indices.data() + static_cast<size_t>(meshlet.triangleOffset) * 3;
+        out.insert(out.end(), first, first + static_cast<size_t>(meshlet.triangleCount) * 3);
+
+        stats.meshletsVisible++;
+        stats.trianglesVisible += meshlet.triangleCount;
+    }
+
+    return stats;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Meshlets: small clusters of triangles with their own culling bounds.
+// Pure C++ like mesh_optimizer, so the cache and the tools can use it.
+//
+// The builder walks the (already cache/overdraw ordered) index list and never
+// reorders triangles, so meshlet i is also triangles [triangleOffset, +triangleCount)
+// of the mesh index buffer. Culling relies on that to emit index ranges.
+
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+    uint32_t vertexOffset;   // into meshletVertices
+    uint32_t triangleOffset; // in triangles, into meshletTriangles and the mesh index buffer
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+
+    // Bounding sphere + AABB, model space
+    float center[3];
+    float radius;
+    float aabbMin[3];
+    float aabbMax[3];
+
+    // Backface cone: every triangle faces away when
+    // dot(center - eye, coneAxis) >= coneCutoff * |center - eye| + radius.
+    // coneCutoff == 1 means the normals spread too far to ever cull.
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+static_assert(sizeof(Meshlet) == 72, "Meshlet layout is stored in the mesh cache");
+
+struct MeshletBuildResult {
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;  // mesh vertex index per meshlet-local vertex
+    std::vector<uint8_t> triangles;  // 3 meshlet-local vertex indices per triangle
+};
+
+MeshletBuildResult buildMeshlets(
+    std::span<const uint32_t> indices,
+    const float* positions,
+    size_t vertexCount,
+    size_t positionStride,
+    uint32_t maxVertices = MESHLET_MAX_VERTICES,
+    uint32_t maxTriangles = MESHLET_MAX_TRIANGLES
+);
+
+// Normalized planes (a, b, c, d), a point is inside when ax + by + cz + d >= 0
+struct CullFrustum {
+    float planes[6][4];
+};
+
+// From a row-major, row-vector (DirectXMath style) model-view-projection matrix
+// with D3D clip depth [0, 1]. The planes come out in model space.
+CullFrustum makeCullFrustum(const float matrix[4][4]);
+
+struct MeshletCullStats {
+    size_t meshletsTotal = 0;
+    size_t meshletsVisible = 0;
+    size_t trianglesTotal = 0;
+    size_t trianglesVisible = 0;
+
+    MeshletCullStats& operator+=(const MeshletCullStats& other) {
+        meshletsTotal += other.meshletsTotal;
+        meshletsVisible += other.meshletsVisible;
+        trianglesTotal += other.trianglesTotal;
+        trianglesVisible += other.trianglesVisible;
+        return *this;
+    }
+};
+
+// Tests every meshlet against the frustum and its normal cone (eye in model space)
+// and appends the index ranges of the survivors to out.
+MeshletCullStats cullMeshlets(
+    std::span<const Meshlet> meshlets,
+    std::span<const uint32_t> indices,
+    const CullFrustum& frustum,
+    const float eye[3],
+    std::vector<uint32_t>& out
+);
@@ -0,0 +1,357 @@
+#include "model_importer.h"
+#include "obj_loader.h"
+#include "assimp_io.h"
+#include "utils/thread_pool.h"
+
+#include <assimp/scene.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+namespace {
+    // Part of the mesh cache key -> changing these invalidates cooked caches
+    constexpr uint32_t IMPORT_FLAGS =
+        aiProcess_Triangulate |
+        aiProcess_CalcTangentSpace |
+        aiProcess_GenSmoothNormals |
+        aiProcess_FlipUVs;
+
+    // Cache order -> overdraw order -> vertex fetch order, stats around the whole thing
+    void optimizeMesh(MeshData& mesh, const ImportSettings& settings, MeshImportStats& stats) {
+        std::span<uint32_t> indices(mesh.indices);
+        const size_t vertexCount = mesh.vertices.size();
+
+        stats.cacheBefore = analyzeVertexCache(indices, vertexCount);
+
+        optimizeVertexCache(indices, vertexCount);
+        optimizeOverdraw(
+            indices,
+            &mesh.vertices[0].position.x,
+            vertexCount,
+            sizeof(VertexStruct),
+            settings.overdrawThreshold
+        );
+
+        std::vector<uint32_t> remap;
+        size_t used = optimizeVertexFetchRemap(indices, vertexCount, remap);
+        remapVertexBuffer(mesh.vertices, remap, used);
+
+        stats.cacheAfter = analyzeVertexCache(indices, mesh.vertices.size());
+    }
+
+    // Appends LOD 1.. to the index list, all levels share the vertex buffer
+    void generateLods(MeshData& mesh, const ImportSettings& settings) {
+        const float* positions = &mesh.vertices[0].position.x;
+        const size_t vertexCount = mesh.vertices.size();
+
+        XMFLOAT3 extent = {
+            mesh.boundsMax.x - mesh.boundsMin.x,
+            mesh.boundsMax.y - mesh.boundsMin.y,
+            mesh.boundsMax.z - mesh.boundsMin.z
+        };
+        float radius = 0.5f * std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+
+        mesh.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+
+        std::vector<uint32_t> previous = mesh.indices;
+        float error = 0.0f;
+
+        for (uint32_t level = 1; level < settings.lodCount; ++level) {
+            size_t target = static_cast<size_t>(previous.size() / 3 * settings.lodReduction) * 3;
+
+            SimplifyResult result = simplifyMesh(
+                previous,
+                positions,
+                vertexCount,
+                sizeof(VertexStruct),
+                target,
+                settings.lodMaxError * radius
+            );
+
+            // Locked seams/borders or the error cap stopped it, another level isn't worth the memory
+            if (result.indices.empty() || result.indices.size() > previous.size() * 9 / 10)
+                break;
+
+            optimizeVertexCache(result.indices, vertexCount);
+
+            // Each level is simplified from the previous one, so errors add up
+            error += result.error;
+
+            mesh.lods.push_back({
+                static_cast<uint32_t>(mesh.indices.size()),
+                static_cast<uint32_t>(result.indices.size()),
+                error
+            });
+            mesh.indices.insert(mesh.indices.end(), result.indices.begin(), result.indices.end());
+
+            previous = std::move(result.indices);
+        }
+    }
+}
+
+ModelImporter::ModelImporter(const ImportSettings& settings) :
+    settings(settings)
+{}
+
+uint32_t ModelImporter::getImportFlags() {
+    return IMPORT_FLAGS;
+}
+
+bool ModelImporter::usesNativeLoader(const std::string& path) const {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return settings.nativeObj && ext == ".obj";
+}
+
+std::vector<MeshData> ModelImporter::importAssimp(const std::string& path) {
+    // One Importer per thread: not safe to share, and each one sets up every
+    // format loader on construction, so keep it around for the next model
+    thread_local Assimp::Importer importer;
+    thread_local bool mappedIO = false;
+    if (!mappedIO) {
+        importer.SetIOHandler(new MappedIOSystem()); // the importer owns it
+        mappedIO = true;
+    }
+
+    const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        LOG_ERROR(L"ModelImporter -> Assimp failed: %hs", importer.GetErrorString());
+        throw std::runtime_error("Assimp failed to load model");
+    }
+
+    // Flatten the node tree first so results keep node traversal order
+    std::vector<aiMesh*> sceneMeshes;
+    processNode(scene->mRootNode, scene, sceneMeshes);
+
+    // Convert every mesh in parallel, each job writes only its own slot.
+    // Per-mesh bounds are merged later on the GPU side, so no locking needed.
+    std::vector<MeshData> out(sceneMeshes.size());
+
+    ThreadPool::instance().parallelFor(sceneMeshes.size(), [&](size_t i) {
+        out[i] = processMesh(sceneMeshes[i], scene);
+    });
+
+    // Don't hold the scene until this thread imports again
+    importer.FreeScene();
+
+    return out;
+}
+
+std::vector<MeshData> ModelImporter::import(const std::string& path) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<MeshData> out = usesNativeLoader(path) ? loadObj(path) : importAssimp(path);
+    stats.assign(out.size(), {});
+
+    ThreadPool::instance().parallelFor(out.size(), [&](size_t i) {
+        if (textureCallback && !out[i].diffuseTexture.empty()) {
+            textureCallback(out[i].diffuseTexture);
+        }
+
+        // Assimp's OBJ output is effectively unindexed, so weld before anything else sees it
+        if (settings.weldVertices) {
+            stats[i].weld = weldVertices(out[i].vertices, out[i].indices, settings.weld);
+        }
+
+        if (settings.optimizeMeshes && !out[i].indices.empty()) {
+            optimizeMesh(out[i], settings, stats[i]);
+        }
+
+        if (settings.buildMeshlets && !out[i].indices.empty()) {
+            MeshletBuildResult meshlets = buildMeshlets(
+                out[i].indices,
+                &out[i].vertices[0].position.x,
+                out[i].vertices.size(),
+                sizeof(VertexStruct),
+                settings.meshletMaxVertices,
+                settings.meshletMaxTriangles
+            );
+
+            out[i].meshlets = std::move(meshlets.meshlets);
+            out[i].meshletVertices = std::move(meshlets.vertices);
+            out[i].meshletTriangles = std::move(meshlets.triangles);
+        }
+
+        // Last: meshlets and the optimizer above only ever see LOD 0
+        if (settings.lodCount > 1 && !out[i].indices.empty()) {
+            generateLods(out[i], settings);
+        }
+    });
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_INFO(L"ModelImporter -> Imported %zu meshes in %.2f ms on %zu workers",
+        out.size(), ms, ThreadPool::instance().getThreadCount() + 1);
+
+    if (settings.weldVertices) {
+        WeldStats total;
+        for (const MeshImportStats& meshStats : stats) {
+            total += meshStats.weld;
+        }
+
+        LOG_INFO(L"ModelImporter -> Welded vertices %zu -> %zu (%.1f%%), triangles %zu -> %zu",
+            total.verticesBefore, total.verticesAfter,
+            total.verticesBefore ? 100.0 * total.verticesAfter / total.verticesBefore : 100.0,
+            total.trianglesBefore, total.trianglesAfter);
+    }
+
+    if (settings.buildMeshlets) {
+        size_t meshletCount = 0;
+        for (const MeshData& mesh : out) {
+            meshletCount += mesh.meshlets.size();
+        }
+
+        LOG_INFO(L"ModelImporter -> Built %zu meshlets (max %u vertices / %u triangles)",
+            meshletCount, settings.meshletMaxVertices, settings.meshletMaxTriangles);
+    }
+
+    if (settings.lodCount > 1) {
+        std::vector<size_t> trianglesPerLevel;
+        for (const MeshData& mesh : out) {
+            for (size_t level = 0; level < mesh.lods.size(); ++level) {
+                if (trianglesPerLevel.size() <= level)
+                    trianglesPerLevel.resize(level + 1, 0);
+                trianglesPerLevel[level] += mesh.lods[level].indexCount / 3;
+            }
+        }
+
+        for (size_t level = 0; level < trianglesPerLevel.size(); ++level) {
+            LOG_INFO(L"ModelImporter -> LOD %zu: %zu triangles", level, trianglesPerLevel[level]);
+        }
+    }
+
+    if (settings.optimizeMeshes) {
+        for (size_t i = 0; i < out.size(); ++i) {
+            const MeshImportStats& s = stats[i];
+            LOG_INFO(L"ModelImporter -> %hs: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                out[i].name.c_str(),
+                s.cacheBefore.acmr, s.cacheAfter.acmr,
+                s.cacheBefore.atvr, s.cacheAfter.atvr);
+        }
+    }
+
+    return out;
+}
+
+void ModelImporter::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& out) {
+    // Collect all the meshes at this node
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        out.push_back(scene->mMeshes[node->mMeshes[i]]);
+    }
+
+    // Then process all children
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        processNode(node->mChildren[i], scene, out);
+    }
+}
+
+MeshData ModelImporter::processMesh(aiMesh* mesh, const aiScene* scene) const {
+    LOG_INFO(L"[ModelImporter] Processing mesh: %hs, Vertices: %u, Faces: %u",
+        mesh->mName.C_Str(),
+        mesh->mNumVertices,
+        mesh->mNumFaces
+    );
+
+    MeshData data;
+    data.name = mesh->mName.C_Str();
+    data.materialIndex = mesh->mMaterialIndex;
+
+    std::vector<VertexStruct>& vertices = data.vertices;
+    std::vector<uint32_t>& indices = data.indices;
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(mesh->mNumFaces * 3);
+
+    XMFLOAT3 minPos = { FLT_MAX,  FLT_MAX,  FLT_MAX };
+    XMFLOAT3 maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+        VertexStruct vertex{};
+        
+        // Position
+        vertex.position = {
+            mesh->mVertices[i].x,
+            mesh->mVertices[i].y,
+            mesh->mVertices[i].z,
+            1.0f
+        };
+
+        // Normal
+        if (mesh->HasNormals()) {
+            vertex.normal = {
+                mesh->mNormals[i].x,
+                mesh->mNormals[i].y,
+                mesh->mNormals[i].z
+            };
+        }
+
+        // Tangent + Handedness
+        if (mesh->HasTangentsAndBitangents() && mesh->HasNormals()) {
+            // Load Assimp vectors directly into XMVECTOR
+            XMVECTOR tVec = XMLoadFloat3(
+                reinterpret_cast<XMFLOAT3*>(&mesh->mTangents[i])
+            );
+            XMVECTOR bVec = XMLoadFloat3(
+                reinterpret_cast<XMFLOAT3*>(&mesh->mBitangents[i])
+            );
+            XMVECTOR nVec = XMLoadFloat3(
+                reinterpret_cast<XMFLOAT3*>(&mesh->mNormals[i])
+            );
+
+            // Optional: normalize to be safe
+            tVec = XMVector3Normalize(tVec);
+            bVec = XMVector3Normalize(bVec);
+            nVec = XMVector3Normalize(nVec);
+
+            // Compute handedness
+            float handedness = (XMVectorGetX(XMVector3Dot(XMVector3Cross(nVec, tVec), bVec)) < 0.0f) ? -1.0f : 1.0f;
+
+            vertex.tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, handedness };
+        } else {
+            vertex.tangent = { 1.0f, 0.0f, 0.0f, 1.0f }; // fallback
+        }
+
+        // UVs
+        if (mesh->HasTextureCoords(0)) {
+            vertex.texcoord = {
+                mesh->mTextureCoords[0][i].x,
+                mesh->mTextureCoords[0][i].y
+            };
+        } else {
+            vertex.texcoord = { 0.0f, 0.0f };
+        }
+
+        vertices.push_back(vertex);
+
+        // Track mesh bounds
+        minPos.x = std::min(minPos.x, mesh->mVertices[i].x);
+        minPos.y = std::min(minPos.y, mesh->mVertices[i].y);
+        minPos.z = std::min(minPos.z, mesh->mVertices[i].z);
+        maxPos.x = std::max(maxPos.x, mesh->mVertices[i].x);
+        maxPos.y = std::max(maxPos.y, mesh->mVertices[i].y);
+        maxPos.z = std::max(maxPos.z, mesh->mVertices[i].z);
+    }
+
+
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        aiFace face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++) indices.push_back(face.mIndices[j]);
+    }
+
+    data.boundsMin = minPos;
+    data.boundsMax = maxPos;
+
+    LOG_DEBUG(L"[ModelImporter] Mesh processed. Final vertex count: %zu, index count: %zu", vertices.size(), indices.size());
+
+    // --- Material reference, resolved to a texture on the GPU side ---
+    if (mesh->mMaterialIndex >= 0) {
+        aiMaterial* aimat = scene->mMaterials[mesh->mMaterialIndex];
+        aiString texPath;
+        if ((aimat->GetTextureCount(aiTextureType_BASE_COLOR) > 0 &&
+             aimat->GetTexture(aiTextureType_BASE_COLOR, 0, &texPath) == AI_SUCCESS) ||
+            (aimat->GetTextureCount(aiTextureType_DIFFUSE) > 0 &&
+             aimat->GetTexture(aiTextureType_DIFFUSE, 0, &texPath) == AI_SUCCESS)) {
+            data.diffuseTexture = texPath.C_Str();
+        }
+    }
+
+    return data;
+}
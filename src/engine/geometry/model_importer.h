@@ -0,0 +1,57 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "mesh_data.h"
+#include "mesh_optimizer.h"
+#include "import_settings.h"
+
+struct aiNode;
+struct aiScene;
+struct aiMesh;
+
+struct MeshImportStats {
+    WeldStats weld;
+    VertexCacheStats cacheBefore;
+    VertexCacheStats cacheAfter;
+};
+
+// CPU half of model loading: Assimp (or loadObj() for .obj) -> MeshData, then
+// weld + optimize. No device access, so the offline tools use it as-is.
+class ModelImporter {
+    public:
+        explicit ModelImporter(const ImportSettings& settings = {});
+        ~ModelImporter() = default;
+
+        // Assimp post-process flags, part of the mesh cache key
+        static uint32_t getImportFlags();
+
+        // Throws if the file can't be loaded
+        std::vector<MeshData> import(const std::string& path);
+
+        // True when import() takes the native OBJ path for this file
+        bool usesNativeLoader(const std::string& path) const;
+
+        // Called with each mesh's diffuse texture name (as the material names it) as soon as
+        // the mesh is converted, before weld/optimize/meshlets/LODs. Runs on pool workers,
+        // so it must be thread safe. Lets textures decode while the import carries on.
+        void setTextureCallback(std::function<void(const std::string&)> callback) {
+            textureCallback = std::move(callback);
+        }
+
+        // Per-mesh stats of the last import(), same order as the returned meshes
+        const std::vector<MeshImportStats>& getStats() const {
+            return stats;
+        }
+
+    private:
+        std::vector<MeshData> importAssimp(const std::string& path);
+        void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& out);
+
+        // Runs in parallel over all meshes, so it must not touch members
+        MeshData processMesh(aiMesh* mesh, const aiScene* scene) const;
+
+    private:
+        ImportSettings settings;
+        std::vector<MeshImportStats> stats;
+        std::function<void(const std::string&)> textureCallback;
+};
@@ -0,0 +1,592 @@
+#include "obj_loader.h"
+#include "utils/hash.h"
+#include "utils/mapped_file.h"
+#include "utils/thread_pool.h"
+
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr uint32_t MISSING = UINT32_MAX;
+
+    // Smaller chunks than this cost more in scheduling than they win
+    constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+    struct ObjCorner {
+        uint32_t position;
+        uint32_t texcoord;
+        uint32_t normal;
+
+        bool operator==(const ObjCorner&) const = default;
+    };
+
+    struct ObjCornerHash {
+        size_t operator()(const ObjCorner& corner) const {
+            return static_cast<size_t>(hashBytes(&corner, sizeof(corner)));
+        }
+    };
+
+    // o/g/usemtl inside a chunk. Whatever isn't set carries over from the lines
+    // before, which for a chunk's first group is only known after all chunks parsed.
+    struct ObjGroup {
+        std::string_view name;
+        std::string_view material;
+        bool hasName = false;
+        bool hasMaterial = false;
+        size_t firstTriangle = 0;
+    };
+
+    struct ObjChunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        // v/vt/vn lines in the chunks before this one, then in this one
+        size_t positionBase = 0;
+        size_t texcoordBase = 0;
+        size_t normalBase = 0;
+        size_t positionCount = 0;
+        size_t texcoordCount = 0;
+        size_t normalCount = 0;
+
+        std::vector<ObjCorner> corners; // 3 per triangle
+        std::vector<ObjGroup> groups;
+        std::vector<std::string_view> materialLibraries;
+    };
+
+    struct ObjAttributes {
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT2> texcoords;
+        std::vector<XMFLOAT3> normals;
+    };
+
+    struct ObjMaterial {
+        uint32_t index = 0;
+        std::string diffuseTexture;
+    };
+
+    // Triangles of one output mesh, gathered from every chunk that has some
+    struct ObjMeshSource {
+        std::string name;
+        std::string_view material;
+        std::vector<std::pair<const ObjChunk*, std::pair<size_t, size_t>>> ranges; // chunk, [first, last) triangle
+    };
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    const char* skipSpace(const char* p, const char* end) {
+        while (p < end && isSpace(*p))
+            ++p;
+        return p;
+    }
+
+    const char* findLineEnd(const char* p, const char* end) {
+        const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        return newline ? static_cast<const char*>(newline) : end;
+    }
+
+    std::string_view trim(const char* begin, const char* end) {
+        begin = skipSpace(begin, end);
+        while (end > begin && isSpace(end[-1]))
+            --end;
+        return std::string_view(begin, static_cast<size_t>(end - begin));
+    }
+
+    // from_chars: no locale, no allocation, and exact. It only rejects a leading '+'.
+    const char* parseFloat(const char* p, const char* end, float& out) {
+        p = skipSpace(p, end);
+        if (p < end && *p == '+')
+            ++p;
+
+        out = 0.0f;
+        auto result = std::from_chars(p, end, out);
+        return result.ec == std::errc() ? result.ptr : p;
+    }
+
+    const char* parseInt(const char* p, const char* end, long long& out) {
+        out = 0;
+        auto result = std::from_chars(p, end, out);
+        return result.ec == std::errc() ? result.ptr : p;
+    }
+
+    // 1-based, negative counts back from the last element read so far
+    uint32_t resolveIndex(long long value, size_t countSoFar) {
+        if (value > 0)
+            return static_cast<uint32_t>(value - 1);
+        if (value < 0 && static_cast<size_t>(-value) <= countSoFar)
+            return static_cast<uint32_t>(static_cast<long long>(countSoFar) + value);
+        return MISSING;
+    }
+
+    // Keyword at the line start, cursor left on what follows it
+    std::string_view readKeyword(const char*& p, const char* end) {
+        const char* begin = p;
+        while (p < end && !isSpace(*p))
+            ++p;
+        return std::string_view(begin, static_cast<size_t>(p - begin));
+    }
+
+    // Line aligned split, at most a few chunks per worker
+    std::vector<ObjChunk> splitChunks(const char* data, size_t size) {
+        size_t workers = ThreadPool::instance().getThreadCount() + 1;
+        size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_BYTES, 1, workers * 4);
+        size_t chunkBytes = size / chunkCount + 1;
+
+        std::vector<ObjChunk> chunks;
+        chunks.reserve(chunkCount);
+
+        const char* end = data + size;
+        const char* p = data;
+        while (p < end) {
+            ObjChunk chunk;
+            chunk.begin = p;
+
+            const char* split = p + std::min(chunkBytes, static_cast<size_t>(end - p));
+            chunk.end = split < end ? findLineEnd(split, end) : end;
+            if (chunk.end < end)
+                chunk.end++; // keep the '\n' in this chunk
+
+            p = chunk.end;
+            chunks.push_back(std::move(chunk));
+        }
+
+        return chunks;
+    }
+
+    void countAttributes(ObjChunk& chunk) {
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* lineEnd = findLineEnd(p, chunk.end);
+            const char* cursor = skipSpace(p, lineEnd);
+
+            // Same keyword test as parseChunk, which writes one slot per line counted here
+            std::string_view keyword = readKeyword(cursor, lineEnd);
+            if (keyword == "v")
+                chunk.positionCount++;
+            else if (keyword == "vt")
+                chunk.texcoordCount++;
+            else if (keyword == "vn")
+                chunk.normalCount++;
+
+            p = lineEnd + 1;
+        }
+    }
+
+    void parseFace(const char* p, const char* end, ObjChunk& chunk, size_t positions, size_t texcoords, size_t normals, std::vector<ObjCorner>& polygon) {
+        polygon.clear();
+
+        while (true) {
+            p = skipSpace(p, end);
+            if (p >= end)
+                break;
+
+            ObjCorner corner = { MISSING, MISSING, MISSING };
+            long long value = 0;
+
+            const char* next = parseInt(p, end, value);
+            if (next == p)
+                break; // not an index, ignore the rest of the line
+            p = next;
+            corner.position = resolveIndex(value, positions);
+
+            if (p < end && *p == '/') {
+                ++p;
+                if (p < end && *p != '/') {
+                    p = parseInt(p, end, value);
+                    corner.texcoord = resolveIndex(value, texcoords);
+                }
+                if (p < end && *p == '/') {
+                    ++p;
+                    p = parseInt(p, end, value);
+                    corner.normal = resolveIndex(value, normals);
+                }
+            }
+
+            // Skip anything left of a malformed token
+            while (p < end && !isSpace(*p))
+                ++p;
+
+            polygon.push_back(corner);
+        }
+
+        // Fan, same as aiProcess_Triangulate gives for the convex polygons OBJ exporters write
+        for (size_t i = 2; i < polygon.size(); ++i) {
+            chunk.corners.push_back(polygon[0]);
+            chunk.corners.push_back(polygon[i - 1]);
+            chunk.corners.push_back(polygon[i]);
+        }
+    }
+
+    void parseChunk(ObjChunk& chunk, ObjAttributes& attributes) {
+        size_t positions = chunk.positionBase;
+        size_t texcoords = chunk.texcoordBase;
+        size_t normals = chunk.normalBase;
+
+        chunk.corners.reserve(chunk.positionCount * 6);
+        chunk.groups.push_back({});
+
+        std::vector<ObjCorner> polygon;
+
+        auto pushGroup = [&]() -> ObjGroup& {
+            ObjGroup group = chunk.groups.back();
+            group.firstTriangle = chunk.corners.size() / 3;
+
+            // Nothing was emitted under the previous state, replace it
+            if (chunk.groups.back().firstTriangle == group.firstTriangle)
+                chunk.groups.pop_back();
+
+            chunk.groups.push_back(group);
+            return chunk.groups.back();
+        };
+
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* lineEnd = findLineEnd(p, chunk.end);
+            const char* cursor = skipSpace(p, lineEnd);
+            std::string_view keyword = readKeyword(cursor, lineEnd);
+
+            if (keyword == "v") {
+                XMFLOAT3& v = attributes.positions[positions++];
+                cursor = parseFloat(cursor, lineEnd, v.x);
+                cursor = parseFloat(cursor, lineEnd, v.y);
+                parseFloat(cursor, lineEnd, v.z);
+            } else if (keyword == "vt") {
+                XMFLOAT2& vt = attributes.texcoords[texcoords++];
+                cursor = parseFloat(cursor, lineEnd, vt.x);
+                parseFloat(cursor, lineEnd, vt.y);
+            } else if (keyword == "vn") {
+                XMFLOAT3& vn = attributes.normals[normals++];
+                cursor = parseFloat(cursor, lineEnd, vn.x);
+                cursor = parseFloat(cursor, lineEnd, vn.y);
+                parseFloat(cursor, lineEnd, vn.z);
+            } else if (keyword == "f") {
+                parseFace(cursor, lineEnd, chunk, positions, texcoords, normals, polygon);
+            } else if (keyword == "o" || keyword == "g") {
+                ObjGroup& group = pushGroup();
+                group.name = trim(cursor, lineEnd);
+                group.hasName = true;
+            } else if (keyword == "usemtl") {
+                ObjGroup& group = pushGroup();
+                group.material = trim(cursor, lineEnd);
+                group.hasMaterial = true;
+            } else if (keyword == "mtllib") {
+                chunk.materialLibraries.push_back(trim(cursor, lineEnd));
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    // newmtl + map_Kd is all the GPU side uses
+    void parseMaterialLibrary(const fs::path& path, std::unordered_map<std::string, ObjMaterial>& materials) {
+        MappedFile file;
+        if (!file.open(path.string())) {
+            LOG_WARNING(L"ObjLoader -> Missing material library %hs", path.string().c_str());
+            return;
+        }
+
+        const char* p = reinterpret_cast<const char*>(file.getData());
+        const char* end = p + file.getSize();
+
+        ObjMaterial* current = nullptr;
+        while (p < end) {
+            const char* lineEnd = findLineEnd(p, end);
+            const char* cursor = skipSpace(p, lineEnd);
+            std::string_view keyword = readKeyword(cursor, lineEnd);
+
+            if (keyword == "newmtl") {
+                std::string name(trim(cursor, lineEnd));
+                auto [it, inserted] = materials.try_emplace(name);
+                if (inserted)
+                    it->second.index = static_cast<uint32_t>(materials.size() - 1);
+                current = &it->second;
+            } else if (keyword == "map_Kd" && current) {
+                std::string_view value = trim(cursor, lineEnd);
+
+                // With options (-s 1 1 1 ...) the file name is the last token, else the whole
+                // rest of the line so names with spaces survive
+                if (!value.empty() && value[0] == '-') {
+                    size_t lastSpace = value.find_last_of(" \t");
+                    value = lastSpace == std::string_view::npos ? value : value.substr(lastSpace + 1);
+                }
+                current->diffuseTexture = std::string(value);
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    MeshData buildMesh(const ObjMeshSource& source, const ObjAttributes& attributes, uint32_t materialIndex, const std::string& diffuseTexture) {
+        MeshData data;
+        data.name = source.name;
+        data.materialIndex = materialIndex;
+        data.diffuseTexture = diffuseTexture;
+
+        size_t triangleCount = 0;
+        for (const auto& range : source.ranges) {
+            triangleCount += range.second.second - range.second.first;
+        }
+
+        std::vector<VertexStruct>& vertices = data.vertices;
+        std::vector<uint32_t>& indices = data.indices;
+        indices.reserve(triangleCount * 3);
+
+        // Weld: one vertex per distinct (position, uv, normal) triple
+        std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> lookup;
+        lookup.reserve(triangleCount * 2);
+
+        std::vector<uint32_t> vertexPosition;
+        std::vector<uint8_t> hasNormal;
+        bool anyTexcoords = false;
+        bool missingNormals = false;
+
+        for (const auto& [chunk, range] : source.ranges) {
+            for (size_t t = range.first; t < range.second; ++t) {
+                ObjCorner tri[3] = { chunk->corners[t * 3], chunk->corners[t * 3 + 1], chunk->corners[t * 3 + 2] };
+
+                if (tri[0].position >= attributes.positions.size() ||
+                    tri[1].position >= attributes.positions.size() ||
+                    tri[2].position >= attributes.positions.size())
+                    continue;
+
+                for (ObjCorner& corner : tri) {
+                    if (corner.texcoord >= attributes.texcoords.size())
+                        corner.texcoord = MISSING;
+                    if (corner.normal >= attributes.normals.size())
+                        corner.normal = MISSING;
+
+                    auto [it, inserted] = lookup.try_emplace(corner, static_cast<uint32_t>(vertices.size()));
+                    if (inserted) {
+                        const XMFLOAT3& p = attributes.positions[corner.position];
+
+                        VertexStruct vertex{};
+                        vertex.position = { p.x, p.y, p.z, 1.0f };
+                        vertex.tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
+
+                        if (corner.normal != MISSING)
+                            vertex.normal = attributes.normals[corner.normal];
+
+                        // aiProcess_FlipUVs
+                        if (corner.texcoord != MISSING) {
+                            const XMFLOAT2& uv = attributes.texcoords[corner.texcoord];
+                            vertex.texcoord = { uv.x, 1.0f - uv.y };
+                            anyTexcoords = true;
+                        }
+
+                        missingNormals |= corner.normal == MISSING;
+
+                        vertices.push_back(vertex);
+                        vertexPosition.push_back(corner.position);
+                        hasNormal.push_back(corner.normal != MISSING);
+                    }
+
+                    indices.push_back(it->second);
+                }
+            }
+        }
+
+        auto sub = [](const XMFLOAT4& a, const XMFLOAT4& b) {
+            return XMFLOAT3{ a.x - b.x, a.y - b.y, a.z - b.z };
+        };
+        auto cross = [](const XMFLOAT3& a, const XMFLOAT3& b) {
+            return XMFLOAT3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+        };
+        auto dot = [](const XMFLOAT3& a, const XMFLOAT3& b) {
+            return a.x * b.x + a.y * b.y + a.z * b.z;
+        };
+        auto normalize = [&](const XMFLOAT3& v, const XMFLOAT3& fallback) {
+            float length = std::sqrt(dot(v, v));
+            return length > 1e-12f ? XMFLOAT3{ v.x / length, v.y / length, v.z / length } : fallback;
+        };
+
+        // Smooth normals over all corners sharing a position, area weighted (aiProcess_GenSmoothNormals)
+        if (missingNormals) {
+            std::unordered_map<uint32_t, XMFLOAT3> positionNormals;
+
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                const VertexStruct& a = vertices[indices[i]];
+                const VertexStruct& b = vertices[indices[i + 1]];
+                const VertexStruct& c = vertices[indices[i + 2]];
+                XMFLOAT3 n = cross(sub(b.position, a.position), sub(c.position, a.position));
+
+                for (size_t k = 0; k < 3; ++k) {
+                    XMFLOAT3& sum = positionNormals[vertexPosition[indices[i + k]]];
+                    sum = { sum.x + n.x, sum.y + n.y, sum.z + n.z };
+                }
+            }
+
+            for (size_t v = 0; v < vertices.size(); ++v) {
+                if (!hasNormal[v])
+                    vertices[v].normal = normalize(positionNormals[vertexPosition[v]], XMFLOAT3{ 0.0f, 1.0f, 0.0f });
+            }
+        }
+
+        // Tangent frame from the UV gradients (aiProcess_CalcTangentSpace), handedness in w
+        if (anyTexcoords) {
+            std::vector<XMFLOAT3> tangents(vertices.size(), { 0.0f, 0.0f, 0.0f });
+            std::vector<XMFLOAT3> bitangents(vertices.size(), { 0.0f, 0.0f, 0.0f });
+
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                const VertexStruct& a = vertices[indices[i]];
+                const VertexStruct& b = vertices[indices[i + 1]];
+                const VertexStruct& c = vertices[indices[i + 2]];
+
+                XMFLOAT3 e1 = sub(b.position, a.position);
+                XMFLOAT3 e2 = sub(c.position, a.position);
+                float du1 = b.texcoord.x - a.texcoord.x, dv1 = b.texcoord.y - a.texcoord.y;
+                float du2 = c.texcoord.x - a.texcoord.x, dv2 = c.texcoord.y - a.texcoord.y;
+
+                float det = du1 * dv2 - du2 * dv1;
+                if (std::fabs(det) < 1e-20f)
+                    continue;
+
+                float r = 1.0f / det;
+                XMFLOAT3 t = { (e1.x * dv2 - e2.x * dv1) * r, (e1.y * dv2 - e2.y * dv1) * r, (e1.z * dv2 - e2.z * dv1) * r };
+                XMFLOAT3 s = { (e2.x * du1 - e1.x * du2) * r, (e2.y * du1 - e1.y * du2) * r, (e2.z * du1 - e1.z * du2) * r };
+
+                for (size_t k = 0; k < 3; ++k) {
+                    XMFLOAT3& tangent = tangents[indices[i + k]];
+                    XMFLOAT3& bitangent = bitangents[indices[i + k]];
+                    tangent = { tangent.x + t.x, tangent.y + t.y, tangent.z + t.z };
+                    bitangent = { bitangent.x + s.x, bitangent.y + s.y, bitangent.z + s.z };
+                }
+            }
+
+            for (size_t v = 0; v < vertices.size(); ++v) {
+                const XMFLOAT3& n = vertices[v].normal;
+                const XMFLOAT3& t = tangents[v];
+
+                // Gram-Schmidt against the normal
+                float d = dot(n, t);
+                XMFLOAT3 tangent = normalize(XMFLOAT3{ t.x - n.x * d, t.y - n.y * d, t.z - n.z * d }, XMFLOAT3{ 0.0f, 0.0f, 0.0f });
+                if (dot(tangent, tangent) == 0.0f)
+                    continue; // keeps the fallback
+
+                float handedness = dot(cross(n, tangent), bitangents[v]) < 0.0f ? -1.0f : 1.0f;
+                vertices[v].tangent = { tangent.x, tangent.y, tangent.z, handedness };
+            }
+        }
+
+        XMFLOAT3 minPos = { FLT_MAX,  FLT_MAX,  FLT_MAX };
+        XMFLOAT3 maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (const VertexStruct& vertex : vertices) {
+            minPos = { std::min(minPos.x, vertex.position.x), std::min(minPos.y, vertex.position.y), std::min(minPos.z, vertex.position.z) };
+            maxPos = { std::max(maxPos.x, vertex.position.x), std::max(maxPos.y, vertex.position.y), std::max(maxPos.z, vertex.position.z) };
+        }
+        data.boundsMin = minPos;
+        data.boundsMax = maxPos;
+
+        return data;
+    }
+}
+
+std::vector<MeshData> loadObj(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        LOG_ERROR(L"ObjLoader -> Can't open %hs", path.c_str());
+        throw std::runtime_error("Failed to open OBJ file");
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const char* text = reinterpret_cast<const char*>(file.getData());
+    std::vector<ObjChunk> chunks = splitChunks(text, file.getSize());
+
+    ThreadPool& pool = ThreadPool::instance();
+
+    // Counting pass, then every chunk knows where its attributes go
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        countAttributes(chunks[i]);
+    });
+
+    ObjAttributes attributes;
+    {
+        size_t positions = 0, texcoords = 0, normals = 0;
+        for (ObjChunk& chunk : chunks) {
+            chunk.positionBase = positions;
+            chunk.texcoordBase = texcoords;
+            chunk.normalBase = normals;
+            positions += chunk.positionCount;
+            texcoords += chunk.texcoordCount;
+            normals += chunk.normalCount;
+        }
+
+        attributes.positions.resize(positions);
+        attributes.texcoords.resize(texcoords);
+        attributes.normals.resize(normals);
+    }
+
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        parseChunk(chunks[i], attributes);
+    });
+
+    // Materials, relative to the OBJ
+    std::unordered_map<std::string, ObjMaterial> materials;
+    const fs::path directory = fs::path(path).parent_path();
+    for (const ObjChunk& chunk : chunks) {
+        for (std::string_view library : chunk.materialLibraries) {
+            parseMaterialLibrary(directory / fs::path(std::string(library)), materials);
+        }
+    }
+
+    // Carry o/g/usemtl state across chunk borders and bucket triangles per mesh
+    std::vector<ObjMeshSource> sources;
+    std::unordered_map<std::string, size_t> sourceByKey;
+    {
+        std::string_view name;
+        std::string_view material;
+
+        for (const ObjChunk& chunk : chunks) {
+            const size_t chunkTriangles = chunk.corners.size() / 3;
+
+            for (size_t g = 0; g < chunk.groups.size(); ++g) {
+                const ObjGroup& group = chunk.groups[g];
+                if (group.hasName)
+                    name = group.name;
+                if (group.hasMaterial)
+                    material = group.material;
+
+                size_t first = group.firstTriangle;
+                size_t last = g + 1 < chunk.groups.size() ? chunk.groups[g + 1].firstTriangle : chunkTriangles;
+                if (first == last)
+                    continue;
+
+                std::string key = std::string(name) + '\n' + std::string(material);
+                auto [it, inserted] = sourceByKey.try_emplace(key, sources.size());
+                if (inserted) {
+                    ObjMeshSource source;
+                    source.name = name.empty() ? fs::path(path).stem().string() : std::string(name);
+                    source.material = material;
+                    sources.push_back(std::move(source));
+                }
+
+                sources[it->second].ranges.push_back({ &chunk, { first, last } });
+            }
+        }
+    }
+
+    // Meshes without a known material share one default past the MTL ones, like Assimp's
+    const uint32_t defaultMaterial = static_cast<uint32_t>(materials.size());
+
+    std::vector<MeshData> meshes(sources.size());
+    pool.parallelFor(sources.size(), [&](size_t i) {
+        auto it = materials.find(std::string(sources[i].material));
+
+        meshes[i] = buildMesh(
+            sources[i],
+            attributes,
+            it != materials.end() ? it->second.index : defaultMaterial,
+            it != materials.end() ? it->second.diffuseTexture : std::string()
+        );
+    });
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_INFO(L"ObjLoader -> %hs: %zu positions, %zu meshes, %zu chunks in %.2f ms",
+        path.c_str(), attributes.positions.size(), meshes.size(), chunks.size(), ms);
+
+    return meshes;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "mesh_data.h"
+
+// Native Wavefront OBJ/MTL reader, used instead of Assimp for .obj files.
+//
+// The file is memory mapped and cut into line aligned chunks. A quick counting
+// pass gives every chunk its first v/vt/vn slot, then all chunks parse in
+// parallel straight into the shared attribute arrays. Faces keep OBJ's separate
+// position/uv/normal indices until each mesh is built, where every distinct
+// triple becomes one vertex.
+//
+// Output follows ModelImporter's Assimp flags: polygons fan triangulated,
+// smooth normals where the file has none, tangents from the UVs and V flipped.
+// One mesh per (object/group, material) pair, in order of first use.
+
+// Throws if the file can't be mapped
+std::vector<MeshData> loadObj(const std::string& path);
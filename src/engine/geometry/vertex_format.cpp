@@ -0,0 +1,139 @@
+#include "vertex_format.h"
+
+#include <DirectXPackedVector.h>
+
+namespace {
+    int16_t toSnorm16(float v) {
+        v = std::clamp(v, -1.0f, 1.0f);
+        return static_cast<int16_t>(std::lround(v * 32767.0f));
+    }
+
+    uint16_t toUnorm16(float v) {
+        v = std::clamp(v, 0.0f, 1.0f);
+        return static_cast<uint16_t>(std::lround(v * 65535.0f));
+    }
+
+    // Octahedral mapping of a unit vector onto [-1, 1]^2
+    void encodeOctahedral(float x, float y, float z, int16_t out[2]) {
+        float length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        if (length <= 0.0f) {
+            out[0] = 0;
+            out[1] = 0;
+            return;
+        }
+
+        x /= length;
+        y /= length;
+
+        if (z < 0.0f) {
+            float ox = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float oy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = ox;
+            y = oy;
+        }
+
+        out[0] = toSnorm16(x);
+        out[1] = toSnorm16(y);
+    }
+}
+
+VertexDequant packVertices(std::span<const VertexStruct> vertices, std::vector<PackedVertex>& out) {
+    XMFLOAT3 minPos = { FLT_MAX,  FLT_MAX,  FLT_MAX };
+    XMFLOAT3 maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (const VertexStruct& v : vertices) {
+        minPos = { std::min(minPos.x, v.position.x), std::min(minPos.y, v.position.y), std::min(minPos.z, v.position.z) };
+        maxPos = { std::max(maxPos.x, v.position.x), std::max(maxPos.y, v.position.y), std::max(maxPos.z, v.position.z) };
+    }
+
+    VertexDequant dequant;
+    if (vertices.empty()) {
+        out.clear();
+        return dequant;
+    }
+
+    dequant.offset = minPos;
+    dequant.scale = { maxPos.x - minPos.x, maxPos.y - minPos.y, maxPos.z - minPos.z };
+
+    // Flat axes keep a zero scale and quantize to 0
+    const XMFLOAT3 inv = {
+        dequant.scale.x > 0.0f ? 1.0f / dequant.scale.x : 0.0f,
+        dequant.scale.y > 0.0f ? 1.0f / dequant.scale.y : 0.0f,
+        dequant.scale.z > 0.0f ? 1.0f / dequant.scale.z : 0.0f
+    };
+
+    out.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const VertexStruct& v = vertices[i];
+        PackedVertex& p = out[i];
+
+        p.position[0] = toUnorm16((v.position.x - minPos.x) * inv.x);
+        p.position[1] = toUnorm16((v.position.y - minPos.y) * inv.y);
+        p.position[2] = toUnorm16((v.position.z - minPos.z) * inv.z);
+        p.position[3] = v.tangent.w < 0.0f ? 0 : 65535;
+
+        encodeOctahedral(v.normal.x, v.normal.y, v.normal.z, p.normal);
+        encodeOctahedral(v.tangent.x, v.tangent.y, v.tangent.z, p.tangent);
+
+        p.texcoord[0] = PackedVector::XMConvertFloatToHalf(v.texcoord.x);
+        p.texcoord[1] = PackedVector::XMConvertFloatToHalf(v.texcoord.y);
+    }
+
+    return dequant;
+}
+
+void splitVertices(std::span<const VertexStruct> vertices, std::vector<XMFLOAT3>& positions, std::vector<VertexAttributes>& attributes) {
+    positions.resize(vertices.size());
+    attributes.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const VertexStruct& v = vertices[i];
+        positions[i] = { v.position.x, v.position.y, v.position.z };
+        attributes[i] = { v.normal, v.tangent, v.texcoord };
+    }
+}
+
+UINT getVertexStride(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Packed:
+            return sizeof(PackedVertex);
+        case VertexFormat::Split:
+            return sizeof(XMFLOAT3);
+        default:
+            return sizeof(VertexStruct);
+    }
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> getInputLayout(VertexFormat format) {
+    if (format == VertexFormat::Packed) {
+        return {
+            { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(PackedVertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "NORMAL",   0, DXGI_FORMAT_R16G16_SNORM,       0, offsetof(PackedVertex, normal),   D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TANGENT",  0, DXGI_FORMAT_R16G16_SNORM,       0, offsetof(PackedVertex, tangent),  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, offsetof(PackedVertex, texcoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        };
+    }
+
+    // POSITION comes in as float3, the input assembler fills w = 1
+    if (format == VertexFormat::Split) {
+        return {
+            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0, 0,                                    D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT,    1, offsetof(VertexAttributes, normal),   D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TANGENT",  0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, offsetof(VertexAttributes, tangent),  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       1, offsetof(VertexAttributes, texcoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        };
+    }
+
+    return {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(VertexStruct, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT,    0, offsetof(VertexStruct, normal),   D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TANGENT",  0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(VertexStruct, tangent),  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       0, offsetof(VertexStruct, texcoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> getDepthInputLayout() {
+    return {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "utils/pch.h"
+
+#include <span>
+
+enum class VertexFormat {
+    Full,   // VertexStruct, 64 bytes
+    Packed, // PackedVertex, 20 bytes
+    Split   // slot 0 float3 position (12 bytes) + slot 1 VertexAttributes (36 bytes)
+};
+
+// 20-byte vertex:
+//  position  R16G16B16A16_UNORM  xyz quantized over the mesh bounds, w = tangent handedness (0 -> -1, 1 -> +1)
+//  normal    R16G16_SNORM        octahedral
+//  tangent   R16G16_SNORM        octahedral
+//  texcoord  R16G16_FLOAT
+struct PackedVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    int16_t tangent[2];
+    uint16_t texcoord[2];
+};
+
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex must stay 20 bytes");
+
+// Everything but the position, the second stream of VertexFormat::Split
+struct VertexAttributes {
+    XMFLOAT3 normal;
+    XMFLOAT4 tangent;
+    XMFLOAT2 texcoord;
+};
+
+static_assert(sizeof(VertexAttributes) == 36, "VertexAttributes must stay tightly packed");
+
+// Per-mesh position dequantization, position = unorm * scale + offset.
+// Matches the VertexDequant root constants in vertex.hlsl (8 x 32-bit).
+struct VertexDequant {
+    XMFLOAT3 scale = { 1.0f, 1.0f, 1.0f };
+    float pad0 = 0.0f;
+    XMFLOAT3 offset = { 0.0f, 0.0f, 0.0f };
+    float pad1 = 0.0f;
+};
+
+static_assert(sizeof(VertexDequant) == 8 * sizeof(uint32_t), "VertexDequant must match the root constant count");
+
+// Quantizes full vertices, returns the dequantization for the mesh
+VertexDequant packVertices(std::span<const VertexStruct> vertices, std::vector<PackedVertex>& out);
+
+// Splits full vertices into a position stream and an attribute stream
+void splitVertices(std::span<const VertexStruct> vertices, std::vector<XMFLOAT3>& positions, std::vector<VertexAttributes>& attributes);
+
+// Stride of slot 0 (the only slot unless Split)
+UINT getVertexStride(VertexFormat format);
+
+// Input layout matching the format, shared by every pipeline that draws it
+std::vector<D3D12_INPUT_ELEMENT_DESC> getInputLayout(VertexFormat format);
+
+// Position-only layout (float3 in slot 0), for depth and shadow passes
+std::vector<D3D12_INPUT_ELEMENT_DESC> getDepthInputLayout();
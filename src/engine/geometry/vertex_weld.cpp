@@ -0,0 +1,139 @@
+#include "vertex_weld.h"
+#include "utils/hash.h"
+
+#include <array>
+#include <bit>
+
+namespace {
+    constexpr uint32_t EMPTY = UINT32_MAX;
+
+    // pos(3) normal(3) tangent(3) handedness(1) uv(2)
+    using WeldKey = std::array<int64_t, 12>;
+
+    int64_t quantize(float value, float invEpsilon) {
+        return std::llround(static_cast<double>(value) * invEpsilon);
+    }
+
+    WeldKey makeKey(const VertexStruct& v, float invPos, float invNormal, float invUv) {
+        return {
+            quantize(v.position.x, invPos),
+            quantize(v.position.y, invPos),
+            quantize(v.position.z, invPos),
+            quantize(v.normal.x, invNormal),
+            quantize(v.normal.y, invNormal),
+            quantize(v.normal.z, invNormal),
+            quantize(v.tangent.x, invNormal),
+            quantize(v.tangent.y, invNormal),
+            quantize(v.tangent.z, invNormal),
+            v.tangent.w < 0.0f ? -1 : 1,
+            quantize(v.texcoord.x, invUv),
+            quantize(v.texcoord.y, invUv)
+        };
+    }
+
+    bool isZeroArea(const VertexStruct& a, const VertexStruct& b, const VertexStruct& c, float epsilon) {
+        float e1x = b.position.x - a.position.x, e1y = b.position.y - a.position.y, e1z = b.position.z - a.position.z;
+        float e2x = c.position.x - a.position.x, e2y = c.position.y - a.position.y, e2z = c.position.z - a.position.z;
+
+        float cx = e1y * e2z - e1z * e2y;
+        float cy = e1z * e2x - e1x * e2z;
+        float cz = e1x * e2y - e1y * e2x;
+
+        // |cross| is twice the area; compare squared to skip the sqrt
+        float limit = epsilon * epsilon;
+        return (cx * cx + cy * cy + cz * cz) <= limit * limit;
+    }
+}
+
+WeldStats weldVertices(
+    std::vector<VertexStruct>& vertices,
+    std::vector<uint32_t>& indices,
+    const WeldSettings& settings
+) {
+    WeldStats stats;
+    stats.verticesBefore = vertices.size();
+    stats.trianglesBefore = indices.size() / 3;
+
+    if (vertices.empty()) {
+        stats.trianglesAfter = stats.trianglesBefore;
+        return stats;
+    }
+
+    const float invPos = 1.0f / std::max(settings.positionEpsilon, 1e-12f);
+    const float invNormal = 1.0f / std::max(settings.normalEpsilon, 1e-12f);
+    const float invUv = 1.0f / std::max(settings.uvEpsilon, 1e-12f);
+
+    const size_t vertexCount = vertices.size();
+
+    // Open addressing table of vertex indices, power of two sized at <= 50% load
+    const size_t capacity = std::bit_ceil(vertexCount * 2);
+    const size_t mask = capacity - 1;
+    std::vector<uint32_t> table(capacity, EMPTY);
+
+    std::vector<WeldKey> keys(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        keys[i] = makeKey(vertices[i], invPos, invNormal, invUv);
+
+        size_t slot = hashBytes(keys[i].data(), sizeof(WeldKey)) & mask;
+        for (;;) {
+            uint32_t candidate = table[slot];
+            if (candidate == EMPTY) {
+                table[slot] = static_cast<uint32_t>(i);
+                remap[i] = static_cast<uint32_t>(i);
+                break;
+            }
+            if (keys[candidate] == keys[i]) {
+                remap[i] = candidate;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    // Rewrite triangles onto the surviving vertices, dropping collapsed ones
+    size_t write = 0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        uint32_t a = remap[indices[t + 0]];
+        uint32_t b = remap[indices[t + 1]];
+        uint32_t c = remap[indices[t + 2]];
+
+        if (settings.removeDegenerates) {
+            if (a == b || b == c || a == c)
+                continue;
+            if (isZeroArea(vertices[a], vertices[b], vertices[c], settings.positionEpsilon))
+                continue;
+        }
+
+        indices[write++] = a;
+        indices[write++] = b;
+        indices[write++] = c;
+    }
+    indices.resize(write);
+
+    // Compact: keep referenced vertices in their original order
+    std::vector<uint32_t> compacted(vertexCount, EMPTY);
+    for (uint32_t index : indices) {
+        compacted[index] = 0;
+    }
+
+    uint32_t next = 0;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (compacted[i] == EMPTY)
+            continue;
+        compacted[i] = next;
+        if (next != i)
+            vertices[next] = vertices[i];
+        ++next;
+    }
+    vertices.resize(next);
+
+    for (uint32_t& index : indices) {
+        index = compacted[index];
+    }
+
+    stats.verticesAfter = vertices.size();
+    stats.trianglesAfter = indices.size() / 3;
+    return stats;
+}
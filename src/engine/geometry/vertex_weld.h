@@ -0,0 +1,36 @@
+#pragma once
+
+#include "utils/pch.h"
+
+// Tolerances are absolute; attributes closer than this snap to the same cell
+// and are treated as one vertex.
+struct WeldSettings {
+    float positionEpsilon = 1e-5f;
+    float normalEpsilon = 1e-3f; // also used for the tangent direction
+    float uvEpsilon = 1e-5f;
+    bool removeDegenerates = true;
+};
+
+struct WeldStats {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t trianglesBefore = 0;
+    size_t trianglesAfter = 0;
+
+    WeldStats& operator+=(const WeldStats& other) {
+        verticesBefore += other.verticesBefore;
+        verticesAfter += other.verticesAfter;
+        trianglesBefore += other.trianglesBefore;
+        trianglesAfter += other.trianglesAfter;
+        return *this;
+    }
+};
+
+// Merges vertices whose quantized position/normal/tangent/uv match, rewrites the
+// index list, drops triangles that collapsed (repeated index or zero area) and
+// compacts away vertices nothing references anymore. Vertex order is kept stable.
+WeldStats weldVertices(
+    std::vector<VertexStruct>& vertices,
+    std::vector<uint32_t>& indices,
+    const WeldSettings& settings
+);
@@ -0,0 +1,173 @@
+#include "channel_pack.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char* CHANNEL_NAMES[MASK_CHANNEL_COUNT] = { "occlusion", "roughness", "metalness", "specular" };
+    const char RGBA[] = "rgba";
+
+    bool fail(std::string* error, const char* message) {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    std::string lowercase(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    bool endsWith(const std::string& s, const char* suffix) {
+        size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    // First channel of source at (u, v) in [0, 1], bilinear with clamped edges
+    uint8_t sampleBilinear(const ChannelSource& source, float u, float v) {
+        float x = std::clamp(u * source.width - 0.5f, 0.0f, static_cast<float>(source.width - 1));
+        float y = std::clamp(v * source.height - 0.5f, 0.0f, static_cast<float>(source.height - 1));
+
+        uint32_t x0 = static_cast<uint32_t>(x);
+        uint32_t y0 = static_cast<uint32_t>(y);
+        uint32_t x1 = std::min(x0 + 1, source.width - 1);
+        uint32_t y1 = std::min(y0 + 1, source.height - 1);
+        float fx = x - x0;
+        float fy = y - y0;
+
+        const uint8_t* row0 = source.pixels + y0 * source.rowPitch;
+        const uint8_t* row1 = source.pixels + y1 * source.rowPitch;
+        float top = row0[x0 * 4] + (row0[x1 * 4] - row0[x0 * 4]) * fx;
+        float bottom = row1[x0 * 4] + (row1[x1 * 4] - row1[x0 * 4]) * fx;
+        return static_cast<uint8_t>(top + (bottom - top) * fy + 0.5f);
+    }
+}
+
+size_t ChannelLayout::count() const {
+    return static_cast<size_t>(std::count_if(std::begin(channels), std::end(channels), [](int32_t c) { return c >= 0; }));
+}
+
+std::string channelPackKey(const fs::path& texture) {
+    std::string stem = lowercase(texture.stem().string());
+    size_t end = stem.find_first_of("_-. ");
+    return end == std::string::npos || end == 0 ? stem : stem.substr(0, end);
+}
+
+fs::path channelPackPath(const fs::path& directory, const std::string& key) {
+    return directory / (key + "_mask.dds");
+}
+
+fs::path channelLayoutPath(const fs::path& directory, const std::string& key) {
+    return directory / (key + "_mask.txt");
+}
+
+bool classifyMaskChannel(const fs::path& texture, MaskChannel& channel) {
+    std::string stem = lowercase(texture.stem().string());
+
+    // The packed output itself
+    if (endsWith(stem, "_mask"))
+        return false;
+
+    if (stem.find("occlusion") != std::string::npos || endsWith(stem, "_ao")) {
+        channel = MaskChannel::Occlusion;
+    } else if (stem.find("rough") != std::string::npos || endsWith(stem, "_r")) {
+        channel = MaskChannel::Roughness;
+    } else if (stem.find("metal") != std::string::npos || endsWith(stem, "_m")) {
+        channel = MaskChannel::Metalness;
+    } else if (stem.find("spec") != std::string::npos) {
+        channel = MaskChannel::Specular;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* maskChannelName(MaskChannel channel) {
+    return CHANNEL_NAMES[static_cast<size_t>(channel)];
+}
+
+void packChannels(
+    const ChannelSource (&sources)[MASK_CHANNEL_COUNT],
+    const ChannelLayout& layout,
+    uint8_t* pixels,
+    uint32_t width,
+    uint32_t height,
+    size_t rowPitch
+) {
+    const bool alphaUsed = std::find(std::begin(layout.channels), std::end(layout.channels), 3) != std::end(layout.channels);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* row = pixels + y * rowPitch;
+        for (uint32_t x = 0; x < width; ++x) {
+            row[x * 4 + 0] = 0;
+            row[x * 4 + 1] = 0;
+            row[x * 4 + 2] = 0;
+            row[x * 4 + 3] = alphaUsed ? 0 : 255;
+        }
+    }
+
+    for (size_t map = 0; map < MASK_CHANNEL_COUNT; ++map) {
+        const ChannelSource& source = sources[map];
+        const int32_t channel = layout.channels[map];
+        if (!source.pixels || channel < 0)
+            continue;
+
+        const bool sameSize = source.width == width && source.height == height;
+        for (uint32_t y = 0; y < height; ++y) {
+            uint8_t* row = pixels + y * rowPitch;
+            const uint8_t* src = source.pixels + y * source.rowPitch;
+            const float v = (y + 0.5f) / height;
+
+            for (uint32_t x = 0; x < width; ++x) {
+                row[x * 4 + channel] = sameSize ? src[x * 4] : sampleBilinear(source, (x + 0.5f) / width, v);
+            }
+        }
+    }
+}
+
+bool writeChannelLayout(const fs::path& path, const ChannelLayout& layout, std::string* error) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        return fail(error, "can't write channel layout");
+
+    file << "# texture_cooker channel layout: <map> <channel of " << path.stem().string() << ".dds>\n";
+    for (size_t map = 0; map < MASK_CHANNEL_COUNT; ++map) {
+        if (layout.channels[map] >= 0)
+            file << CHANNEL_NAMES[map] << ' ' << RGBA[layout.channels[map]] << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+bool readChannelLayout(const fs::path& path, ChannelLayout& layout, std::string* error) {
+    std::ifstream file(path);
+    if (!file)
+        return fail(error, "no channel layout");
+
+    layout = {};
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        std::string name;
+        std::string channel;
+        if (!(fields >> name >> channel) || channel.size() != 1)
+            return fail(error, "bad channel layout line");
+
+        const char* slot = std::strchr(RGBA, channel[0]);
+        auto map = std::find_if(std::begin(CHANNEL_NAMES), std::end(CHANNEL_NAMES), [&](const char* n) { return name == n; });
+        if (!slot || channel[0] == '\0' || map == std::end(CHANNEL_NAMES))
+            return fail(error, "unknown map or channel in layout");
+
+        layout.channels[map - std::begin(CHANNEL_NAMES)] = static_cast<int32_t>(slot - RGBA);
+    }
+
+    return layout.count() > 0 || fail(error, "empty channel layout");
+}
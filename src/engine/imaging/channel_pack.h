@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Channel packing of a material's single-channel maps (occlusion, roughness,
+// metalness, specular) into one texture. texture_cooker writes the packed
+// texture and a small text descriptor next to it; the renderer reads the
+// descriptor to tell the shader which RGBA channel holds which map, so one
+// fetch covers every map the material has.
+//
+// Maps belong to the same material when their file names share a key (the
+// stem up to its first separator) in one directory: KSR29sniperrifle_Roughness
+// and KSR29sniperrifle_low_Material.005_AmbientOcclusion both pack into
+// ksr29sniperrifle_mask.dds. The material's albedo has the same key, which is
+// how the renderer finds the mask for it.
+
+enum class MaskChannel {
+    Occlusion,
+    Roughness,
+    Metalness,
+    Specular
+};
+
+constexpr size_t MASK_CHANNEL_COUNT = 4;
+
+// RGBA channel index of each MaskChannel in the packed texture, -1 when absent.
+// Laid out as the shader's int4.
+struct ChannelLayout {
+    int32_t channels[MASK_CHANNEL_COUNT] = { -1, -1, -1, -1 };
+
+    size_t count() const;
+};
+
+// Lowercase stem up to the first '_', '-', '.' or ' '
+std::string channelPackKey(const std::filesystem::path& texture);
+
+// <dir>/<key>_mask.dds and its descriptor <dir>/<key>_mask.txt
+std::filesystem::path channelPackPath(const std::filesystem::path& directory, const std::string& key);
+std::filesystem::path channelLayoutPath(const std::filesystem::path& directory, const std::string& key);
+
+// Which map a file holds, from its name. False for anything else (gloss and
+// height maps aren't packed: one is inverted roughness, the other feeds geometry).
+bool classifyMaskChannel(const std::filesystem::path& texture, MaskChannel& channel);
+
+const char* maskChannelName(MaskChannel channel);
+
+// One source map: 8-bit RGBA, the first channel is used
+struct ChannelSource {
+    const uint8_t* pixels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t rowPitch = 0;
+};
+
+// Fills RGBA pixels of width x height from the sources present (null pixels
+// for absent maps), each in the channel layout gives it, bilinearly resampled
+// when its size differs. Unused channels get 0, alpha 255 if unused.
+void packChannels(
+    const ChannelSource (&sources)[MASK_CHANNEL_COUNT],
+    const ChannelLayout& layout,
+    uint8_t* pixels,
+    uint32_t width,
+    uint32_t height,
+    size_t rowPitch
+);
+
+bool writeChannelLayout(const std::filesystem::path& path, const ChannelLayout& layout, std::string* error = nullptr);
+bool readChannelLayout(const std::filesystem::path& path, ChannelLayout& layout, std::string* error = nullptr);
@@ -0,0 +1,432 @@
+#include "image_decoder.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+#include <jpeglib.h>
+#include <png.h>
+
+namespace {
+    // Anything larger than a D3D12 2D texture is rejected up front
+    constexpr uint32_t MAX_DIMENSION = 16384;
+
+    void setError(std::string* error, const char* message) {
+        if (error)
+            *error = message;
+    }
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t readU32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+            (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    // ---- JPEG ----
+
+    // libjpeg reports errors through error_exit, which must not return
+    struct JpegError {
+        jpeg_error_mgr manager;
+        jmp_buf jump;
+        char message[JMSG_LENGTH_MAX];
+    };
+
+    void jpegErrorExit(j_common_ptr cinfo) {
+        JpegError* error = reinterpret_cast<JpegError*>(cinfo->err);
+        (*cinfo->err->format_message)(cinfo, error->message);
+        std::longjmp(error->jump, 1);
+    }
+
+    void jpegSilence(j_common_ptr, int) {}
+
+    // Kept free of C++ objects: a longjmp out of libjpeg skips destructors
+    bool jpegDecode(const uint8_t* data, size_t size, ImageInfo* info, uint8_t* pixels, size_t rowPitch, char* message) {
+        jpeg_decompress_struct cinfo;
+        JpegError error;
+
+        cinfo.err = jpeg_std_error(&error.manager);
+        error.manager.error_exit = jpegErrorExit;
+        error.manager.emit_message = jpegSilence;
+        error.message[0] = '\0';
+
+        if (setjmp(error.jump)) {
+            std::snprintf(message, JMSG_LENGTH_MAX, "%s", error.message);
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(size));
+        jpeg_read_header(&cinfo, TRUE);
+
+        // CMYK / YCCK: WIC hands those back as CMYK, leave them to it
+        if (cinfo.num_components != 1 && cinfo.num_components != 3) {
+            std::snprintf(message, JMSG_LENGTH_MAX, "unsupported JPEG color space");
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+
+        if (!pixels) {
+            info->width = cinfo.image_width;
+            info->height = cinfo.image_height;
+            info->channels = cinfo.num_components == 1 ? 1 : 4;
+            jpeg_destroy_decompress(&cinfo);
+            return true;
+        }
+
+        // libjpeg-turbo extension: YCbCr -> RGBA in the SIMD color converter,
+        // grayscale replicates into RGB unless one channel was asked for
+        cinfo.out_color_space = info->channels == 1 ? JCS_GRAYSCALE : JCS_EXT_RGBA;
+        jpeg_start_decompress(&cinfo);
+
+        if (cinfo.output_width != info->width || cinfo.output_height != info->height) {
+            std::snprintf(message, JMSG_LENGTH_MAX, "JPEG size changed between header and decode");
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = pixels + cinfo.output_scanline * rowPitch;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        return true;
+    }
+
+    // ---- PNG ----
+
+    bool pngReadHeader(const uint8_t* data, size_t size, png_image& image) {
+        std::memset(&image, 0, sizeof(image));
+        image.version = PNG_IMAGE_VERSION;
+
+        if (!png_image_begin_read_from_memory(&image, data, size))
+            return false;
+
+        // 16-bit sources: the simplified API would treat them as linear and
+        // re-encode, while WIC keeps them 16-bit. Not ours to decode.
+        if (image.format & PNG_FORMAT_FLAG_LINEAR) {
+            png_image_free(&image);
+            return false;
+        }
+
+        return true;
+    }
+
+    // ---- BMP ----
+
+    constexpr uint32_t BI_RGB_ = 0;
+    constexpr uint32_t BI_BITFIELDS_ = 3;
+    constexpr uint32_t BI_ALPHABITFIELDS_ = 6;
+
+    struct BmpHeader {
+        uint32_t pixelOffset = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool topDown = false;
+        uint16_t bitCount = 0;
+        uint32_t compression = BI_RGB_;
+        uint32_t masks[4] = {}; // r, g, b, a
+        const uint8_t* palette = nullptr;
+        uint32_t paletteEntries = 0;
+        size_t paletteEntrySize = 4; // BGRX, BGR for OS/2 headers
+        size_t rowSize = 0;
+    };
+
+    struct BitField {
+        uint32_t mask = 0;
+        uint32_t shift = 0;
+        uint32_t max = 0;
+
+        explicit BitField(uint32_t mask) : mask(mask) {
+            if (!mask)
+                return;
+            while (!((mask >> shift) & 1))
+                shift++;
+            max = mask >> shift;
+        }
+
+        // Scales to 8 bits, 5-bit 31 -> 255 like WIC
+        uint8_t extract(uint32_t value, uint8_t fallback) const {
+            if (!mask)
+                return fallback;
+            uint32_t v = (value & mask) >> shift;
+            return static_cast<uint8_t>((v * 255 + max / 2) / max);
+        }
+    };
+
+    bool bmpReadHeader(const uint8_t* data, size_t size, BmpHeader& header) {
+        if (size < 14 + 12 || data[0] != 'B' || data[1] != 'M')
+            return false;
+
+        header.pixelOffset = readU32(data + 10);
+        const uint8_t* dib = data + 14;
+        uint32_t dibSize = readU32(dib);
+        if (dibSize < 12 || 14 + static_cast<size_t>(dibSize) > size)
+            return false;
+
+        int32_t width = 0;
+        int32_t height = 0;
+        if (dibSize == 12) {
+            // OS/2 BITMAPCOREHEADER
+            width = readU16(dib + 4);
+            height = static_cast<int16_t>(readU16(dib + 6));
+            header.bitCount = readU16(dib + 10);
+        } else {
+            if (dibSize < 40)
+                return false;
+            width = static_cast<int32_t>(readU32(dib + 4));
+            height = static_cast<int32_t>(readU32(dib + 8));
+            header.bitCount = readU16(dib + 14);
+            header.compression = readU32(dib + 16);
+        }
+
+        if (width <= 0 || height == 0 || height == INT32_MIN)
+            return false;
+
+        header.width = static_cast<uint32_t>(width);
+        header.topDown = height < 0;
+        header.height = static_cast<uint32_t>(height < 0 ? -height : height);
+
+        if (header.compression != BI_RGB_ && header.compression != BI_BITFIELDS_ && header.compression != BI_ALPHABITFIELDS_)
+            return false;
+
+        switch (header.bitCount) {
+            case 1: case 4: case 8: case 16: case 24: case 32:
+                break;
+            default:
+                return false;
+        }
+
+        if (header.compression != BI_RGB_) {
+            if (header.bitCount != 16 && header.bitCount != 32)
+                return false;
+
+            // Masks follow a 40-byte header, or sit inside V4/V5 headers
+            size_t maskCount = header.compression == BI_ALPHABITFIELDS_ || dibSize >= 56 ? 4 : 3;
+            if (14 + 40 + maskCount * 4 > size)
+                return false;
+            for (size_t i = 0; i < maskCount; ++i)
+                header.masks[i] = readU32(dib + 40 + i * 4);
+        } else if (header.bitCount == 16) {
+            header.masks[0] = 0x7C00;
+            header.masks[1] = 0x03E0;
+            header.masks[2] = 0x001F;
+        } else if (header.bitCount == 32) {
+            // BI_RGB 32-bit: the fourth byte is unused, WIC reads it as opaque
+            header.masks[0] = 0x00FF0000;
+            header.masks[1] = 0x0000FF00;
+            header.masks[2] = 0x000000FF;
+        }
+
+        if (header.bitCount <= 8) {
+            size_t entrySize = dibSize == 12 ? 3 : 4;
+            uint32_t colorsUsed = dibSize >= 36 ? readU32(dib + 32) : 0;
+            uint32_t entries = colorsUsed ? colorsUsed : (1u << header.bitCount);
+
+            size_t paletteOffset = 14 + static_cast<size_t>(dibSize);
+            if (header.compression == BI_BITFIELDS_ && dibSize == 40)
+                paletteOffset += 12;
+
+            size_t available = paletteOffset < header.pixelOffset ? (header.pixelOffset - paletteOffset) / entrySize : 0;
+            header.paletteEntries = static_cast<uint32_t>(std::min<size_t>(entries, std::min<size_t>(available, 256)));
+            if (header.paletteEntries == 0)
+                return false;
+            header.palette = data + paletteOffset;
+            header.paletteEntrySize = entrySize;
+        }
+
+        header.rowSize = ((static_cast<size_t>(header.width) * header.bitCount + 31) / 32) * 4;
+        if (header.pixelOffset > size || header.rowSize * header.height > size - header.pixelOffset)
+            return false;
+
+        return true;
+    }
+
+    void bmpDecode(const uint8_t* data, const BmpHeader& header, uint8_t* pixels, size_t rowPitch) {
+        const BitField r(header.masks[0]);
+        const BitField g(header.masks[1]);
+        const BitField b(header.masks[2]);
+        const BitField a(header.masks[3]);
+        const bool defaultMasks32 = header.bitCount == 32 &&
+            header.masks[0] == 0x00FF0000 && header.masks[1] == 0x0000FF00 && header.masks[2] == 0x000000FF;
+
+        for (uint32_t y = 0; y < header.height; ++y) {
+            uint32_t srcY = header.topDown ? y : header.height - 1 - y;
+            const uint8_t* src = data + header.pixelOffset + srcY * header.rowSize;
+            uint8_t* dst = pixels + y * rowPitch;
+
+            switch (header.bitCount) {
+                case 1:
+                case 4:
+                case 8: {
+                    const uint32_t perByte = 8 / header.bitCount;
+                    const uint32_t indexMask = (1u << header.bitCount) - 1;
+                    for (uint32_t x = 0; x < header.width; ++x) {
+                        uint32_t shift = (perByte - 1 - x % perByte) * header.bitCount;
+                        uint32_t index = (src[x / perByte] >> shift) & indexMask;
+                        if (index >= header.paletteEntries)
+                            index = 0;
+                        const uint8_t* entry = header.palette + index * header.paletteEntrySize;
+                        dst[x * 4 + 0] = entry[2];
+                        dst[x * 4 + 1] = entry[1];
+                        dst[x * 4 + 2] = entry[0];
+                        dst[x * 4 + 3] = 255;
+                    }
+                    break;
+                }
+                case 16:
+                    for (uint32_t x = 0; x < header.width; ++x) {
+                        uint32_t value = readU16(src + x * 2);
+                        dst[x * 4 + 0] = r.extract(value, 0);
+                        dst[x * 4 + 1] = g.extract(value, 0);
+                        dst[x * 4 + 2] = b.extract(value, 0);
+                        dst[x * 4 + 3] = a.extract(value, 255);
+                    }
+                    break;
+                case 24:
+                    for (uint32_t x = 0; x < header.width; ++x) {
+                        dst[x * 4 + 0] = src[x * 3 + 2];
+                        dst[x * 4 + 1] = src[x * 3 + 1];
+                        dst[x * 4 + 2] = src[x * 3 + 0];
+                        dst[x * 4 + 3] = 255;
+                    }
+                    break;
+                case 32:
+                    if (defaultMasks32) {
+                        // BGRX / BGRA byte swizzle, the common case
+                        for (uint32_t x = 0; x < header.width; ++x) {
+                            dst[x * 4 + 0] = src[x * 4 + 2];
+                            dst[x * 4 + 1] = src[x * 4 + 1];
+                            dst[x * 4 + 2] = src[x * 4 + 0];
+                            dst[x * 4 + 3] = a.mask ? src[x * 4 + 3] : 255;
+                        }
+                    } else {
+                        for (uint32_t x = 0; x < header.width; ++x) {
+                            uint32_t value = readU32(src + x * 4);
+                            dst[x * 4 + 0] = r.extract(value, 0);
+                            dst[x * 4 + 1] = g.extract(value, 0);
+                            dst[x * 4 + 2] = b.extract(value, 0);
+                            dst[x * 4 + 3] = a.extract(value, 255);
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+}
+
+ImageFileType detectImageType(const uint8_t* data, size_t size) {
+    static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+        return ImageFileType::Jpeg;
+    if (size >= 8 && std::memcmp(data, PNG_SIGNATURE, 8) == 0)
+        return ImageFileType::Png;
+    if (size >= 2 && data[0] == 'B' && data[1] == 'M')
+        return ImageFileType::Bmp;
+    return ImageFileType::Unknown;
+}
+
+bool readImageInfo(const uint8_t* data, size_t size, ImageInfo& info) {
+    info = ImageInfo();
+    info.type = detectImageType(data, size);
+
+    switch (info.type) {
+        case ImageFileType::Jpeg: {
+            char message[JMSG_LENGTH_MAX];
+            if (!jpegDecode(data, size, &info, nullptr, 0, message))
+                return false;
+            break;
+        }
+        case ImageFileType::Png: {
+            png_image image;
+            if (!pngReadHeader(data, size, image))
+                return false;
+            info.width = image.width;
+            info.height = image.height;
+            // Gray + alpha and gray palettes expand to RGBA like WIC does
+            if (!(image.format & (PNG_FORMAT_FLAG_COLOR | PNG_FORMAT_FLAG_ALPHA | PNG_FORMAT_FLAG_COLORMAP)))
+                info.channels = 1;
+            png_image_free(&image);
+            break;
+        }
+        case ImageFileType::Bmp: {
+            BmpHeader header;
+            if (!bmpReadHeader(data, size, header))
+                return false;
+            info.width = header.width;
+            info.height = header.height;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    return info.width > 0 && info.height > 0 && info.width <= MAX_DIMENSION && info.height <= MAX_DIMENSION;
+}
+
+bool decodeImage(
+    const uint8_t* data,
+    size_t size,
+    const ImageInfo& info,
+    uint8_t* pixels,
+    size_t rowPitch,
+    std::string* error
+) {
+    if ((info.channels != 1 && info.channels != 4) || (info.channels == 1 && info.type == ImageFileType::Bmp)) {
+        setError(error, "unsupported channel count");
+        return false;
+    }
+
+    if (!pixels || rowPitch < static_cast<size_t>(info.width) * info.channels) {
+        setError(error, "output buffer too small");
+        return false;
+    }
+
+    switch (info.type) {
+        case ImageFileType::Jpeg: {
+            char message[JMSG_LENGTH_MAX];
+            ImageInfo expected = info;
+            if (!jpegDecode(data, size, &expected, pixels, rowPitch, message)) {
+                setError(error, message);
+                return false;
+            }
+            return true;
+        }
+        case ImageFileType::Png: {
+            png_image image;
+            if (!pngReadHeader(data, size, image) || image.width != info.width || image.height != info.height) {
+                setError(error, "bad PNG header");
+                return false;
+            }
+
+            // Palette, gray and RGB all expand to RGBA unless one channel was
+            // asked for; the stride is in components, which for 8-bit output is bytes
+            image.format = info.channels == 1 ? PNG_FORMAT_GRAY : PNG_FORMAT_RGBA;
+            if (!png_image_finish_read(&image, nullptr, pixels, static_cast<png_int_32>(rowPitch), nullptr)) {
+                setError(error, image.message);
+                png_image_free(&image);
+                return false;
+            }
+            return true;
+        }
+        case ImageFileType::Bmp: {
+            BmpHeader header;
+            if (!bmpReadHeader(data, size, header) || header.width != info.width || header.height != info.height) {
+                setError(error, "bad BMP header");
+                return false;
+            }
+            bmpDecode(data, header, pixels, rowPitch);
+            return true;
+        }
+        default:
+            setError(error, "unknown image format");
+            return false;
+    }
+}
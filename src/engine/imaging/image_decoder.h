@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Portable JPEG / PNG / BMP decoding to 8-bit RGBA, no WIC or COM.
+// JPEG goes through libjpeg-turbo (SIMD IDCT and color conversion), PNG through
+// libpng's simplified API, BMP is read here. Pixels land in a caller-owned
+// buffer, so the texture path can decode straight into a ScratchImage.
+//
+// Bytes are stored as-is: like WIC_FLAGS_FORCE_SRGB the data is only tagged
+// sRGB, nothing is converted. Grayscale JPEG and PNG report one channel, which
+// WIC loads as linear R8_UNORM; callers wanting RGBA set channels to 4 before
+// decoding and the gray value is replicated with alpha 255.
+//
+// readImageInfo() rejects what WIC handles differently (16-bit PNG, CMYK JPEG,
+// compressed BMP); callers fall back to WIC for those.
+
+enum class ImageFileType {
+    Unknown,
+    Jpeg,
+    Png,
+    Bmp
+};
+
+struct ImageInfo {
+    ImageFileType type = ImageFileType::Unknown;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 4; // 1 for grayscale sources, bytes per pixel decodeImage writes
+};
+
+// Sniffs the signature, not the extension
+ImageFileType detectImageType(const uint8_t* data, size_t size);
+
+// Header only. Returns false for unknown or unsupported files.
+bool readImageInfo(const uint8_t* data, size_t size, ImageInfo& info);
+
+// Writes info.height rows of info.width * info.channels bytes, rowPitch apart, top row first.
+// Thread safe, every call keeps its own decoder state.
+bool decodeImage(
+    const uint8_t* data,
+    size_t size,
+    const ImageInfo& info,
+    uint8_t* pixels,
+    size_t rowPitch,
+    std::string* error = nullptr
+);
@@ -0,0 +1,309 @@
+#include "mip_generator.h"
+#include "utils/thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MIP_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+namespace {
+    // Output rows per thread pool item. Bands recompute the few source rows
+    // they share with their neighbours instead of synchronizing.
+    constexpr uint32_t BAND_ROWS = 32;
+
+    // Kaiser window: half-width in destination pixels and shape, as in NVTT
+    constexpr float KAISER_WIDTH = 3.0f;
+    constexpr float KAISER_ALPHA = 4.0f;
+
+    struct ColorTables {
+        float srgbToLinear[256];
+        float unormToFloat[256];
+        uint8_t linearToSrgb[65536]; // indexed by linear * 65535
+
+        ColorTables() {
+            for (int i = 0; i < 256; ++i) {
+                float c = i / 255.0f;
+                srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                unormToFloat[i] = c;
+            }
+            for (int i = 0; i < 65536; ++i) {
+                float l = i / 65535.0f;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                linearToSrgb[i] = static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const ColorTables& colorTables() {
+        static const ColorTables tables;
+        return tables;
+    }
+
+    // Contributions of source pixels to every output pixel along one axis,
+    // the same for all rows (or columns) of a level
+    struct AxisWeights {
+        std::vector<uint32_t> first;
+        std::vector<float> weights; // taps per output, zero padded
+        uint32_t taps = 0;
+    };
+
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    double kaiser(double x) {
+        double t = x / KAISER_WIDTH;
+        if (std::abs(t) >= 1.0)
+            return 0.0;
+
+        const double pi = 3.14159265358979323846;
+        double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+        return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / besselI0(KAISER_ALPHA);
+    }
+
+    AxisWeights buildWeights(uint32_t srcSize, uint32_t dstSize, MipFilter filter) {
+        const double scale = static_cast<double>(srcSize) / dstSize;
+        const double support = filter == MipFilter::Kaiser ? KAISER_WIDTH * scale : 0.5 * scale;
+
+        AxisWeights axis;
+        axis.taps = static_cast<uint32_t>(std::ceil(support * 2.0)) + 1;
+        axis.first.resize(dstSize);
+        axis.weights.assign(static_cast<size_t>(dstSize) * axis.taps, 0.0f);
+
+        std::vector<double> w(axis.taps);
+        for (uint32_t o = 0; o < dstSize; ++o) {
+            const double center = (o + 0.5) * scale;
+            const int64_t begin = static_cast<int64_t>(std::floor(center - support));
+            const int64_t end = static_cast<int64_t>(std::ceil(center + support));
+
+            // Clamp addressing: taps past an edge add to the edge pixel
+            const int64_t lo = std::clamp<int64_t>(begin, 0, srcSize - 1);
+            const int64_t hi = std::clamp<int64_t>(end - 1, 0, srcSize - 1);
+            std::fill(w.begin(), w.end(), 0.0);
+
+            double total = 0.0;
+            for (int64_t i = begin; i < end; ++i) {
+                double weight;
+                if (filter == MipFilter::Kaiser) {
+                    weight = kaiser((i + 0.5 - center) / scale);
+                } else {
+                    weight = std::min<double>(i + 1, center + support) - std::max<double>(i, center - support);
+                }
+                if (weight == 0.0)
+                    continue;
+
+                int64_t tap = std::clamp<int64_t>(i, lo, hi) - lo;
+                w[static_cast<size_t>(tap)] += weight;
+                total += weight;
+            }
+
+            axis.first[o] = static_cast<uint32_t>(lo);
+            float* out = axis.weights.data() + static_cast<size_t>(o) * axis.taps;
+            for (uint32_t t = 0; t < axis.taps; ++t)
+                out[t] = total != 0.0 ? static_cast<float>(w[t] / total) : 0.0f;
+        }
+
+        return axis;
+    }
+
+    // dst[i] += src[i] * weight over count RGBA pixels
+    void accumulate(float* dst, const float* src, float weight, size_t count) {
+#if MIP_SSE2
+        const __m128 w = _mm_set1_ps(weight);
+        for (size_t i = 0; i < count; ++i) {
+            __m128 d = _mm_loadu_ps(dst + i * 4);
+            _mm_storeu_ps(dst + i * 4, _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(src + i * 4), w)));
+        }
+#else
+        for (size_t i = 0; i < count * 4; ++i)
+            dst[i] += src[i] * weight;
+#endif
+    }
+
+    void decodeRow(const uint8_t* src, uint32_t width, const float* colorTable, const float* alphaTable, float* dst) {
+        for (uint32_t x = 0; x < width; ++x) {
+            dst[x * 4 + 0] = colorTable[src[x * 4 + 0]];
+            dst[x * 4 + 1] = colorTable[src[x * 4 + 1]];
+            dst[x * 4 + 2] = colorTable[src[x * 4 + 2]];
+            dst[x * 4 + 3] = alphaTable[src[x * 4 + 3]];
+        }
+    }
+
+    void encodeRow(const float* src, uint32_t width, bool srgb, uint8_t* dst) {
+        const uint8_t* toSrgb = colorTables().linearToSrgb;
+
+#if MIP_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = srgb ? _mm_set_ps(255.0f, 65535.0f, 65535.0f, 65535.0f) : _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        for (uint32_t x = 0; x < width; ++x) {
+            __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + x * 4), zero), one);
+            __m128i i = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+
+            alignas(16) int32_t c[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(c), i);
+            if (srgb) {
+                dst[x * 4 + 0] = toSrgb[c[0]];
+                dst[x * 4 + 1] = toSrgb[c[1]];
+                dst[x * 4 + 2] = toSrgb[c[2]];
+            } else {
+                dst[x * 4 + 0] = static_cast<uint8_t>(c[0]);
+                dst[x * 4 + 1] = static_cast<uint8_t>(c[1]);
+                dst[x * 4 + 2] = static_cast<uint8_t>(c[2]);
+            }
+            dst[x * 4 + 3] = static_cast<uint8_t>(c[3]);
+        }
+#else
+        for (uint32_t x = 0; x < width; ++x) {
+            for (int c = 0; c < 4; ++c) {
+                float v = std::clamp(src[x * 4 + c], 0.0f, 1.0f);
+                dst[x * 4 + c] = srgb && c < 3
+                    ? toSrgb[static_cast<int>(v * 65535.0f + 0.5f)]
+                    : static_cast<uint8_t>(v * 255.0f + 0.5f);
+            }
+        }
+#endif
+    }
+
+    void forEachBand(uint32_t height, const std::function<void(size_t)>& filterBand) {
+        const uint32_t bands = (height + BAND_ROWS - 1) / BAND_ROWS;
+        if (bands == 1) {
+            filterBand(0);
+        } else {
+            ThreadPool::instance().parallelFor(bands, filterBand);
+        }
+    }
+
+    // Box on even sizes, the usual power-of-two case: straight 2x2 averages
+    void downsampleBox2x(const MipSurface& src, const MipSurface& dst, bool srgb) {
+        const ColorTables& tables = colorTables();
+        const float* colorTable = srgb ? tables.srgbToLinear : tables.unormToFloat;
+        const float* alphaTable = tables.unormToFloat;
+
+        forEachBand(dst.height, [&](size_t band) {
+            const uint32_t y0 = static_cast<uint32_t>(band) * BAND_ROWS;
+            const uint32_t y1 = std::min(dst.height, y0 + BAND_ROWS);
+
+            std::vector<float> top(static_cast<size_t>(src.width) * 4);
+            std::vector<float> bottom(static_cast<size_t>(src.width) * 4);
+            std::vector<float> accum(static_cast<size_t>(dst.width) * 4);
+
+            for (uint32_t y = y0; y < y1; ++y) {
+                decodeRow(src.pixels + (y * 2) * src.rowPitch, src.width, colorTable, alphaTable, top.data());
+                decodeRow(src.pixels + (y * 2 + 1) * src.rowPitch, src.width, colorTable, alphaTable, bottom.data());
+
+#if MIP_SSE2
+                const __m128 quarter = _mm_set1_ps(0.25f);
+                for (uint32_t x = 0; x < dst.width; ++x) {
+                    __m128 sum = _mm_add_ps(
+                        _mm_add_ps(_mm_loadu_ps(&top[x * 8]), _mm_loadu_ps(&top[x * 8 + 4])),
+                        _mm_add_ps(_mm_loadu_ps(&bottom[x * 8]), _mm_loadu_ps(&bottom[x * 8 + 4]))
+                    );
+                    _mm_storeu_ps(&accum[x * 4], _mm_mul_ps(sum, quarter));
+                }
+#else
+                for (uint32_t x = 0; x < dst.width; ++x) {
+                    for (int c = 0; c < 4; ++c)
+                        accum[x * 4 + c] = 0.25f * (top[x * 8 + c] + top[x * 8 + 4 + c] + bottom[x * 8 + c] + bottom[x * 8 + 4 + c]);
+                }
+#endif
+
+                encodeRow(accum.data(), dst.width, srgb, dst.pixels + y * dst.rowPitch);
+            }
+        });
+    }
+
+    void downsample(const MipSurface& src, const MipSurface& dst, bool srgb, MipFilter filter) {
+        if (filter == MipFilter::Box && src.width == dst.width * 2 && src.height == dst.height * 2) {
+            downsampleBox2x(src, dst, srgb);
+            return;
+        }
+
+        const AxisWeights horizontal = buildWeights(src.width, dst.width, filter);
+        const AxisWeights vertical = buildWeights(src.height, dst.height, filter);
+
+        const ColorTables& tables = colorTables();
+        const float* colorTable = srgb ? tables.srgbToLinear : tables.unormToFloat;
+        const float* alphaTable = tables.unormToFloat;
+
+        forEachBand(dst.height, [&](size_t band) {
+            const uint32_t y0 = static_cast<uint32_t>(band) * BAND_ROWS;
+            const uint32_t y1 = std::min(dst.height, y0 + BAND_ROWS);
+
+            // Source rows this band reads
+            const uint32_t rowBegin = vertical.first[y0];
+            const uint32_t rowEnd = std::min(src.height, vertical.first[y1 - 1] + vertical.taps);
+
+            std::vector<float> decoded(static_cast<size_t>(src.width) * 4);
+            std::vector<float> rows(static_cast<size_t>(rowEnd - rowBegin) * dst.width * 4, 0.0f);
+            std::vector<float> accum(static_cast<size_t>(dst.width) * 4);
+
+            // Horizontal pass into linear float rows
+            for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+                decodeRow(src.pixels + y * src.rowPitch, src.width, colorTable, alphaTable, decoded.data());
+
+                float* out = rows.data() + static_cast<size_t>(y - rowBegin) * dst.width * 4;
+                for (uint32_t x = 0; x < dst.width; ++x) {
+                    const float* weights = horizontal.weights.data() + static_cast<size_t>(x) * horizontal.taps;
+                    const uint32_t first = horizontal.first[x];
+                    const uint32_t taps = std::min(horizontal.taps, src.width - first);
+                    for (uint32_t t = 0; t < taps; ++t) {
+                        if (weights[t] != 0.0f)
+                            accumulate(out + x * 4, decoded.data() + (first + t) * 4, weights[t], 1);
+                    }
+                }
+            }
+
+            // Vertical pass, whole rows at a time, then back to 8 bits
+            for (uint32_t y = y0; y < y1; ++y) {
+                std::fill(accum.begin(), accum.end(), 0.0f);
+
+                const float* weights = vertical.weights.data() + static_cast<size_t>(y) * vertical.taps;
+                const uint32_t first = vertical.first[y];
+                const uint32_t taps = std::min(vertical.taps, src.height - first);
+                for (uint32_t t = 0; t < taps; ++t) {
+                    if (weights[t] != 0.0f) {
+                        const float* row = rows.data() + static_cast<size_t>(first + t - rowBegin) * dst.width * 4;
+                        accumulate(accum.data(), row, weights[t], dst.width);
+                    }
+                }
+
+                encodeRow(accum.data(), dst.width, srgb, dst.pixels + y * dst.rowPitch);
+            }
+        });
+    }
+}
+
+uint32_t mipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+void generateMips(const MipSurface* levels, uint32_t levelCount, bool srgb, MipFilter filter) {
+    if (filter == MipFilter::None)
+        return;
+
+    // Levels depend on each other; the parallelism is within a level
+    for (uint32_t level = 1; level < levelCount; ++level)
+        downsample(levels[level - 1], levels[level], srgb, filter);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU mip chain generation for 8-bit RGBA images.
+// Each level is filtered from the one above it in linear space: sRGB color is
+// decoded through a table before filtering and re-encoded after, alpha is
+// filtered as is. The work is split into bands of output rows across the
+// thread pool and pixels are filtered four channels at a time with SSE2.
+
+enum class MipFilter {
+    None,   // keep the single level
+    Box,    // area average, 2x2 on even sizes
+    Kaiser  // Kaiser-windowed sinc, sharper at the cost of some ringing
+};
+
+struct MipSurface {
+    uint8_t* pixels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t rowPitch = 0;
+};
+
+// Full chain down to 1x1
+uint32_t mipLevelCount(uint32_t width, uint32_t height);
+
+// Fills levels[1..levelCount) from levels[0]. Level i must be
+// max(1, width >> i) by max(1, height >> i).
+void generateMips(const MipSurface* levels, uint32_t levelCount, bool srgb, MipFilter filter);
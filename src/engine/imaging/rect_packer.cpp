@@ -0,0 +1,99 @@
+#include "rect_packer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+    struct SkylineSegment {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+    };
+
+    // Lowest y a rect of this width can sit at when its left edge is at segment
+    // first, UINT32_MAX when it runs past the right edge
+    uint32_t fitAt(const std::vector<SkylineSegment>& skyline, size_t first, uint32_t width, uint32_t areaWidth) {
+        const uint32_t x = skyline[first].x;
+        if (x + width > areaWidth)
+            return UINT32_MAX;
+
+        uint32_t y = 0;
+        for (size_t i = first; i < skyline.size() && skyline[i].x < x + width; ++i) {
+            y = std::max(y, skyline[i].y);
+        }
+        return y;
+    }
+
+    void place(std::vector<SkylineSegment>& skyline, size_t first, uint32_t width, uint32_t top) {
+        const uint32_t x = skyline[first].x;
+        const uint32_t right = x + width;
+
+        // Segments under the new one are cut back to what still shows to its right
+        size_t last = first;
+        while (last < skyline.size() && skyline[last].x < right) {
+            SkylineSegment& segment = skyline[last];
+            const uint32_t segmentRight = segment.x + segment.width;
+            if (segmentRight > right) {
+                segment.width = segmentRight - right;
+                segment.x = right;
+                break;
+            }
+            last++;
+        }
+
+        skyline.erase(skyline.begin() + first, skyline.begin() + last);
+        skyline.insert(skyline.begin() + first, { x, top, width });
+
+        // Neighbours at the same height become one segment
+        for (size_t i = 0; i + 1 < skyline.size();) {
+            if (skyline[i].y == skyline[i + 1].y) {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            } else {
+                ++i;
+            }
+        }
+    }
+}
+
+size_t packRects(std::span<PackRect> rects, uint32_t width, uint32_t height) {
+    std::vector<size_t> order(rects.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (rects[a].height != rects[b].height)
+            return rects[a].height > rects[b].height;
+        return rects[a].width > rects[b].width;
+    });
+
+    std::vector<SkylineSegment> skyline = { { 0, 0, width } };
+    size_t packed = 0;
+
+    for (size_t index : order) {
+        PackRect& rect = rects[index];
+        rect.packed = false;
+        if (rect.width == 0 || rect.height == 0 || rect.width > width || rect.height > height)
+            continue;
+
+        size_t best = SIZE_MAX;
+        uint32_t bestY = UINT32_MAX;
+        for (size_t i = 0; i < skyline.size(); ++i) {
+            uint32_t y = fitAt(skyline, i, rect.width, width);
+            if (y != UINT32_MAX && y + rect.height <= height && y < bestY) {
+                best = i;
+                bestY = y;
+            }
+        }
+
+        if (best == SIZE_MAX)
+            continue;
+
+        rect.x = skyline[best].x;
+        rect.y = bestY;
+        rect.packed = true;
+        place(skyline, best, rect.width, bestY + rect.height);
+        packed++;
+    }
+
+    return packed;
+}
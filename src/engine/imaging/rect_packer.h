@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Skyline bottom-left rectangle packing, for texture atlases. Each rect goes
+// where its top edge ends lowest along the skyline of those already placed,
+// tallest rects first. Padding and alignment are the caller's: pass sizes
+// that already include them.
+
+struct PackRect {
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    // Output, top-left corner
+    uint32_t x = 0;
+    uint32_t y = 0;
+    bool packed = false;
+};
+
+// Rects that don't fit keep packed = false. Returns how many were packed.
+size_t packRects(std::span<PackRect> rects, uint32_t width, uint32_t height);
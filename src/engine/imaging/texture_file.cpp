@@ -0,0 +1,383 @@
+#include "texture_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    // DXGI_FORMAT values, spelled out so this stays free of Windows headers
+    enum : uint32_t {
+        FORMAT_R8G8B8A8_UNORM = 28,
+        FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+        FORMAT_BC1_UNORM = 71,
+        FORMAT_BC1_UNORM_SRGB = 72,
+        FORMAT_BC2_UNORM = 74,
+        FORMAT_BC2_UNORM_SRGB = 75,
+        FORMAT_BC3_UNORM = 77,
+        FORMAT_BC3_UNORM_SRGB = 78,
+        FORMAT_BC4_UNORM = 80,
+        FORMAT_BC4_SNORM = 81,
+        FORMAT_BC5_UNORM = 83,
+        FORMAT_BC5_SNORM = 84,
+        FORMAT_B8G8R8A8_UNORM = 87,
+        FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+        FORMAT_BC6H_UF16 = 95,
+        FORMAT_BC6H_SF16 = 96,
+        FORMAT_BC7_UNORM = 98,
+        FORMAT_BC7_UNORM_SRGB = 99
+    };
+
+    // Bytes per 4x4 block for BC formats, per pixel otherwise; 0 if unsupported
+    uint32_t formatBytes(uint32_t format, bool& blockCompressed) {
+        blockCompressed = true;
+        switch (format) {
+            case FORMAT_BC1_UNORM: case FORMAT_BC1_UNORM_SRGB:
+            case FORMAT_BC4_UNORM: case FORMAT_BC4_SNORM:
+                return 8;
+            case FORMAT_BC2_UNORM: case FORMAT_BC2_UNORM_SRGB:
+            case FORMAT_BC3_UNORM: case FORMAT_BC3_UNORM_SRGB:
+            case FORMAT_BC5_UNORM: case FORMAT_BC5_SNORM:
+            case FORMAT_BC6H_UF16: case FORMAT_BC6H_SF16:
+            case FORMAT_BC7_UNORM: case FORMAT_BC7_UNORM_SRGB:
+                return 16;
+        }
+
+        blockCompressed = false;
+        switch (format) {
+            case FORMAT_R8G8B8A8_UNORM: case FORMAT_R8G8B8A8_UNORM_SRGB:
+            case FORMAT_B8G8R8A8_UNORM: case FORMAT_B8G8R8A8_UNORM_SRGB:
+                return 4;
+        }
+        return 0;
+    }
+
+    uint32_t fromVkFormat(uint32_t vkFormat) {
+        switch (vkFormat) {
+            case 37:  return FORMAT_R8G8B8A8_UNORM;
+            case 43:  return FORMAT_R8G8B8A8_UNORM_SRGB;
+            case 44:  return FORMAT_B8G8R8A8_UNORM;
+            case 50:  return FORMAT_B8G8R8A8_UNORM_SRGB;
+            case 131: case 133: return FORMAT_BC1_UNORM;
+            case 132: case 134: return FORMAT_BC1_UNORM_SRGB;
+            case 135: return FORMAT_BC2_UNORM;
+            case 136: return FORMAT_BC2_UNORM_SRGB;
+            case 137: return FORMAT_BC3_UNORM;
+            case 138: return FORMAT_BC3_UNORM_SRGB;
+            case 139: return FORMAT_BC4_UNORM;
+            case 140: return FORMAT_BC4_SNORM;
+            case 141: return FORMAT_BC5_UNORM;
+            case 142: return FORMAT_BC5_SNORM;
+            case 143: return FORMAT_BC6H_UF16;
+            case 144: return FORMAT_BC6H_SF16;
+            case 145: return FORMAT_BC7_UNORM;
+            case 146: return FORMAT_BC7_UNORM_SRGB;
+            default:  return 0;
+        }
+    }
+
+    constexpr uint32_t fourCC(char a, char b, char c, char d) {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+            (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+    }
+
+    uint32_t fromFourCC(uint32_t code) {
+        switch (code) {
+            case fourCC('D', 'X', 'T', '1'): return FORMAT_BC1_UNORM;
+            case fourCC('D', 'X', 'T', '2'):
+            case fourCC('D', 'X', 'T', '3'): return FORMAT_BC2_UNORM;
+            case fourCC('D', 'X', 'T', '4'):
+            case fourCC('D', 'X', 'T', '5'): return FORMAT_BC3_UNORM;
+            case fourCC('A', 'T', 'I', '1'):
+            case fourCC('B', 'C', '4', 'U'): return FORMAT_BC4_UNORM;
+            case fourCC('B', 'C', '4', 'S'): return FORMAT_BC4_SNORM;
+            case fourCC('A', 'T', 'I', '2'):
+            case fourCC('B', 'C', '5', 'U'): return FORMAT_BC5_UNORM;
+            case fourCC('B', 'C', '5', 'S'): return FORMAT_BC5_SNORM;
+            default: return 0;
+        }
+    }
+
+    uint32_t readU32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint64_t readU64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool fail(std::string* error, const char* message) {
+        if (error)
+            *error = message;
+        return false;
+    }
+
+    // Dimensions and packed sizes of each level; offsets are filled by the caller
+    bool buildLevels(TextureFileLayout& layout, uint32_t mipLevels, std::string* error) {
+        bool blockCompressed = false;
+        uint32_t bytes = formatBytes(layout.dxgiFormat, blockCompressed);
+        if (bytes == 0)
+            return fail(error, "unsupported format");
+
+        if (layout.width == 0 || layout.height == 0 || layout.width > 16384 || layout.height > 16384)
+            return fail(error, "bad dimensions");
+
+        uint32_t maxLevels = 1;
+        for (uint32_t w = layout.width, h = layout.height; w > 1 || h > 1; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+            maxLevels++;
+        if (mipLevels == 0 || mipLevels > maxLevels)
+            return fail(error, "bad mip count");
+
+        layout.blockCompressed = blockCompressed;
+        layout.levels.resize(mipLevels);
+        for (uint32_t i = 0; i < mipLevels; ++i) {
+            TextureFileLevel& level = layout.levels[i];
+            level.width = std::max(1u, layout.width >> i);
+            level.height = std::max(1u, layout.height >> i);
+            if (blockCompressed) {
+                level.rowBytes = std::max(1u, (level.width + 3) / 4) * bytes;
+                level.rowCount = std::max(1u, (level.height + 3) / 4);
+            } else {
+                level.rowBytes = level.width * bytes;
+                level.rowCount = level.height;
+            }
+        }
+        return true;
+    }
+
+    uint64_t levelSize(const TextureFileLevel& level) {
+        return static_cast<uint64_t>(level.rowBytes) * level.rowCount;
+    }
+
+    bool parseDds(const uint8_t* header, size_t headerSize, uint64_t fileSize, TextureFileLayout& layout, std::string* error) {
+        if (headerSize < 128 || readU32(header + 4) != 124)
+            return fail(error, "truncated DDS header");
+
+        const uint32_t height = readU32(header + 12);
+        const uint32_t width = readU32(header + 16);
+        const uint32_t depth = readU32(header + 24);
+        const uint32_t mipCount = readU32(header + 28);
+        const uint32_t pfFlags = readU32(header + 80);
+        const uint32_t pfFourCC = readU32(header + 84);
+        const uint32_t caps2 = readU32(header + 112);
+
+        constexpr uint32_t DDPF_FOURCC = 0x4;
+        constexpr uint32_t DDPF_RGB = 0x40;
+        constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+        constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+        if (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME) || depth > 1)
+            return fail(error, "only 2D DDS textures are supported");
+
+        uint64_t dataOffset = 128;
+        if ((pfFlags & DDPF_FOURCC) && pfFourCC == fourCC('D', 'X', '1', '0')) {
+            if (headerSize < 148)
+                return fail(error, "truncated DX10 header");
+
+            constexpr uint32_t DIMENSION_TEXTURE2D = 3;
+            constexpr uint32_t MISC_TEXTURECUBE = 0x4;
+            if (readU32(header + 132) != DIMENSION_TEXTURE2D || (readU32(header + 136) & MISC_TEXTURECUBE) || readU32(header + 140) > 1)
+                return fail(error, "only 2D DDS textures are supported");
+
+            layout.dxgiFormat = readU32(header + 128);
+            dataOffset = 148;
+        } else if (pfFlags & DDPF_FOURCC) {
+            layout.dxgiFormat = fromFourCC(pfFourCC);
+        } else if ((pfFlags & DDPF_RGB) && readU32(header + 88) == 32) {
+            const uint32_t rMask = readU32(header + 92);
+            const uint32_t bMask = readU32(header + 100);
+            if (rMask == 0x000000FF && bMask == 0x00FF0000)
+                layout.dxgiFormat = FORMAT_R8G8B8A8_UNORM;
+            else if (rMask == 0x00FF0000 && bMask == 0x000000FF)
+                layout.dxgiFormat = FORMAT_B8G8R8A8_UNORM;
+        }
+
+        layout.type = TextureFileType::Dds;
+        layout.width = width;
+        layout.height = height;
+        if (!buildLevels(layout, std::max(1u, mipCount), error))
+            return false;
+
+        uint64_t offset = dataOffset;
+        for (TextureFileLevel& level : layout.levels) {
+            level.fileOffset = offset;
+            offset += levelSize(level);
+        }
+        if (offset > fileSize)
+            return fail(error, "DDS file is truncated");
+
+        return true;
+    }
+
+    bool parseKtx2(const uint8_t* header, size_t headerSize, uint64_t fileSize, TextureFileLayout& layout, std::string* error) {
+        if (headerSize < 80)
+            return fail(error, "truncated KTX2 header");
+
+        const uint32_t vkFormat = readU32(header + 12);
+        const uint32_t width = readU32(header + 20);
+        const uint32_t height = readU32(header + 24);
+        const uint32_t depth = readU32(header + 28);
+        const uint32_t layers = readU32(header + 32);
+        const uint32_t faces = readU32(header + 36);
+        const uint32_t levelCount = std::max(1u, readU32(header + 40));
+        const uint32_t supercompression = readU32(header + 44);
+
+        if (depth > 0 || layers > 1 || faces != 1)
+            return fail(error, "only 2D KTX2 textures are supported");
+        if (supercompression != 0)
+            return fail(error, "supercompressed KTX2 is not supported");
+        if (headerSize < 80 + static_cast<size_t>(levelCount) * 24)
+            return fail(error, "truncated KTX2 level index");
+
+        layout.type = TextureFileType::Ktx2;
+        layout.dxgiFormat = fromVkFormat(vkFormat);
+        layout.width = width;
+        layout.height = height;
+        if (!buildLevels(layout, levelCount, error))
+            return false;
+
+        // The level index is explicit; levels are usually stored smallest first
+        for (uint32_t i = 0; i < levelCount; ++i) {
+            const uint8_t* entry = header + 80 + i * 24;
+            const uint64_t offset = readU64(entry);
+            const uint64_t length = readU64(entry + 8);
+
+            TextureFileLevel& level = layout.levels[i];
+            if (length != levelSize(level) || offset > fileSize || length > fileSize - offset)
+                return fail(error, "bad KTX2 level range");
+            level.fileOffset = offset;
+        }
+
+        return true;
+    }
+}
+
+bool parseTextureFile(
+    const uint8_t* header,
+    size_t headerSize,
+    uint64_t fileSize,
+    TextureFileLayout& layout,
+    std::string* error
+) {
+    static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    layout = TextureFileLayout();
+    headerSize = static_cast<size_t>(std::min<uint64_t>(headerSize, fileSize));
+
+    if (headerSize >= 4 && std::memcmp(header, "DDS ", 4) == 0)
+        return parseDds(header, headerSize, fileSize, layout, error);
+    if (headerSize >= 12 && std::memcmp(header, KTX2_IDENTIFIER, 12) == 0)
+        return parseKtx2(header, headerSize, fileSize, layout, error);
+
+    return fail(error, "not a DDS or KTX2 file");
+}
+
+uint64_t computeUploadFootprints(
+    const TextureFileLayout& layout,
+    uint64_t baseOffset,
+    std::vector<UploadFootprint>& footprints
+) {
+    footprints.resize(layout.levels.size());
+
+    uint64_t total = baseOffset;
+    for (size_t i = 0; i < layout.levels.size(); ++i) {
+        const TextureFileLevel& level = layout.levels[i];
+        UploadFootprint& footprint = footprints[i];
+
+        footprint.offset = alignUp(total, UPLOAD_PLACEMENT_ALIGNMENT);
+        footprint.width = layout.blockCompressed ? static_cast<uint32_t>(alignUp(level.width, 4)) : level.width;
+        footprint.height = layout.blockCompressed ? static_cast<uint32_t>(alignUp(level.height, 4)) : level.height;
+        footprint.rowPitch = static_cast<uint32_t>(alignUp(level.rowBytes, UPLOAD_PITCH_ALIGNMENT));
+        footprint.rowCount = level.rowCount;
+        footprint.rowBytes = level.rowBytes;
+
+        // Last row unpadded, as GetCopyableFootprints counts TotalBytes
+        total = footprint.offset + static_cast<uint64_t>(footprint.rowPitch) * (footprint.rowCount - 1) + footprint.rowBytes;
+    }
+
+    return total - baseOffset;
+}
+
+TextureFileLayout sliceTextureLevels(const TextureFileLayout& layout, uint32_t firstLevel, uint32_t levelCount) {
+    TextureFileLayout slice = layout;
+    slice.levels.clear();
+
+    const size_t first = std::min<size_t>(firstLevel, layout.levels.size());
+    const size_t last = std::min<size_t>(first + levelCount, layout.levels.size());
+    slice.levels.assign(layout.levels.begin() + first, layout.levels.begin() + last);
+
+    if (!slice.levels.empty()) {
+        slice.width = slice.levels.front().width;
+        slice.height = slice.levels.front().height;
+    }
+    return slice;
+}
+
+bool isValidTopLevel(const TextureFileLayout& layout, uint32_t level) {
+    if (level >= layout.levels.size())
+        return false;
+    if (!layout.blockCompressed)
+        return true;
+
+    const TextureFileLevel& top = layout.levels[level];
+    return top.width % 4 == 0 && top.height % 4 == 0;
+}
+
+bool readTextureLevels(
+    const std::filesystem::path& path,
+    const TextureFileLayout& layout,
+    const std::vector<UploadFootprint>& footprints,
+    uint8_t* upload,
+    std::string* error
+) {
+    if (footprints.size() != layout.levels.size())
+        return fail(error, "footprints don't match the layout");
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return fail(error, "can't open texture file");
+
+    for (size_t i = 0; i < layout.levels.size(); ++i) {
+        const TextureFileLevel& level = layout.levels[i];
+        const UploadFootprint& footprint = footprints[i];
+        uint8_t* dst = upload + footprint.offset;
+
+        file.seekg(static_cast<std::streamoff>(level.fileOffset));
+
+        if (footprint.rowPitch == level.rowBytes) {
+            file.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(levelSize(level)));
+        } else {
+            for (uint32_t row = 0; row < level.rowCount && file; ++row)
+                file.read(reinterpret_cast<char*>(dst + static_cast<uint64_t>(row) * footprint.rowPitch), level.rowBytes);
+        }
+
+        if (!file)
+            return fail(error, "texture file ended early");
+    }
+
+    return true;
+}
+
+bool readTextureFileLayout(
+    const std::filesystem::path& path,
+    TextureFileLayout& layout,
+    std::string* error
+) {
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec)
+        return fail(error, "can't open texture file");
+
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[TEXTURE_FILE_HEADER_BYTES];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+    return parseTextureFile(header, static_cast<size_t>(file.gcount()), fileSize, layout, error);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Cooked texture files (DDS, KTX2) read without an intermediate image.
+// Pure C++ and device-free: the header parse, the upload buffer layout and the
+// copy from disk into that layout can all run against plain memory, so the
+// same math the renderer uses is checkable on its own.
+//
+// Only plain 2D textures with mips: no arrays, cubes, volumes or KTX2
+// supercompression.
+
+enum class TextureFileType {
+    Dds,
+    Ktx2
+};
+
+// One mip as stored in the file, rows tightly packed
+struct TextureFileLevel {
+    uint64_t fileOffset = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowBytes = 0;  // one row of pixels, or of 4x4 blocks
+    uint32_t rowCount = 0;
+};
+
+struct TextureFileLayout {
+    TextureFileType type = TextureFileType::Dds;
+    uint32_t dxgiFormat = 0; // DXGI_FORMAT value, the same for KTX2 after mapping
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool blockCompressed = false;
+    std::vector<TextureFileLevel> levels;
+};
+
+// Where one mip goes in the upload buffer, laid out the way
+// ID3D12Device::GetCopyableFootprints does: 512-byte aligned offsets and
+// 256-byte aligned row pitch. Width/height are padded to whole blocks.
+struct UploadFootprint {
+    uint64_t offset = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowPitch = 0;
+    uint32_t rowCount = 0;
+    uint32_t rowBytes = 0;
+};
+
+constexpr uint64_t UPLOAD_PLACEMENT_ALIGNMENT = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+constexpr uint32_t UPLOAD_PITCH_ALIGNMENT = 256;     // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+
+// Largest header plus level index parseTextureFile needs to see
+constexpr size_t TEXTURE_FILE_HEADER_BYTES = 80 + 24 * 16;
+
+// header holds at least the start of the file (the whole file is fine).
+// fileSize bounds the level ranges. False for other files or unsupported layouts.
+bool parseTextureFile(
+    const uint8_t* header,
+    size_t headerSize,
+    uint64_t fileSize,
+    TextureFileLayout& layout,
+    std::string* error = nullptr
+);
+
+// Same, reading just the header from disk
+bool readTextureFileLayout(
+    const std::filesystem::path& path,
+    TextureFileLayout& layout,
+    std::string* error = nullptr
+);
+
+// Fills one footprint per level, returns the upload buffer size
+uint64_t computeUploadFootprints(
+    const TextureFileLayout& layout,
+    uint64_t baseOffset,
+    std::vector<UploadFootprint>& footprints
+);
+
+// Levels [firstLevel, firstLevel + levelCount) as a layout of their own, with the
+// first of them as the top mip. File offsets are kept, so the result works with
+// computeUploadFootprints and readTextureLevels to load part of a chain.
+TextureFileLayout sliceTextureLevels(const TextureFileLayout& layout, uint32_t firstLevel, uint32_t levelCount);
+
+// Whether a texture can start at this level: block compressed resources need a
+// top mip made of whole 4x4 blocks. Level 0 is held to it too, only GPUs with
+// UnalignedBlockTexturesSupported take a partial block there.
+bool isValidTopLevel(const TextureFileLayout& layout, uint32_t level);
+
+// Reads every level from the file into upload at its footprint. Whole levels
+// go in one read when the file and upload pitches agree, otherwise row by row.
+bool readTextureLevels(
+    const std::filesystem::path& path,
+    const TextureFileLayout& layout,
+    const std::vector<UploadFootprint>& footprints,
+    uint8_t* upload,
+    std::string* error = nullptr
+);
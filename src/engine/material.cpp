@@ -3,9 +3,20 @@
 #include "material.h"
 #include "engine/resources/texture.h"
 
-void Material::bind(ID3D12GraphicsCommandList* cmdList, UINT rootIndex) {
+void Material::bind(ID3D12GraphicsCommandList* cmdList, const MaterialSlots& slots) {
     LOG_INFO(L"[Material] bind() called");
 
+    // The shader skips the mask fetch when every channel is -1
+    if (slots.maskChannels != UINT_MAX) {
+        if (maskTexture && slots.maskTexture != UINT_MAX) {
+            cmdList->SetGraphicsRootDescriptorTable(slots.maskTexture, maskTexture->getGPUHandle());
+            cmdList->SetGraphicsRoot32BitConstants(slots.maskChannels, MASK_CHANNEL_COUNT, maskLayout.channels, 0);
+        } else {
+            const ChannelLayout none;
+            cmdList->SetGraphicsRoot32BitConstants(slots.maskChannels, MASK_CHANNEL_COUNT, none.channels, 0);
+        }
+    }
+
     if (!texture) {
         LOG_INFO(L"[Material] texture is nullptr!");
         return;
@@ -20,9 +31,9 @@ void Material::bind(ID3D12GraphicsCommandList* cmdList, UINT rootIndex) {
 
     LOG_INFO(L"[Material] GPU handle = 0x%llX", gpuHandle.ptr);
 
-    cmdList->SetGraphicsRootDescriptorTable(rootIndex, gpuHandle);
+    cmdList->SetGraphicsRootDescriptorTable(slots.texture, gpuHandle);
     LOG_INFO(L"[Material] Texture bound successfully: rootIndex=%u, GPU handle=0x%llX",
-             rootIndex, gpuHandle.ptr);
+             slots.texture, gpuHandle.ptr);
 }
 
 
@@ -1,9 +1,18 @@
 #pragma once
 
 #include "utils/pch.h"
+#include "engine/imaging/channel_pack.h"
 
 class Texture;
 
+// Root parameters Material::bind writes. The mask ones are optional, UINT_MAX
+// when the pipeline has no packed mask map.
+struct MaterialSlots {
+    UINT texture = 0;       // diffuse SRV table
+    UINT maskTexture = UINT_MAX;  // packed mask SRV table
+    UINT maskChannels = UINT_MAX; // 4 x 32-bit root constants, the ChannelLayout
+};
+
 class Material
 {
     public:
@@ -12,8 +21,25 @@ class Material
         
         ~Material() = default;
 
-        void bind(ID3D12GraphicsCommandList* cmdList, UINT rootIndex);
+        void bind(ID3D12GraphicsCommandList* cmdList, const MaterialSlots& slots);
+
+        // Cooked channel-packed occlusion / roughness / metalness / specular, see channel_pack.h
+        void setMask(std::shared_ptr<Texture> mask, const ChannelLayout& layout) {
+            maskTexture = mask;
+            maskLayout = layout;
+        }
+
+        Texture* getTexture() const {
+            return texture.get();
+        }
+
+        Texture* getMaskTexture() const {
+            return maskTexture.get();
+        }
 
     private:
         std::shared_ptr<Texture> texture;
+
+        std::shared_ptr<Texture> maskTexture;
+        ChannelLayout maskLayout; // all -1 without a mask
 };
@@ -1,28 +1,145 @@
 #include "mesh.h"
 
 #include "material.h"
+#include "engine/geometry/mesh_optimizer.h"
+#include "engine/resources/texture.h"
+
+namespace {
+    // Square root of UV area over model-space area, i.e. UV units per model unit
+    float computeUvDensity(std::span<const VertexStruct> vertices, std::span<const uint32_t> indices) {
+        double area = 0.0;
+        double uvArea = 0.0;
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const VertexStruct& a = vertices[indices[i]];
+            const VertexStruct& b = vertices[indices[i + 1]];
+            const VertexStruct& c = vertices[indices[i + 2]];
+
+            XMVECTOR edge1 = XMVectorSubtract(XMLoadFloat4(&b.position), XMLoadFloat4(&a.position));
+            XMVECTOR edge2 = XMVectorSubtract(XMLoadFloat4(&c.position), XMLoadFloat4(&a.position));
+            area += 0.5 * XMVectorGetX(XMVector3Length(XMVector3Cross(edge1, edge2)));
+
+            float du1 = b.texcoord.x - a.texcoord.x, dv1 = b.texcoord.y - a.texcoord.y;
+            float du2 = c.texcoord.x - a.texcoord.x, dv2 = c.texcoord.y - a.texcoord.y;
+            uvArea += 0.5 * std::abs(du1 * dv2 - du2 * dv1);
+        }
+
+        return area > 0.0 ? static_cast<float>(std::sqrt(uvArea / area)) : 0.0f;
+    }
+}
 
 Mesh::Mesh(
     ComPtr<ID3D12Device2> device, 
-    const std::vector<VertexStruct>& vertices,
-    const std::vector<uint32_t>& indices,
-    std::shared_ptr<Material> mat
+    GeometryPool* geometry,
+    std::span<const VertexStruct> vertices,
+    std::span<const uint32_t> indices,
+    std::shared_ptr<Material> mat,
+    const MeshOptions& options
 ) : 
     device(device),
-    material(mat)
+    geometry(geometry),
+    boundsCenter(options.boundsCenter),
+    boundsRadius(options.boundsRadius),
+    material(mat),
+    format(options.format)
 {
-    LOG_INFO(L"MeshBuffer -> Creating vertex and index buffers...");
-    vertex = std::make_unique<VertexBuffer>(
-        device,
-        vertices
-    );
-    
-    index = std::make_unique<IndexBuffer>(
-        device,
-        indices
+    LOG_INFO(L"MeshBuffer -> Allocating vertex and index ranges...");
+    const UINT vertexCount = static_cast<UINT>(vertices.size());
+
+    if (format == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed;
+        dequant = packVertices(vertices, packed);
+
+        VertexStream stream = { packed.data(), getVertexStride(format) };
+        vertexRange = geometry->allocateVertices({ &stream, 1 }, vertexCount);
+    } else if (format == VertexFormat::Split) {
+        std::vector<XMFLOAT3> positions;
+        std::vector<VertexAttributes> attributeData;
+        splitVertices(vertices, positions, attributeData);
+
+        VertexStream streams[] = {
+            { positions.data(), getVertexStride(format) },
+            { attributeData.data(), static_cast<UINT>(sizeof(VertexAttributes)) }
+        };
+        vertexRange = geometry->allocateVertices(streams, vertexCount);
+    } else {
+        VertexStream stream = { vertices.data(), static_cast<UINT>(sizeof(VertexStruct)) };
+        vertexRange = geometry->allocateVertices({ &stream, 1 }, vertexCount);
+    }
+
+    indexRange = geometry->allocateIndices(indices);
+
+    if (options.lods.empty()) {
+        lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+    } else {
+        lods.assign(options.lods.begin(), options.lods.end());
+        LOG_INFO(L"MeshBuffer -> %zu LODs, %u -> %u triangles",
+            lods.size(), lods.front().indexCount / 3, lods.back().indexCount / 3);
+    }
+
+    // Depth stream and meshlets only cover LOD 0
+    std::span<const uint32_t> lod0 = indices.subspan(lods[0].indexOffset, lods[0].indexCount);
+
+    if (!vertices.empty()) {
+        uvDensity = computeUvDensity(vertices, lod0);
+    }
+
+    if (options.depthStream && !vertices.empty()) {
+        createDepthStream(vertices, lod0);
+    }
+
+    if (!options.meshlets.empty()) {
+        meshlets.assign(options.meshlets.begin(), options.meshlets.end());
+        cpuIndices.assign(lod0.begin(), lod0.end());
+        culledScratch.reserve(lod0.size());
+
+        const DXGI_FORMAT indexFormat = geometry->getIndexView(indexRange).Format;
+        for (auto& buffer : culledIndex) {
+            buffer = std::make_unique<IndexBuffer>(device, static_cast<UINT>(lod0.size()), indexFormat);
+        }
+
+        LOG_INFO(L"MeshBuffer -> %zu meshlets for culling", meshlets.size());
+    }
+
+    LOG_INFO(L"MeshBuffer -> %u vertices at %u, %u indices at %u", vertexRange.count, vertexRange.offset, indexRange.count, indexRange.offset);
+}
+
+Mesh::~Mesh() {
+    geometry->free(vertexRange);
+    geometry->free(indexRange);
+    geometry->free(depthVertexRange);
+    geometry->free(depthIndexRange);
+}
+
+void Mesh::createDepthStream(std::span<const VertexStruct> vertices, std::span<const uint32_t> indices) {
+    std::vector<uint32_t> remap;
+    size_t uniqueCount = generatePositionRemap(
+        &vertices[0].position.x,
+        vertices.size(),
+        sizeof(VertexStruct),
+        remap
     );
 
-    LOG_INFO(L"MeshBuffer -> Buffers created successfully.");
+    std::vector<XMFLOAT3> positions(uniqueCount);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        positions[remap[i]] = { vertices[i].position.x, vertices[i].position.y, vertices[i].position.z };
+    }
+
+    std::vector<uint32_t> depthIndices(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        depthIndices[i] = remap[indices[i]];
+    }
+
+    // Welding changes which vertices are shared, so re-run the cache ordering on the new list
+    optimizeVertexCache(depthIndices, uniqueCount);
+
+    VertexStream stream = { positions.data(), static_cast<UINT>(sizeof(XMFLOAT3)) };
+    depthVertexRange = geometry->allocateVertices({ &stream, 1 }, static_cast<UINT>(positions.size()));
+    depthIndexRange = geometry->allocateIndices(depthIndices);
+
+    LOG_INFO(L"MeshBuffer -> Depth stream: %zu -> %zu vertices, %zu -> %zu bytes",
+        vertices.size(), uniqueCount,
+        vertices.size() * static_cast<size_t>(getVertexStride(format)), uniqueCount * sizeof(XMFLOAT3));
 }
 
 // void Mesh::draw(
@@ -45,21 +162,26 @@ Mesh::Mesh(
 
 void Mesh::draw(
     ID3D12GraphicsCommandList* cmdList,
-    UINT rootIndex
+    const MaterialSlots& materialSlots,
+    UINT dequantRootIndex,
+    bool bindMaterial,
+    GeometryBindState* bindings
 ) {
     LOG_INFO(
         L"[Mesh] draw() called: vertices=%u, indices=%u",
-        static_cast<UINT>(vertex->getCount()),
-        static_cast<UINT>(index->getCount())
+        vertexRange.count,
+        indexRange.count
     );
 
-    if (material) {
-        LOG_INFO(L"[Mesh] Binding material texture at root index %u", rootIndex);
+    if (material && !bindMaterial) {
+        LOG_INFO(L"[Mesh] Material already bound by the previous draw");
+    } else if (material) {
+        LOG_INFO(L"[Mesh] Binding material texture at root index %u", materialSlots.texture);
 
         // Dump any pending D3D12 debug messages BEFORE binding
         LOG_D3D12_MESSAGES(device);
 
-        material->bind(cmdList, rootIndex);
+        material->bind(cmdList, materialSlots);
 
         // Dump any D3D12 debug messages AFTER binding
         LOG_D3D12_MESSAGES(device);
@@ -67,26 +189,149 @@ void Mesh::draw(
         LOG_INFO(L"[Mesh] No material assigned, skipping texture binding");
     }
 
-    // Set vertex and index buffers
-    auto vbView = vertex->getView();
-    auto ibView = index->getView();
-    auto indexCount = index->getCount();
+    // Indices: a coarser LOD range, the culled list if cull() ran, else LOD 0
+    IndexBuffer* culled = currentLod > 0 ? nullptr : activeIndex;
+    D3D12_INDEX_BUFFER_VIEW ibView = geometry->getIndexView(indexRange);
+    UINT startIndex = indexRange.offset + lods[currentLod].indexOffset;
+    UINT indexCount = lods[currentLod].indexCount;
+
+    if (culled) {
+        ibView = culled->getView();
+        startIndex = 0;
+        indexCount = culled->getCount();
+    }
+
+    if (indexCount == 0) {
+        LOG_INFO(L"[Mesh] Everything culled, skipping draw");
+        return;
+    }
+
+    D3D12_VERTEX_BUFFER_VIEW vbViews[2] = {};
+    const UINT streamCount = geometry->getVertexViews(vertexRange, vbViews);
 
     LOG_INFO(
-        L"[Mesh] Setting vertex and index buffers: vb=%p, ib=%p, indexCount=%u",
-        vbView.BufferLocation,
+        L"[Mesh] Vertex and index views: vb=%p, ib=%p, baseVertex=%u, startIndex=%u, indexCount=%u",
+        vbViews[0].BufferLocation,
         ibView.BufferLocation,
+        vertexRange.offset,
+        startIndex,
         indexCount
     );
 
-    cmdList->IASetVertexBuffers(0, 1, &vbView);
-    cmdList->IASetIndexBuffer(&ibView);
+    // Meshes in the same arenas share views, only the first one of a run binds
+    GeometryBindState unbound;
+    GeometryBindState& state = bindings ? *bindings : unbound;
+    state.setVertexBuffers(cmdList, { vbViews, streamCount });
+    state.setIndexBuffer(cmdList, ibView);
     cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    LOG_INFO(L"[Mesh] Drawing indexed instanced");
-    cmdList->DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
+    // Packed positions are unorm over the mesh bounds
+    if (format == VertexFormat::Packed && dequantRootIndex != UINT_MAX) {
+        cmdList->SetGraphicsRoot32BitConstants(dequantRootIndex, sizeof(VertexDequant) / 4, &dequant, 0);
+    }
+
+    LOG_INFO(L"[Mesh] Drawing indexed instanced, LOD %u", currentLod);
+    cmdList->DrawIndexedInstanced(indexCount, 1, startIndex, static_cast<INT>(vertexRange.offset), 0);
 
     LOG_INFO(L"[Mesh] Draw call completed");
 }
 
+UINT Mesh::selectLod(const float eye[3], float pixelScale, float threshold, float hysteresis) {
+    if (lods.size() < 2)
+        return currentLod;
+
+    float dx = eye[0] - boundsCenter.x;
+    float dy = eye[1] - boundsCenter.y;
+    float dz = eye[2] - boundsCenter.z;
+
+    // Distance to the bounding sphere, inside it everything counts as very close
+    float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - boundsRadius, 1e-4f);
+
+    auto projectedError = [&](UINT level) {
+        return lods[level].error * pixelScale / distance;
+    };
+
+    while (currentLod > 0 && projectedError(currentLod) > threshold) {
+        currentLod--;
+    }
+
+    while (currentLod + 1 < lods.size() && projectedError(currentLod + 1) <= threshold * hysteresis) {
+        currentLod++;
+    }
+
+    return currentLod;
+}
+
+void Mesh::requestTextureMip(const float eye[3], float pixelScale) const {
+    if (!material || uvDensity <= 0.0f)
+        return;
+
+    float dx = eye[0] - boundsCenter.x;
+    float dy = eye[1] - boundsCenter.y;
+    float dz = eye[2] - boundsCenter.z;
+    float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - boundsRadius, 1e-4f);
+    float pixelsPerUnit = pixelScale / distance;
+
+    // Texels of mip 0 per model unit against pixels per model unit at that distance,
+    // every halving of the ratio is one mip further down. The mask shares the UVs
+    // but may be cooked at a different size, so each texture scales by its own.
+    for (Texture* texture : { material->getTexture(), material->getMaskTexture() }) {
+        if (!texture || !texture->isStreamable())
+            continue;
 
+        const TextureFileLayout& layout = texture->getFileLayout();
+        float texelsPerUnit = uvDensity * static_cast<float>(std::max(layout.width, layout.height));
+        float ratio = texelsPerUnit / pixelsPerUnit;
+
+        UINT mip = ratio > 1.0f ? static_cast<UINT>(std::floor(std::log2(ratio))) : 0;
+        texture->requestMip(mip);
+    }
+}
+
+MeshletCullStats Mesh::cull(const CullFrustum& frustum, const float eye[3], UINT frameIndex) {
+    if (meshlets.empty() || currentLod > 0) {
+        MeshletCullStats stats;
+        stats.trianglesTotal = lods[0].indexCount / 3;
+        stats.trianglesVisible = lods[currentLod].indexCount / 3;
+        activeIndex = nullptr;
+        return stats;
+    }
+
+    culledScratch.clear();
+    MeshletCullStats stats = cullMeshlets(meshlets, cpuIndices, frustum, eye, culledScratch);
+
+    IndexBuffer* buffer = culledIndex[frameIndex % FRAMEBUFFERCOUNT].get();
+    buffer->update(culledScratch);
+    activeIndex = buffer;
+
+    return stats;
+}
+
+void Mesh::drawDepth(ID3D12GraphicsCommandList* cmdList, GeometryBindState* bindings) {
+    const GeometryRange* positions = depthVertexRange ? &depthVertexRange : nullptr;
+    const GeometryRange* indices = &depthIndexRange;
+    UINT indexCount = depthIndexRange.count;
+
+    // The Split position stream shares the main indices, where LOD 0 comes first
+    if (!positions && format == VertexFormat::Split) {
+        positions = &vertexRange;
+        indices = &indexRange;
+        indexCount = lods[0].indexCount;
+    }
+
+    if (!positions) {
+        LOG_WARNING(L"[Mesh] drawDepth() needs a depth stream or the Split format, skipping");
+        return;
+    }
+
+    // Slot 0 only, for Split that is the position stream
+    D3D12_VERTEX_BUFFER_VIEW vbViews[2] = {};
+    geometry->getVertexViews(*positions, vbViews);
+
+    GeometryBindState unbound;
+    GeometryBindState& state = bindings ? *bindings : unbound;
+    state.setVertexBuffers(cmdList, { vbViews, 1 });
+    state.setIndexBuffer(cmdList, geometry->getIndexView(*indices));
+    cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    cmdList->DrawIndexedInstanced(indexCount, 1, indices->offset, static_cast<INT>(positions->offset), 0);
+}
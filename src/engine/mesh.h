@@ -1,40 +1,147 @@
 #pragma once
 
 #include "utils/pch.h"
-#include "engine/resources/vertex.h"
 #include "engine/resources/index.h"
+#include "engine/resources/geometry_pool.h"
+#include "engine/geometry/vertex_format.h"
+#include "engine/geometry/meshlet.h"
+#include "engine/geometry/mesh_simplifier.h"
 
 class Material;
+struct MaterialSlots;
+
+// Everything past the buffers themselves, defaults give a plain full-vertex mesh
+struct MeshOptions {
+    VertexFormat format = VertexFormat::Full;
+    bool depthStream = false;
+    std::span<const Meshlet> meshlets;
+
+    // LOD ranges inside indices (LOD 0 first) and the model-space bounding sphere
+    // they are selected with. Empty means indices is a single level.
+    std::span<const MeshLod> lods;
+    XMFLOAT3 boundsCenter = { 0.0f, 0.0f, 0.0f };
+    float boundsRadius = 0.0f;
+};
 
 class Mesh {
     public:
+        // Vertices and indices are suballocated from geometry and freed with the mesh
         Mesh(
             ComPtr<ID3D12Device2> device, 
-            const std::vector<VertexStruct>& vertices,
-            const std::vector<uint32_t>& indices,
-            std::shared_ptr<Material> mat
+            GeometryPool* geometry,
+            std::span<const VertexStruct> vertices,
+            std::span<const uint32_t> indices,
+            std::shared_ptr<Material> mat,
+            const MeshOptions& options = {}
         );
 
-        ~Mesh() = default;
+        ~Mesh();
+
+        // Base vertex and first index in the pool, every LOD's indexOffset is relative to it
+        const GeometryRange& getVertexRange() const {
+            return vertexRange;
+        }
+
+        const GeometryRange& getIndexRange() const {
+            return indexRange;
+        }
+
+        VertexFormat getFormat() const {
+            return format;
+        }
+
+        bool hasDepthStream() const {
+            return static_cast<bool>(depthVertexRange);
+        }
+
+        const Material* getMaterial() const {
+            return material.get();
+        }
+
+        bool hasMeshlets() const {
+            return !meshlets.empty();
+        }
+
+        UINT getLodCount() const {
+            return static_cast<UINT>(lods.size());
+        }
+
+        UINT getCurrentLod() const {
+            return currentLod;
+        }
+
+        const MeshLod& getLod(UINT level) const {
+            return lods[level];
+        }
 
-        VertexBuffer* getVertex() const {
-            return vertex.get();
-        }   
+        // Picks the coarsest LOD whose error projects to at most threshold pixels.
+        // eye is in model space, pixelScale = projection._22 * viewport height / 2.
+        // Going coarser needs the error under threshold * hysteresis, so a mesh sitting
+        // right at a switch distance doesn't flip back and forth every frame.
+        UINT selectLod(const float eye[3], float pixelScale, float threshold, float hysteresis);
 
-        IndexBuffer* getIndex() const {
-            return index.get();
-        } 
+        // Asks the material's texture and packed mask for the mip whose texels come closest to one per
+        // pixel at the bounding sphere's nearest point, from the mesh's UV density.
+        // Same eye and pixelScale as selectLod(). Only streamed textures take requests.
+        void requestTextureMip(const float eye[3], float pixelScale) const;
 
+        // UV units per model-space unit over LOD 0, averaged by area
+        float getUvDensity() const {
+            return uvDensity;
+        }
+
+        // CPU cluster culling: frustum + normal cone per meshlet, survivors go into this
+        // frame's index buffer and draw() uses it until the next cull. frameIndex picks
+        // one of FRAMEBUFFERCOUNT buffers so frames still in flight keep theirs.
+        // Meshlets describe LOD 0 only, coarser LODs are drawn whole.
+        MeshletCullStats cull(const CullFrustum& frustum, const float eye[3], UINT frameIndex);
+
+        // dequantRootIndex is the 8 x 32-bit root constant slot for packed meshes, unused for full ones.
+        // bindMaterial = false keeps the texture the previous draw bound (same material).
+        // bindings skips vertex/index views the list already has, null binds every time.
         void draw(
             ID3D12GraphicsCommandList* cmdList,
-            UINT rootIndex
+            const MaterialSlots& materialSlots,
+            UINT dequantRootIndex = UINT_MAX,
+            bool bindMaterial = true,
+            GeometryBindState* bindings = nullptr
         );
 
+        // Positions only, for depth prepass / shadow pipelines built with getDepthInputLayout().
+        // Uses the welded depth stream if there is one, else the Split position stream.
+        void drawDepth(ID3D12GraphicsCommandList* cmdList, GeometryBindState* bindings = nullptr);
+
+    private:
+        void createDepthStream(std::span<const VertexStruct> vertices, std::span<const uint32_t> indices);
+
     private:
         ComPtr<ID3D12Device2> device;
-        
-        std::unique_ptr<VertexBuffer> vertex;
-        std::unique_ptr<IndexBuffer> index;
+        GeometryPool* geometry = nullptr;
+
+        // Interleaved, or positions + attributes when Split (one base vertex for both)
+        GeometryRange vertexRange;
+        GeometryRange indexRange;
+
+        // Position-only welded copy, seams in normals/UVs don't split vertices here
+        GeometryRange depthVertexRange;
+        GeometryRange depthIndexRange;
+
+        // Meshlet culling, CPU index copy to compact from + one output buffer per frame
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> cpuIndices;
+        std::vector<uint32_t> culledScratch;
+        std::unique_ptr<IndexBuffer> culledIndex[FRAMEBUFFERCOUNT];
+        IndexBuffer* activeIndex = nullptr; // null draws from indexRange
+
+        // All levels live in indexRange, selectLod() picks the range draw() uses
+        std::vector<MeshLod> lods;
+        UINT currentLod = 0;
+        XMFLOAT3 boundsCenter = { 0.0f, 0.0f, 0.0f };
+        float boundsRadius = 0.0f;
+        float uvDensity = 0.0f;
 
         std::shared_ptr<Material> material;
+
+        VertexFormat format = VertexFormat::Full;
+        VertexDequant dequant;
 };
\ No newline at end of file
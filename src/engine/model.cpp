@@ -2,24 +2,62 @@
 
 #include "model.h"
 #include "mesh.h"
-#include "descriptor_heap.h"
-#include "command_queue.h"
+#include "resources/texture_cache.h"
+#include "resources/upload_ring.h"
 
-#include <assimp/scene.h>
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
+#include "geometry/model_importer.h"
+#include "utils/thread_pool.h"
+
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
+namespace {
+    // A LOD is used once its error covers no more than this many pixels
+    constexpr float LOD_PIXEL_ERROR = 1.0f;
+    constexpr float LOD_HYSTERESIS = 0.8f;
+
+    // UVs this close outside [0, 1] still count as inside for atlas packing
+    constexpr float ATLAS_UV_TOLERANCE = 1e-3f;
+
+    bool uvsInUnitRange(std::span<const VertexStruct> vertices) {
+        for (const VertexStruct& v : vertices) {
+            if (v.texcoord.x < -ATLAS_UV_TOLERANCE || v.texcoord.x > 1.0f + ATLAS_UV_TOLERANCE ||
+                v.texcoord.y < -ATLAS_UV_TOLERANCE || v.texcoord.y > 1.0f + ATLAS_UV_TOLERANCE)
+                return false;
+        }
+        return true;
+    }
+}
+
 Model::Model(
     ComPtr<ID3D12Device2> device, 
-    CommandQueue* uploadQueue, 
-    DescriptorHeap* srvHeap, 
-    const std::string& path
+    UploadRing* uploads, 
+    GeometryPool* geometry, 
+    TextureCache* textureCache, 
+    const std::string& path,
+    const ImportSettings& settings
+) :
+    Model(Deferred{}, device, uploads, geometry, textureCache, path, settings)
+{
+    importMeshes(path);
+    createResources();
+}
+
+Model::Model(
+    Deferred,
+    ComPtr<ID3D12Device2> device, 
+    UploadRing* uploads, 
+    GeometryPool* geometry, 
+    TextureCache* textureCache, 
+    const std::string& path,
+    const ImportSettings& settings
 ) :
     device(device), 
-    uploadQueue(uploadQueue), 
-    srvHeap(srvHeap)
+    uploads(uploads), 
+    geometry(geometry), 
+    textureCache(textureCache),
+    settings(settings)
 {
     // store model folder for resolving relative texture paths
     try {
@@ -27,49 +65,96 @@ Model::Model(
     } catch (...) {
         directory.clear();
     }
+}
+
+std::vector<std::unique_ptr<Model>> Model::loadMany(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    GeometryPool* geometry,
+    TextureCache* textureCache,
+    std::span<const std::string> paths,
+    const ImportSettings& settings
+) {
+    std::vector<std::unique_ptr<Model>> models;
+    models.reserve(paths.size());
+    for (const std::string& path : paths) {
+        models.push_back(std::unique_ptr<Model>(new Model(Deferred{}, device, uploads, geometry, textureCache, path, settings)));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Each job runs its own importer; mesh conversion inside nests on the same pool
+    ThreadPool::instance().parallelFor(models.size(), [&](size_t i) {
+        models[i]->importMeshes(paths[i]);
+    });
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_INFO(L"Model -> Imported %zu models in %.2f ms", models.size(), ms);
 
-    // at top of loadModel() after you have validated `uploadQueue`
-    if (uploadQueue) {
-        uploadCmdList = uploadQueue->getCommandList();
-        LOG_INFO(L"[Model] Using upload command list from uploadQueue: %p", uploadCmdList.Get());
+    for (auto& model : models) {
+        model->createResources();
     }
 
-    loadModel(path);
+    return models;
 }
 
-void Model::loadModel(const std::string& path) {
+void Model::importMeshes(const std::string& path) {
     LOG_INFO(L"Model -> Loading from path: %hs", path.c_str());
 
-    Assimp::Importer importer;
+    const MeshCache::Key cacheKey = MeshCache::makeKey(path, ModelImporter::getImportFlags(), settings.hash());
+    const std::string cachePath = MeshCache::getCachePath(path);
 
-    const aiScene* scene = importer.ReadFile(
-        path,
-        aiProcess_Triangulate |
-        aiProcess_CalcTangentSpace |
-        aiProcess_GenSmoothNormals |
-        aiProcess_FlipUVs
-    );
+    // Warm start: views point into the mapped cache and get copied straight into upload memory
+    if (cache.open(cachePath, cacheKey)) {
+        LOG_INFO(L"Model -> Using cooked mesh cache, skipping import");
 
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        LOG_ERROR(L"Model -> Assimp failed: %hs", importer.GetErrorString());
-        throw std::runtime_error("Assimp failed to load model");
+        importedViews = cache.getMeshes();
+        for (const MeshView& view : importedViews) {
+            if (!view.diffuseTexture.empty())
+                textureCache->prefetch(resolveTexturePath(std::string(view.diffuseTexture)));
+        }
+        return;
     }
 
+    // .obj goes through the native loader, everything else through Assimp.
+    // Textures start decoding on the pool as soon as each mesh names one.
+    ModelImporter importer(settings);
+    importer.setTextureCallback([this](const std::string& texture) {
+        textureCache->prefetch(resolveTexturePath(texture));
+    });
+    LOG_INFO(L"Model -> Importing with %hs", importer.usesNativeLoader(path) ? "native OBJ loader" : "Assimp");
+
+    importedMeshes = importer.import(path);
+
+    MeshCache::write(cachePath, cacheKey, importedMeshes);
+
+    importedViews.reserve(importedMeshes.size());
+    for (const MeshData& data : importedMeshes) {
+        importedViews.push_back(data.view());
+    }
+}
+
+void Model::createResources() {
     // Reset bounds
     globalMin = { FLT_MAX,  FLT_MAX,  FLT_MAX };
     globalMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
-    processNode(scene->mRootNode, scene);
-
-    if (uploadCmdList && uploadQueue) {
-        UINT64 fence = uploadQueue->executeCommandList(uploadCmdList);
+    createMeshes(importedViews);
 
-        uploadQueue->fenceWait(fence);
+    // Buffers hold their own copies now
+    importedViews.clear();
+    importedMeshes.clear();
+    importedMeshes.shrink_to_fit();
+    cache.close();
 
-        LOG_INFO(L"[Model] Texture uploads submitted and completed (fence=%llu)", fence);
+    // Earlier batches went out while importing. Nothing to wait for: draws go on
+    // the same queue, and the ring takes its space back once the fence passes.
+    UINT64 fence = uploads->submit();
+    LOG_INFO(L"[Model] Texture uploads submitted (fence=%llu)", fence);
 
-        uploadCmdList.Reset();
-    }
+    // Geometry copies run on the copy queue; the draw side waits on the GPU, not here
+    geometryFence = geometry->submit();
+    LOG_INFO(L"[Model] Geometry uploads submitted (copy fence=%llu)", geometryFence);
 
     // Compute global bounding sphere
     XMFLOAT3 extent = {
@@ -97,179 +182,282 @@ void Model::loadModel(const std::string& path) {
         boundingRadius);
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene) {
-    // Process all the meshes at this node
-    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
-    }
+void Model::createMeshes(std::span<const MeshView> views) {
+    // Texture requests first, one per distinct path, so uploads are recorded back to back.
+    // The cache hands back textures other models (or earlier meshes) already loaded, and
+    // the rest were decoding on the pool since importMeshes() named them.
+    std::unordered_map<std::string_view, std::shared_ptr<Texture>> texturesByName;
+
+    // Channel-packed masks the texture cooker wrote for the material, found by the
+    // diffuse texture's key (see channel_pack.h). One texture for all of its maps.
+    struct PackedMask {
+        std::shared_ptr<Texture> texture;
+        ChannelLayout layout;
+    };
+    std::unordered_map<std::string_view, PackedMask> masksByName;
 
-    // Then process all children
-    for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
-    }
-}
+    for (const MeshView& view : views) {
+        if (view.diffuseTexture.empty() || masksByName.count(view.diffuseTexture))
+            continue;
 
-std::unique_ptr<Mesh> Model::processMesh(aiMesh* mesh, const aiScene* scene) {
-    LOG_INFO(L"[Model] Processing mesh: %hs, Vertices: %u, Faces: %u",
-        mesh->mName.C_Str(),
-        mesh->mNumVertices,
-        mesh->mNumFaces
-    );
+        fs::path diffuse(resolveTexturePath(std::string(view.diffuseTexture)));
+        const std::string key = channelPackKey(diffuse);
+        const fs::path maskPath = channelPackPath(diffuse.parent_path(), key);
 
-    std::vector<VertexStruct> vertices;
-    std::vector<uint32_t> indices;
-    vertices.reserve(mesh->mNumVertices);
-    indices.reserve(mesh->mNumFaces * 3);
-
-    XMFLOAT3 minPos = { FLT_MAX,  FLT_MAX,  FLT_MAX };
-    XMFLOAT3 maxPos = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
-
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        VertexStruct vertex{};
-        
-        // Position
-        vertex.position = {
-            mesh->mVertices[i].x,
-            mesh->mVertices[i].y,
-            mesh->mVertices[i].z,
-            1.0f
-        };
+        PackedMask mask;
+        std::error_code ec;
+        if (!fs::exists(maskPath, ec) || !readChannelLayout(channelLayoutPath(diffuse.parent_path(), key), mask.layout))
+            continue;
 
-        // Normal
-        if (mesh->HasNormals()) {
-            vertex.normal = {
-                mesh->mNormals[i].x,
-                mesh->mNormals[i].y,
-                mesh->mNormals[i].z
-            };
-        }
+        LOG_INFO(L"[Model] Loading packed mask: %s", maskPath.wstring().c_str());
+        mask.texture = textureCache->get(uploads, maskPath.wstring());
+        textures.push_back(mask.texture);
+        masksByName[view.diffuseTexture] = mask;
+    }
 
-        // Tangent + Handedness
-        if (mesh->HasTangentsAndBitangents() && mesh->HasNormals()) {
-            // Load Assimp vectors directly into XMVECTOR
-            XMVECTOR tVec = XMLoadFloat3(
-                reinterpret_cast<XMFLOAT3*>(&mesh->mTangents[i])
-            );
-            XMVECTOR bVec = XMLoadFloat3(
-                reinterpret_cast<XMFLOAT3*>(&mesh->mBitangents[i])
-            );
-            XMVECTOR nVec = XMLoadFloat3(
-                reinterpret_cast<XMFLOAT3*>(&mesh->mNormals[i])
-            );
-
-            // Optional: normalize to be safe
-            tVec = XMVector3Normalize(tVec);
-            bVec = XMVector3Normalize(bVec);
-            nVec = XMVector3Normalize(nVec);
-
-            // Compute handedness
-            float handedness = (XMVectorGetX(XMVector3Dot(XMVector3Cross(nVec, tVec), bVec)) < 0.0f) ? -1.0f : 1.0f;
-
-            vertex.tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, handedness };
-        } else {
-            vertex.tangent = { 1.0f, 0.0f, 0.0f, 1.0f }; // fallback
+    // Small textures share an atlas when every mesh using them keeps its UVs in
+    // [0, 1], wrapping can't be remapped into a sub-rectangle, and no packed mask
+    // samples the same UVs. In first-use order so the same model asks for the
+    // same atlas every time.
+    std::unordered_map<std::string_view, AtlasRegion> atlasRegions;
+    if (settings.textureAtlas) {
+        std::vector<std::string_view> names;
+        std::unordered_map<std::string_view, bool> atlasable;
+        for (const MeshView& view : views) {
+            if (view.diffuseTexture.empty())
+                continue;
+
+            auto [it, inserted] = atlasable.emplace(view.diffuseTexture, true);
+            if (inserted)
+                names.push_back(view.diffuseTexture);
+            it->second = it->second && !masksByName.count(view.diffuseTexture) && uvsInUnitRange(view.vertices);
         }
 
-        // UVs
-        if (mesh->HasTextureCoords(0)) {
-            vertex.texcoord = {
-                mesh->mTextureCoords[0][i].x,
-                mesh->mTextureCoords[0][i].y
-            };
-        } else {
-            vertex.texcoord = { 0.0f, 0.0f };
-        }
+        std::erase_if(names, [&](std::string_view name) { return !atlasable[name]; });
 
-        vertices.push_back(vertex);
+        if (names.size() >= 2) {
+            std::vector<std::wstring> paths;
+            for (std::string_view name : names) {
+                paths.push_back(resolveTexturePath(std::string(name)));
+            }
 
-        // Track mesh bounds
-        minPos.x = std::min(minPos.x, mesh->mVertices[i].x);
-        minPos.y = std::min(minPos.y, mesh->mVertices[i].y);
-        minPos.z = std::min(minPos.z, mesh->mVertices[i].z);
-        maxPos.x = std::max(maxPos.x, mesh->mVertices[i].x);
-        maxPos.y = std::max(maxPos.y, mesh->mVertices[i].y);
-        maxPos.z = std::max(maxPos.z, mesh->mVertices[i].z);
+            // Images left out come back as their own textures, kept here like get()'s
+            TextureAtlas atlas = textureCache->getAtlas(uploads, paths);
+            if (atlas.texture)
+                textures.push_back(atlas.texture);
+
+            for (size_t i = 0; i < names.size(); ++i) {
+                const AtlasRegion& region = atlas.regions[i];
+                if (!region.texture)
+                    continue;
+
+                texturesByName[names[i]] = region.texture;
+                if (region.packed) {
+                    atlasRegions[names[i]] = region;
+                } else {
+                    textures.push_back(region.texture);
+                }
+            }
+        }
     }
 
+    for (const MeshView& view : views) {
+        if (view.diffuseTexture.empty() || texturesByName.count(view.diffuseTexture))
+            continue;
+
+        std::wstring wpath = resolveTexturePath(std::string(view.diffuseTexture));
+        LOG_INFO(L"[Model] Loading texture: %s", wpath.c_str());
 
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; j++) indices.push_back(face.mIndices[j]);
+        auto texShared = textureCache->get(uploads, wpath);
+        textures.push_back(texShared);
+        texturesByName[view.diffuseTexture] = texShared;
     }
 
-    globalMin = { std::min(globalMin.x, minPos.x), std::min(globalMin.y, minPos.y), std::min(globalMin.z, minPos.z) };
-    globalMax = { std::max(globalMax.x, maxPos.x), std::max(globalMax.y, maxPos.y), std::max(globalMax.z, maxPos.z) };
+    // Then buffers + materials, and the global bounds from the per-mesh ones
+    meshes.reserve(meshes.size() + views.size());
+    std::unordered_map<const Texture*, std::shared_ptr<Material>> materialsByTexture;
 
-    LOG_DEBUG(L"[Model] Mesh processed. Final vertex count: %zu, index count: %zu", vertices.size(), indices.size());
+    for (const MeshView& view : views) {
+        globalMin = { std::min(globalMin.x, view.boundsMin.x), std::min(globalMin.y, view.boundsMin.y), std::min(globalMin.z, view.boundsMin.z) };
+        globalMax = { std::max(globalMax.x, view.boundsMax.x), std::max(globalMax.y, view.boundsMax.y), std::max(globalMax.z, view.boundsMax.z) };
 
-    // --- Material & Texture Handling ---
-    std::shared_ptr<Texture> texForMesh = nullptr;
+        std::shared_ptr<Texture> texForMesh = nullptr;
+        if (!view.diffuseTexture.empty()) {
+            texForMesh = texturesByName[view.diffuseTexture];
+        }
 
-    if (mesh->mMaterialIndex >= 0) {
-        aiMaterial* aimat = scene->mMaterials[mesh->mMaterialIndex];
-        aiString texPath;
-        if ((aimat->GetTextureCount(aiTextureType_BASE_COLOR) > 0 &&
-             aimat->GetTexture(aiTextureType_BASE_COLOR, 0, &texPath) == AI_SUCCESS) ||
-            (aimat->GetTextureCount(aiTextureType_DIFFUSE) > 0 &&
-             aimat->GetTexture(aiTextureType_DIFFUSE, 0, &texPath) == AI_SUCCESS)) {
+        // Fallback texture
+        if (!texForMesh) {
+            if (!whiteTexture) {
+                LOG_INFO(L"[Model] Creating white fallback texture for mesh");
+                whiteTexture = makeWhiteFallbackTexture();
+            }
+            texForMesh = whiteTexture;
+        }
 
-            std::string texStr(texPath.C_Str());
-            if (!texStr.empty()) {
-                std::wstring wpath = resolveTexturePath(texStr);
-                LOG_INFO(L"[Model] Loading texture for mesh: %s", wpath.c_str());
+        // One material per texture, meshes sharing an atlas share the bind
+        std::shared_ptr<Material>& matPtr = materialsByTexture[texForMesh.get()];
+        if (!matPtr) {
+            matPtr = std::make_shared<Material>(texForMesh);
+            materials.push_back(matPtr);
 
-                // Only create one shared_ptr per texture; store in textures vector
-                auto texShared = std::make_shared<Texture>(device, uploadCmdList, srvHeap, wpath, nextDescriptorIndex++);
-                textures.push_back(texShared);
-                texForMesh = texShared;
-            }
+            auto maskIt = masksByName.find(view.diffuseTexture);
+            if (maskIt != masksByName.end())
+                matPtr->setMask(maskIt->second.texture, maskIt->second.layout);
         }
-    }
 
-    // Fallback texture
-    if (!texForMesh) {
-        if (!whiteTexture) {
-            LOG_INFO(L"[Model] Creating white fallback texture for mesh");
-            whiteTexture = makeWhiteFallbackTexture();
+        // Atlas-packed textures: UVs move into the image's rectangle
+        std::span<const VertexStruct> vertices = view.vertices;
+        std::vector<VertexStruct> remapped;
+
+        auto regionIt = atlasRegions.find(view.diffuseTexture);
+        if (regionIt != atlasRegions.end()) {
+            const AtlasRegion& region = regionIt->second;
+            remapped.assign(view.vertices.begin(), view.vertices.end());
+            for (VertexStruct& v : remapped) {
+                v.texcoord.x = region.offset.x + std::clamp(v.texcoord.x, 0.0f, 1.0f) * region.scale.x;
+                v.texcoord.y = region.offset.y + std::clamp(v.texcoord.y, 0.0f, 1.0f) * region.scale.y;
+            }
+            vertices = remapped;
         }
-        texForMesh = whiteTexture;
+
+        MeshOptions options;
+        options.format = settings.vertexFormat;
+        options.depthStream = settings.depthStream;
+        options.meshlets = view.meshlets;
+        options.lods = view.lods;
+        options.boundsCenter = {
+            (view.boundsMin.x + view.boundsMax.x) * 0.5f,
+            (view.boundsMin.y + view.boundsMax.y) * 0.5f,
+            (view.boundsMin.z + view.boundsMax.z) * 0.5f
+        };
+        XMFLOAT3 halfExtent = {
+            (view.boundsMax.x - view.boundsMin.x) * 0.5f,
+            (view.boundsMax.y - view.boundsMin.y) * 0.5f,
+            (view.boundsMax.z - view.boundsMin.z) * 0.5f
+        };
+        options.boundsRadius = std::sqrt(halfExtent.x * halfExtent.x + halfExtent.y * halfExtent.y + halfExtent.z * halfExtent.z);
+
+        meshes.push_back(std::make_unique<Mesh>(device, geometry, vertices, view.indices, matPtr, options));
     }
 
-    auto matPtr = std::make_shared<Material>(texForMesh);
-    materials.push_back(matPtr);
-    LOG_INFO(L"[Model] Mesh material assigned, creating Mesh object");
+    // Draw order grouped by material so draw() binds each texture once
+    std::unordered_map<const Material*, size_t> materialOrder;
+    for (size_t i = 0; i < materials.size(); ++i) {
+        materialOrder[materials[i].get()] = i;
+    }
+    std::stable_sort(meshes.begin(), meshes.end(), [&](const std::unique_ptr<Mesh>& a, const std::unique_ptr<Mesh>& b) {
+        return materialOrder[a->getMaterial()] < materialOrder[b->getMaterial()];
+    });
 
-    return std::make_unique<Mesh>(device, vertices, indices, matPtr);
+    LOG_INFO(L"[Model] Created %zu meshes, %zu textures", views.size(), texturesByName.size());
+    textureCache->logStats();
 }
 
-void Model::draw(ID3D12GraphicsCommandList* cmdList, ID3D12DescriptorHeap* srvHeap, UINT rootIndex) {
+void Model::draw(ID3D12GraphicsCommandList* cmdList, ID3D12DescriptorHeap* srvHeap, const MaterialSlots& materialSlots, UINT dequantRootIndex) {
     LOG_INFO(L"[Model] draw() called: %zu meshes", meshes.size());
 
     ID3D12DescriptorHeap* heaps[] = { srvHeap };
     cmdList->SetDescriptorHeaps(_countof(heaps), heaps);
 
+    // Meshes are grouped by material, a run sharing one (atlas) binds its texture once.
+    // Geometry comes from a few pool arenas, so vertex/index views rarely change either.
+    const Material* bound = nullptr;
+    GeometryBindState bindings;
     for (size_t i = 0; i < meshes.size(); ++i) {
         LOG_INFO(L"[Model] Drawing mesh %zu/%zu", i + 1, meshes.size());
         LOG_D3D12_MESSAGES(device);
-        meshes[i]->draw(cmdList, rootIndex);
+        const Material* material = meshes[i]->getMaterial();
+        meshes[i]->draw(cmdList, materialSlots, dequantRootIndex, material != bound, &bindings);
+        bound = material;
         LOG_D3D12_MESSAGES(device);
     }
 
-    LOG_INFO(L"[Model] draw() completed for %zu meshes", meshes.size());
+    LOG_INFO(L"[Model] draw() completed for %zu meshes, %zu geometry bindings", meshes.size(), bindings.bindings);
+}
+
+void Model::selectLods(const XMMATRIX& model, const XMMATRIX& projection, const XMFLOAT3& eye, float viewportHeight) {
+    // Model space error over model space distance is the same ratio as in view space
+    XMFLOAT4X4 proj;
+    XMStoreFloat4x4(&proj, projection);
+    const float pixelScale = proj.m[1][1] * viewportHeight * 0.5f;
+
+    XMFLOAT3 localEye;
+    XMStoreFloat3(&localEye, XMVector3TransformCoord(XMLoadFloat3(&eye), XMMatrixInverse(nullptr, model)));
+    const float eyePosition[3] = { localEye.x, localEye.y, localEye.z };
+
+    size_t trianglesFull = 0;
+    size_t trianglesSelected = 0;
+    for (auto& mesh : meshes) {
+        UINT level = mesh->selectLod(eyePosition, pixelScale, LOD_PIXEL_ERROR, LOD_HYSTERESIS);
+        trianglesFull += mesh->getLod(0).indexCount / 3;
+        trianglesSelected += mesh->getLod(level).indexCount / 3;
+    }
+
+    LOG_INFO(L"[Model] LOD selection: triangles %zu -> %zu", trianglesFull, trianglesSelected);
+}
+
+void Model::requestTextureMips(const XMMATRIX& model, const XMMATRIX& projection, const XMFLOAT3& eye, float viewportHeight) {
+    XMFLOAT4X4 proj;
+    XMStoreFloat4x4(&proj, projection);
+    const float pixelScale = proj.m[1][1] * viewportHeight * 0.5f;
+
+    XMFLOAT3 localEye;
+    XMStoreFloat3(&localEye, XMVector3TransformCoord(XMLoadFloat3(&eye), XMMatrixInverse(nullptr, model)));
+    const float eyePosition[3] = { localEye.x, localEye.y, localEye.z };
+
+    for (auto& mesh : meshes) {
+        mesh->requestTextureMip(eyePosition, pixelScale);
+    }
+}
+
+MeshletCullStats Model::cull(const XMMATRIX& model, const XMMATRIX& viewProj, const XMFLOAT3& eye, UINT frameIndex) {
+    // Frustum planes and eye go to model space so meshlet bounds are used as stored
+    XMFLOAT4X4 mvp;
+    XMStoreFloat4x4(&mvp, XMMatrixMultiply(model, viewProj));
+    CullFrustum frustum = makeCullFrustum(mvp.m);
+
+    XMFLOAT3 localEye;
+    XMStoreFloat3(&localEye, XMVector3TransformCoord(XMLoadFloat3(&eye), XMMatrixInverse(nullptr, model)));
+    const float eyePosition[3] = { localEye.x, localEye.y, localEye.z };
+
+    MeshletCullStats total;
+    for (auto& mesh : meshes) {
+        total += mesh->cull(frustum, eyePosition, frameIndex);
+    }
+
+    LOG_INFO(L"[Model] Culled meshlets: %zu/%zu visible, triangles submitted %zu/%zu",
+        total.meshletsVisible, total.meshletsTotal, total.trianglesVisible, total.trianglesTotal);
+
+    return total;
+}
+
+void Model::drawDepth(ID3D12GraphicsCommandList* cmdList) {
+    GeometryBindState bindings;
+    for (auto& mesh : meshes) {
+        mesh->drawDepth(cmdList, &bindings);
+    }
 }
 
 std::wstring Model::resolveTexturePath(const std::string& texRel) const {
     fs::path p(texRel);
-    if (p.is_absolute()) 
-        return p.wstring();
+    if (!p.is_absolute()) 
+        p = fs::path(directory) / p;
+
+    // A cooked .dds next to the source (tools/texture_cooker) wins
+    fs::path cooked = p;
+    cooked.replace_extension(".dds");
+
+    std::error_code ec;
+    if (cooked != p && fs::is_regular_file(cooked, ec))
+        return cooked.wstring();
 
-    return (fs::path(directory) / p).wstring();
+    return p.wstring();
 }
 
 std::shared_ptr<Texture> Model::makeWhiteFallbackTexture() {
     std::wstring whitePath = DEFAULT_WHITE_TEXTURE;
-    auto tex = std::make_shared<Texture>(device, uploadCmdList, srvHeap, whitePath, nextDescriptorIndex++);
+    auto tex = textureCache->get(uploads, whitePath);
     textures.push_back(tex);
     return tex;
 }
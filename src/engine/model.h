@@ -3,41 +3,98 @@
 #include "utils/pch.h"
 #include "material.h"
 #include "resources/texture.h"
+#include "geometry/mesh_data.h"
+#include "geometry/import_settings.h"
+#include "geometry/mesh_cache.h"
 
 class Mesh;
-class DescriptorHeap;
-class CommandQueue;
-
-class aiNode;
-class aiScene;
-class aiMesh;
+class TextureCache;
+class UploadRing;
+class GeometryPool;
 
 class Model {
     public:
+        // Textures are staged through uploads, vertices and indices go into geometry (filled
+        // on the copy queue). Returns once the copies are submitted, see getGeometryFence().
         Model(
             ComPtr<ID3D12Device2> device, 
-            CommandQueue* uploadQueue, 
-            DescriptorHeap* srvHeap, 
-            const std::string& path
+            UploadRing* uploads, 
+            GeometryPool* geometry, 
+            TextureCache* textureCache, 
+            const std::string& path,
+            const ImportSettings& settings = {}
         );
 
         ~Model() = default;
 
-        // Draw the model. rootIndex is the root parameter index in the root signature
-        // that expects the SRV descriptor table (e.g. slot 1 in your pipeline).
+        // Several models at once: the CPU side (cache lookup or import) of every model runs
+        // in parallel on the thread pool, then GPU resources are created one model at a time.
+        // Same order as paths, throws on the first model that fails to load.
+        static std::vector<std::unique_ptr<Model>> loadMany(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            GeometryPool* geometry,
+            TextureCache* textureCache,
+            std::span<const std::string> paths,
+            const ImportSettings& settings = {}
+        );
+
+        // Draw the model. materialSlots are the root parameter indices in the root signature
+        // that take the material's SRV descriptor tables and mask channel constants.
+        // dequantRootIndex takes the per-mesh VertexDequant constants for packed vertices.
         void draw(
             ID3D12GraphicsCommandList* cmdList, 
             ID3D12DescriptorHeap* srvHeap,
-            UINT rootIndex
+            const MaterialSlots& materialSlots,
+            UINT dequantRootIndex = UINT_MAX
         );
 
+        // Per-mesh LOD from the screen-space size of each level's error. Call before cull(),
+        // which only culls meshes still at LOD 0. projection is the camera's, eye world space.
+        void selectLods(const XMMATRIX& model, const XMMATRIX& projection, const XMFLOAT3& eye, float viewportHeight);
+
+        // Per-mesh mip requests for streamed textures, from UV density and distance to the
+        // camera. Same arguments as selectLods(); TextureStreamer::update() acts on them.
+        void requestTextureMips(const XMMATRIX& model, const XMMATRIX& projection, const XMFLOAT3& eye, float viewportHeight);
+
+        // Meshlet culling for the frame about to be recorded. model is the world matrix the
+        // model is drawn with, eye the camera position in world space.
+        MeshletCullStats cull(const XMMATRIX& model, const XMMATRIX& viewProj, const XMFLOAT3& eye, UINT frameIndex);
+
+        // Positions only, for a depth prepass or shadow pipeline using getDepthInputLayout()
+        void drawDepth(ID3D12GraphicsCommandList* cmdList);
+
+        VertexFormat getVertexFormat() const { return settings.vertexFormat; }
+
         XMFLOAT3 getBoundingCenter() const { return boundingCenter; }
         float getBoundingRadius() const { return boundingRadius; }
 
+        // Copy queue fence value after which every geometry range of this model is filled.
+        // Queues drawing it wait on it first (CommandQueue::waitForQueue).
+        UINT64 getGeometryFence() const { return geometryFence; }
+
     private:
-        void loadModel(const std::string& path);
-        void processNode(aiNode* node, const aiScene* scene);
-        std::unique_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene);
+        struct Deferred {};
+
+        // Stores everything but loads nothing, for loadMany()
+        Model(
+            Deferred,
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            GeometryPool* geometry,
+            TextureCache* textureCache,
+            const std::string& path,
+            const ImportSettings& settings
+        );
+
+        // CPU only and thread safe across models: maps the cache or imports (and cooks) the file
+        void importMeshes(const std::string& path);
+
+        // GPU side, on the thread owning uploads: buffers, textures, bounds
+        void createResources();
+
+        // GPU side, batched: all textures first, then buffers + materials per mesh
+        void createMeshes(std::span<const MeshView> views);
 
         // Helpers
         std::wstring toWide(const std::string& s) const;
@@ -49,13 +106,24 @@ class Model {
     private:
         ComPtr<ID3D12Device2> device;
 
-        CommandQueue* uploadQueue = nullptr;
-        ComPtr<ID3D12GraphicsCommandList2> uploadCmdList;
+        // Texture staging, submitted in bounded batches
+        UploadRing* uploads = nullptr;
+
+        // Shared vertex and index arenas, filled on the copy queue
+        GeometryPool* geometry = nullptr;
+        UINT64 geometryFence = 0;
 
-        DescriptorHeap* srvHeap = nullptr;
+        // Shared across models, owns nothing: textures are refcounted by their users
+        TextureCache* textureCache = nullptr;
+
+        ImportSettings settings;
 
         std::string directory;
-        UINT nextDescriptorIndex = 0;
+
+        // importMeshes() output, dropped again by createResources()
+        MeshCache cache;
+        std::vector<MeshData> importedMeshes;
+        std::vector<MeshView> importedViews;
 
         std::vector<std::unique_ptr<Mesh>> meshes;
         std::vector<std::shared_ptr<Material>> materials; 
@@ -8,17 +8,7 @@ ConstantBuffer::ConstantBuffer(
 {
     LOG_INFO(L"ConstantBuffer -> Creating constant buffer of size %d bytes", sizeInBytes);
 
-    CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeInBytes);
-
-    throwFailed(device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&buffer)
-    ));
+    buffer = GpuAllocator::instance().createBuffer(device, D3D12_HEAP_TYPE_UPLOAD, sizeInBytes, D3D12_RESOURCE_STATE_GENERIC_READ);
 
     CD3DX12_RANGE readRange(0, 0);
     throwFailed(buffer->Map(0, &readRange, reinterpret_cast<void**>(&mappedData)));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "utils/pch.h"
+#include "gpu_allocator.h"
 
 class ConstantBuffer {
     public:
@@ -11,7 +12,7 @@ class ConstantBuffer {
         ~ConstantBuffer();
 
         ComPtr<ID3D12Resource> getBuffer() const { 
-            return buffer; 
+            return buffer.getResource(); 
         }
 
         UINT getSize() const { 
@@ -25,7 +26,7 @@ class ConstantBuffer {
         }
 
     private:
-        ComPtr<ID3D12Resource> buffer;
+        GpuAllocation buffer;
         UINT sizeInBytes = 0;
         UINT8* mappedData = nullptr;
 };
\ No newline at end of file
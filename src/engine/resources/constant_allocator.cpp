@@ -0,0 +1,79 @@
+#include "constant_allocator.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr double KILOBYTE = 1024.0;
+}
+
+ConstantAllocator::ConstantAllocator(
+    ComPtr<ID3D12Device2> device,
+    UINT64 bytesPerFrame,
+    UINT frameCount
+) :
+    bytesPerFrame((bytesPerFrame + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~UINT64(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)),
+    regionFences(std::max(frameCount, 1u))
+{
+    buffer = GpuAllocator::instance().createBuffer(
+        device,
+        D3D12_HEAP_TYPE_UPLOAD,
+        this->bytesPerFrame * regionFences.size(),
+        D3D12_RESOURCE_STATE_GENERIC_READ
+    );
+
+    // Upload heaps can stay mapped for their whole lifetime
+    CD3DX12_RANGE readRange(0, 0);
+    throwFailed(buffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+    gpuBase = buffer->GetGPUVirtualAddress();
+
+    LOG_INFO(L"ConstantAllocator -> %zu regions of %.0f KB", regionFences.size(), this->bytesPerFrame / KILOBYTE);
+}
+
+ConstantAllocator::~ConstantAllocator() {
+    if (buffer)
+        buffer->Unmap(0, nullptr);
+}
+
+void ConstantAllocator::beginFrame(UINT64 completedFence) {
+    current = (current + 1) % static_cast<UINT>(regionFences.size());
+    offset = 0;
+
+    // The caller owns the wait, reaching here early would overwrite live constants
+    if (regionFences[current] > completedFence) {
+        LOG_ERROR(L"ConstantAllocator -> Region %u still in flight (fence %llu, completed %llu)", current, regionFences[current], completedFence);
+        throw std::runtime_error("ConstantAllocator region in flight");
+    }
+}
+
+void ConstantAllocator::endFrame(UINT64 fenceValue) {
+    regionFences[current] = fenceValue;
+    stats.peakBytes = std::max(stats.peakBytes, offset);
+    stats.frames++;
+}
+
+ConstantAllocation ConstantAllocator::allocate(size_t size) {
+    const UINT64 aligned = (size + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~UINT64(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+    if (offset + aligned > bytesPerFrame) {
+        LOG_ERROR(L"ConstantAllocator -> %zu bytes overflow the frame's %llu", size, bytesPerFrame);
+        throw std::runtime_error("ConstantAllocator overflow");
+    }
+
+    const UINT64 start = current * bytesPerFrame + offset;
+    offset += aligned;
+
+    ConstantAllocation allocation;
+    allocation.cpu = mapped + start;
+    allocation.gpu = gpuBase + start;
+    return allocation;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ConstantAllocator::push(const void* data, size_t size) {
+    ConstantAllocation allocation = allocate(size);
+    memcpy(allocation.cpu, data, size);
+    return allocation.gpu;
+}
+
+void ConstantAllocator::logStats() const {
+    LOG_INFO(L"ConstantAllocator -> %zu frames, peak %.1f / %.0f KB per frame",
+        stats.frames, stats.peakBytes / KILOBYTE, bytesPerFrame / KILOBYTE);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "gpu_allocator.h"
+
+struct ConstantAllocation {
+    uint8_t* cpu = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS gpu = 0;
+};
+
+struct ConstantAllocatorStats {
+    size_t frames = 0;
+    uint64_t peakBytes = 0;    // most one frame used
+};
+
+// Per-frame constants out of one persistently mapped upload buffer, split
+// into a region per frame in flight. Allocations bump a pointer through the
+// current region; beginFrame() moves to the next one, which the caller has
+// already waited to be done with, so nothing is overwritten while read.
+class ConstantAllocator {
+    public:
+        ConstantAllocator(
+            ComPtr<ID3D12Device2> device,
+            UINT64 bytesPerFrame,
+            UINT frameCount
+        );
+
+        ~ConstantAllocator();
+
+        ConstantAllocator(const ConstantAllocator&) = delete;
+        ConstantAllocator& operator=(const ConstantAllocator&) = delete;
+
+        // Next region. completedFence is the queue's completed value after the caller's
+        // wait, throws if the region's last frame is still in flight.
+        void beginFrame(UINT64 completedFence);
+
+        // fenceValue is signaled after the last list reading this frame's constants
+        void endFrame(UINT64 fenceValue);
+
+        // 256-byte aligned, valid until this region comes around again. Throws when the frame is full.
+        ConstantAllocation allocate(size_t size);
+
+        // Copies data in, returns the address for SetGraphicsRootConstantBufferView
+        D3D12_GPU_VIRTUAL_ADDRESS push(const void* data, size_t size);
+
+        template<typename T>
+        D3D12_GPU_VIRTUAL_ADDRESS push(const T& data) {
+            return push(&data, sizeof(T));
+        }
+
+        const ConstantAllocatorStats& getStats() const {
+            return stats;
+        }
+
+        void logStats() const;
+
+    private:
+        GpuAllocation buffer;
+        uint8_t* mapped = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuBase = 0;
+
+        UINT64 bytesPerFrame = 0;
+        std::vector<UINT64> regionFences; // signaled after the last frame recorded in each region
+        UINT current = 0;
+        UINT64 offset = 0; // into the current region
+
+        ConstantAllocatorStats stats;
+};
@@ -0,0 +1,236 @@
+#include "geometry_pool.h"
+#include "upload_ring.h"
+#include "engine/command_queue.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr double MEGABYTE = 1024.0 * 1024.0;
+}
+
+void GeometryBindState::setVertexBuffers(ID3D12GraphicsCommandList* cmdList, std::span<const D3D12_VERTEX_BUFFER_VIEW> views) {
+    bool same = true;
+    for (size_t i = 0; i < views.size(); ++i) {
+        same = same && vertex[i] == views[i].BufferLocation;
+    }
+    if (same)
+        return;
+
+    for (size_t i = 0; i < views.size(); ++i) {
+        vertex[i] = views[i].BufferLocation;
+    }
+    cmdList->IASetVertexBuffers(0, static_cast<UINT>(views.size()), views.data());
+    bindings++;
+}
+
+void GeometryBindState::setIndexBuffer(ID3D12GraphicsCommandList* cmdList, const D3D12_INDEX_BUFFER_VIEW& view) {
+    if (index == view.BufferLocation)
+        return;
+
+    index = view.BufferLocation;
+    cmdList->IASetIndexBuffer(&view);
+    bindings++;
+}
+
+GeometryPool::GeometryPool(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    CommandQueue* drawQueue,
+    UINT64 arenaBytes
+) :
+    device(device),
+    uploads(uploads),
+    drawQueue(drawQueue),
+    arenaBytes(arenaBytes)
+{}
+
+GeometryRange GeometryPool::allocateVertices(std::span<const VertexStream> streams, UINT count) {
+    if (streams.empty() || streams.size() > MAX_STREAMS || count == 0)
+        return {};
+
+    UINT strides[MAX_STREAMS] = {};
+    for (size_t i = 0; i < streams.size(); ++i) {
+        strides[i] = streams[i].stride;
+    }
+
+    GeometryRange range = allocate(strides, static_cast<UINT>(streams.size()), DXGI_FORMAT_UNKNOWN, count, 1);
+
+    Arena& arena = *arenas[range.arena];
+    for (size_t i = 0; i < streams.size(); ++i) {
+        const UINT64 stride = streams[i].stride;
+        uploads->copyToBuffer(arena.buffers[i].get(), range.offset * stride, streams[i].data, count * stride);
+    }
+
+    return range;
+}
+
+GeometryRange GeometryPool::allocateIndices(std::span<const uint32_t> indices) {
+    if (indices.empty())
+        return {};
+
+    uint32_t maxIndex = 0;
+    for (uint32_t i : indices) {
+        maxIndex = std::max(maxIndex, i);
+    }
+
+    const UINT count = static_cast<UINT>(indices.size());
+
+    if (maxIndex <= UINT16_MAX) {
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        const UINT stride = sizeof(uint16_t);
+
+        // Two indices at a time keeps copy offsets 4-byte aligned
+        GeometryRange range = allocate(&stride, 1, DXGI_FORMAT_R16_UINT, count, 2);
+        uploads->copyToBuffer(arenas[range.arena]->buffers[0].get(), range.offset * UINT64(stride), narrow.data(), count * UINT64(stride));
+        return range;
+    }
+
+    const UINT stride = sizeof(uint32_t);
+    GeometryRange range = allocate(&stride, 1, DXGI_FORMAT_R32_UINT, count, 1);
+    uploads->copyToBuffer(arenas[range.arena]->buffers[0].get(), range.offset * UINT64(stride), indices.data(), count * UINT64(stride));
+    return range;
+}
+
+GeometryRange GeometryPool::allocate(const UINT* strides, UINT streamCount, DXGI_FORMAT format, UINT count, UINT alignment) {
+    auto matches = [&](const Arena& arena) {
+        return arena.format == format && arena.streamCount == streamCount &&
+            std::equal(strides, strides + streamCount, arena.strides);
+    };
+
+    release();
+
+    GeometryRange range;
+    range.count = count;
+
+    for (uint32_t i = 0; i < arenas.size(); ++i) {
+        if (!matches(*arenas[i]))
+            continue;
+
+        TlsfAllocator::Allocation allocation = arenas[i]->allocator.allocate(count, alignment);
+        if (allocation.block != TlsfAllocator::INVALID_BLOCK) {
+            range.arena = i;
+            range.block = allocation.block;
+            range.offset = static_cast<UINT>(allocation.offset);
+            return range;
+        }
+    }
+
+    // Elements of every stream together take about arenaBytes
+    UINT64 elementBytes = 0;
+    for (UINT i = 0; i < streamCount; ++i) {
+        elementBytes += strides[i];
+    }
+    // Meshes larger than that get an arena of their own, sized so TLSF's
+    // size class rounding still finds the request room
+    const UINT64 elements = std::max<UINT64>(arenaBytes / elementBytes, TlsfAllocator::getFitSize(count, alignment));
+    if (elements > UINT_MAX) {
+        LOG_ERROR(L"GeometryPool -> %u elements don't fit an arena", count);
+        throw std::runtime_error("GeometryPool range too large");
+    }
+    const UINT capacity = static_cast<UINT>(elements);
+
+    auto arena = std::make_unique<Arena>(capacity);
+    arena->streamCount = streamCount;
+    arena->format = format;
+    for (UINT i = 0; i < streamCount; ++i) {
+        // Buffer sizes stay 4-byte multiples for the copy paths
+        const UINT64 size = (capacity * UINT64(strides[i]) + 3) & ~3ull;
+
+        arena->strides[i] = strides[i];
+        arena->buffers[i] = GpuAllocator::instance().createBuffer(device, D3D12_HEAP_TYPE_DEFAULT, size, D3D12_RESOURCE_STATE_COMMON);
+    }
+
+    TlsfAllocator::Allocation allocation = arena->allocator.allocate(count, alignment);
+    if (allocation.block == TlsfAllocator::INVALID_BLOCK) {
+        LOG_ERROR(L"GeometryPool -> %u elements don't fit a new arena of %u", count, capacity);
+        throw std::runtime_error("GeometryPool allocation failed");
+    }
+
+    range.arena = static_cast<uint32_t>(arenas.size());
+    range.block = allocation.block;
+    range.offset = static_cast<UINT>(allocation.offset);
+
+    LOG_INFO(L"GeometryPool -> New %hs arena %u: %u elements, %.1f MB",
+        format == DXGI_FORMAT_UNKNOWN ? "vertex" : "index", range.arena, capacity, capacity * elementBytes / MEGABYTE);
+
+    arenas.push_back(std::move(arena));
+    return range;
+}
+
+void GeometryPool::free(GeometryRange& range) {
+    // The list being recorded may still draw it, its fence isn't known until endFrame()
+    if (range)
+        pendingRanges.push_back(range);
+
+    range = {};
+}
+
+void GeometryPool::endFrame(UINT64 fenceValue) {
+    for (const GeometryRange& range : pendingRanges) {
+        retiredRanges.push_back({ fenceValue, range });
+    }
+    pendingRanges.clear();
+}
+
+void GeometryPool::release() {
+    const UINT64 completed = drawQueue->getFence()->GetCompletedValue();
+
+    while (!retiredRanges.empty() && retiredRanges.front().fenceValue <= completed) {
+        const GeometryRange& range = retiredRanges.front().range;
+        arenas[range.arena]->allocator.free(range.block);
+        retiredRanges.pop_front();
+    }
+}
+
+UINT GeometryPool::getVertexViews(const GeometryRange& range, D3D12_VERTEX_BUFFER_VIEW* views) const {
+    if (!range)
+        return 0;
+
+    const Arena& arena = *arenas[range.arena];
+    for (UINT i = 0; i < arena.streamCount; ++i) {
+        views[i].BufferLocation = arena.buffers[i]->GetGPUVirtualAddress();
+        views[i].StrideInBytes = arena.strides[i];
+        views[i].SizeInBytes = arena.capacity * arena.strides[i];
+    }
+    return arena.streamCount;
+}
+
+D3D12_INDEX_BUFFER_VIEW GeometryPool::getIndexView(const GeometryRange& range) const {
+    D3D12_INDEX_BUFFER_VIEW view = {};
+    if (!range)
+        return view;
+
+    const Arena& arena = *arenas[range.arena];
+    view.BufferLocation = arena.buffers[0]->GetGPUVirtualAddress();
+    view.Format = arena.format;
+    view.SizeInBytes = arena.capacity * arena.strides[0];
+    return view;
+}
+
+UINT64 GeometryPool::submit() {
+    uploads->submit();
+    return uploads->getLastFence();
+}
+
+GeometryPoolStats GeometryPool::getStats() const {
+    GeometryPoolStats stats;
+    for (const std::unique_ptr<Arena>& arena : arenas) {
+        UINT64 elementBytes = 0;
+        for (UINT i = 0; i < arena->streamCount; ++i) {
+            elementBytes += arena->strides[i];
+        }
+
+        stats.arenas++;
+        stats.arenaBytes += arena->capacity * elementBytes;
+        stats.usedBytes += arena->allocator.getUsed() * elementBytes;
+        stats.ranges += arena->allocator.getAllocationCount();
+    }
+    stats.retired = pendingRanges.size() + retiredRanges.size();
+    return stats;
+}
+
+void GeometryPool::logStats() const {
+    GeometryPoolStats stats = getStats();
+    LOG_INFO(L"GeometryPool -> %zu ranges in %.1f / %.1f MB across %zu arenas, %zu waiting on the GPU",
+        stats.ranges, stats.usedBytes / MEGABYTE, stats.arenaBytes / MEGABYTE, stats.arenas, stats.retired);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "utils/tlsf_allocator.h"
+#include "gpu_allocator.h"
+
+#include <deque>
+#include <span>
+
+class CommandQueue;
+class UploadRing;
+
+// One vertex stream of a mesh, count elements of stride bytes
+struct VertexStream {
+    const void* data = nullptr;
+    UINT stride = 0;
+};
+
+// Vertices or indices suballocated from a pool arena. offset is the first
+// element: BaseVertexLocation for vertices, StartIndexLocation for indices.
+struct GeometryRange {
+    static constexpr uint32_t INVALID_ARENA = UINT32_MAX;
+
+    uint32_t arena = INVALID_ARENA;
+    uint32_t block = TlsfAllocator::INVALID_BLOCK;
+    UINT offset = 0;
+    UINT count = 0;
+
+    explicit operator bool() const {
+        return arena != INVALID_ARENA;
+    }
+};
+
+struct GeometryPoolStats {
+    size_t arenas = 0;
+    uint64_t arenaBytes = 0;
+    uint64_t usedBytes = 0;
+    size_t ranges = 0;
+    size_t retired = 0; // freed, waiting for the draw queue
+};
+
+// Views last set on a command list. Draws out of the same arenas skip the
+// IASet calls, so a model binds once per arena instead of once per mesh.
+struct GeometryBindState {
+    D3D12_GPU_VIRTUAL_ADDRESS vertex[2] = {};
+    D3D12_GPU_VIRTUAL_ADDRESS index = 0;
+    size_t bindings = 0; // IASet* calls actually made
+
+    void setVertexBuffers(ID3D12GraphicsCommandList* cmdList, std::span<const D3D12_VERTEX_BUFFER_VIEW> views);
+    void setIndexBuffer(ID3D12GraphicsCommandList* cmdList, const D3D12_INDEX_BUFFER_VIEW& view);
+};
+
+// Every static mesh's vertices and indices live in a few large default-heap
+// buffers (arenas), each managed in elements by a TlsfAllocator. Vertex
+// arenas are per layout: a Split arena holds both streams in parallel buffers
+// so one base vertex indexes both. Index arenas are per format; indices stay
+// mesh-local, which keeps most meshes at 16 bits.
+//
+// Data is copied through uploads (a ring on the copy queue). Arenas are
+// buffers, so the copy queue may fill one range while the direct queue reads
+// others; draws still wait on submit()'s fence before using new ranges.
+// Freed ranges wait for the fence of the frame they were freed in, passed to
+// endFrame(), to complete on drawQueue before their space is reused.
+class GeometryPool {
+    public:
+        // arenaBytes per arena, meshes that don't fit get an arena of their own size
+        GeometryPool(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            CommandQueue* drawQueue,
+            UINT64 arenaBytes
+        );
+
+        ~GeometryPool() = default;
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        // Up to two streams, all count long
+        GeometryRange allocateVertices(std::span<const VertexStream> streams, UINT count);
+
+        // R16_UINT whenever every index fits
+        GeometryRange allocateIndices(std::span<const uint32_t> indices);
+
+        // Reused once the frame being recorded, and every one before it, is done with it
+        void free(GeometryRange& range);
+
+        // fenceValue is signaled after the frame's command list, the one the
+        // ranges freed since the last call could still be drawn by
+        void endFrame(UINT64 fenceValue);
+
+        // Views over the range's whole arena, one per stream. Returns the stream count.
+        UINT getVertexViews(const GeometryRange& range, D3D12_VERTEX_BUFFER_VIEW* views) const;
+
+        D3D12_INDEX_BUFFER_VIEW getIndexView(const GeometryRange& range) const;
+
+        // Executes the recorded copies, returns the copy queue fence after which
+        // every range allocated so far is filled
+        UINT64 submit();
+
+        GeometryPoolStats getStats() const;
+
+        void logStats() const;
+
+    private:
+        static constexpr UINT MAX_STREAMS = 2;
+
+        struct Arena {
+            TlsfAllocator allocator; // in elements
+            UINT capacity = 0;
+            UINT streamCount = 0;
+            UINT strides[MAX_STREAMS] = {};
+            GpuAllocation buffers[MAX_STREAMS];
+            DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN; // index arenas only
+
+            explicit Arena(UINT capacity) : allocator(capacity), capacity(capacity) {}
+        };
+
+        struct RetiredRange {
+            UINT64 fenceValue = 0;
+            GeometryRange range;
+        };
+
+        // An arena of this layout with count free elements, a new one when none has
+        GeometryRange allocate(const UINT* strides, UINT streamCount, DXGI_FORMAT format, UINT count, UINT alignment);
+
+        // Gives back the ranges of frames the GPU has finished
+        void release();
+
+    private:
+        ComPtr<ID3D12Device2> device;
+        UploadRing* uploads = nullptr;
+        CommandQueue* drawQueue = nullptr;
+        UINT64 arenaBytes = 0;
+
+        std::vector<std::unique_ptr<Arena>> arenas;
+        std::vector<GeometryRange> pendingRanges; // freed while recording this frame
+        std::deque<RetiredRange> retiredRanges;
+};
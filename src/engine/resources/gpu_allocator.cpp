@@ -0,0 +1,240 @@
+#include "gpu_allocator.h"
+
+#include <utility>
+
+namespace {
+    // Big enough that a model's buffers share a handful of heaps
+    constexpr UINT64 HEAP_SIZE = 64ull << 20;
+
+    // Larger resources would leave most of a heap to fragments
+    constexpr UINT64 MAX_PLACED_SIZE = HEAP_SIZE / 4;
+
+    constexpr double MEGABYTE = 1024.0 * 1024.0;
+}
+
+GpuAllocation::~GpuAllocation() {
+    reset();
+}
+
+GpuAllocation::GpuAllocation(GpuAllocation&& other) noexcept {
+    *this = std::move(other);
+}
+
+GpuAllocation& GpuAllocation::operator=(GpuAllocation&& other) noexcept {
+    if (this != &other) {
+        reset();
+
+        resource = std::move(other.resource);
+        owner = std::exchange(other.owner, nullptr);
+        pool = other.pool;
+        heap = other.heap;
+        block = std::exchange(other.block, TlsfAllocator::INVALID_BLOCK);
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+void GpuAllocation::reset() {
+    // The resource has to go before anything else can be placed in its range
+    resource.Reset();
+
+    if (owner)
+        owner->free(*this);
+
+    owner = nullptr;
+    block = TlsfAllocator::INVALID_BLOCK;
+    size = 0;
+}
+
+GpuAllocator& GpuAllocator::instance() {
+    static GpuAllocator allocator;
+    return allocator;
+}
+
+GpuAllocation GpuAllocator::createBuffer(
+    ComPtr<ID3D12Device2> device,
+    D3D12_HEAP_TYPE heapType,
+    UINT64 size,
+    D3D12_RESOURCE_STATES initialState
+) {
+    const uint32_t poolIndex = heapType == D3D12_HEAP_TYPE_UPLOAD ? UPLOAD_BUFFERS : DEFAULT_BUFFERS;
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+
+    // Placed buffers are always 64 KB aligned
+    D3D12_RESOURCE_ALLOCATION_INFO info = {};
+    info.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    info.SizeInBytes = (size + info.Alignment - 1) & ~(info.Alignment - 1);
+
+    return place(device, poolIndex, desc, info, initialState);
+}
+
+GpuAllocation GpuAllocator::createTexture(
+    ComPtr<ID3D12Device2> device,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState
+) {
+    // Try the small alignment first, the device says whether the texture qualifies
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+    D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &placedDesc);
+
+    if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT) {
+        placedDesc.Alignment = 0;
+        info = device->GetResourceAllocationInfo(0, 1, &placedDesc);
+    }
+
+    return place(device, TEXTURES, placedDesc, info, initialState);
+}
+
+GpuAllocation GpuAllocator::place(
+    ComPtr<ID3D12Device2> device,
+    uint32_t poolIndex,
+    const D3D12_RESOURCE_DESC& desc,
+    const D3D12_RESOURCE_ALLOCATION_INFO& info,
+    D3D12_RESOURCE_STATES initialState
+) {
+    if (info.SizeInBytes > MAX_PLACED_SIZE)
+        return commit(device, poolIndex, desc, info.SizeInBytes, initialState);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Pool& pool = pools[poolIndex];
+
+    GpuAllocation allocation;
+    TlsfAllocator::Allocation range;
+
+    // First heap with room, a new one when none has
+    uint32_t heapIndex = 0;
+    for (; heapIndex < pool.heaps.size(); ++heapIndex) {
+        if (!pool.heaps[heapIndex])
+            continue;
+
+        range = pool.heaps[heapIndex]->allocator.allocate(info.SizeInBytes, info.Alignment);
+        if (range.block != TlsfAllocator::INVALID_BLOCK)
+            break;
+    }
+
+    if (range.block == TlsfAllocator::INVALID_BLOCK) {
+        heapIndex = 0;
+        while (heapIndex < pool.heaps.size() && pool.heaps[heapIndex])
+            heapIndex++;
+        if (heapIndex == pool.heaps.size())
+            pool.heaps.emplace_back();
+
+        auto heap = std::make_unique<Heap>(HEAP_SIZE);
+
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = HEAP_SIZE;
+        heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(pool.type);
+        heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        heapDesc.Flags = pool.flags;
+
+        HRESULT hr = device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap->heap));
+        if (FAILED(hr)) throw std::runtime_error("Failed to create resource heap.");
+
+        range = heap->allocator.allocate(info.SizeInBytes, info.Alignment);
+        pool.heaps[heapIndex] = std::move(heap);
+
+        LOG_INFO(L"GpuAllocator -> New %.0f MB heap for pool %u (%u heaps)", HEAP_SIZE / MEGABYTE, poolIndex, heapIndex + 1);
+    }
+
+    Heap& heap = *pool.heaps[heapIndex];
+    HRESULT hr = device->CreatePlacedResource(
+        heap.heap.Get(),
+        range.offset,
+        &desc,
+        initialState,
+        nullptr,
+        IID_PPV_ARGS(&allocation.resource)
+    );
+    if (FAILED(hr)) {
+        heap.allocator.free(range.block);
+        throw std::runtime_error("Failed to create placed resource.");
+    }
+
+    allocation.owner = this;
+    allocation.pool = poolIndex;
+    allocation.heap = heapIndex;
+    allocation.block = range.block;
+    allocation.size = info.SizeInBytes;
+    return allocation;
+}
+
+GpuAllocation GpuAllocator::commit(
+    ComPtr<ID3D12Device2> device,
+    uint32_t poolIndex,
+    const D3D12_RESOURCE_DESC& desc,
+    UINT64 size,
+    D3D12_RESOURCE_STATES initialState
+) {
+    GpuAllocation allocation;
+    CD3DX12_HEAP_PROPERTIES heapProps(pools[poolIndex].type);
+
+    HRESULT hr = device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        initialState,
+        nullptr,
+        IID_PPV_ARGS(&allocation.resource)
+    );
+    if (FAILED(hr)) throw std::runtime_error("Failed to create committed resource.");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    dedicated++;
+    dedicatedBytes += size;
+
+    allocation.owner = this;
+    allocation.pool = poolIndex;
+    allocation.size = size;
+    return allocation;
+}
+
+void GpuAllocator::free(const GpuAllocation& allocation) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (allocation.block == TlsfAllocator::INVALID_BLOCK) {
+        dedicated--;
+        dedicatedBytes -= allocation.size;
+        return;
+    }
+
+    pools[allocation.pool].heaps[allocation.heap]->allocator.free(allocation.block);
+}
+
+void GpuAllocator::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (Pool& pool : pools) {
+        for (std::unique_ptr<Heap>& heap : pool.heaps) {
+            if (heap && heap->allocator.empty())
+                heap.reset();
+        }
+    }
+}
+
+GpuAllocatorStats GpuAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    GpuAllocatorStats stats;
+    for (const Pool& pool : pools) {
+        for (const std::unique_ptr<Heap>& heap : pool.heaps) {
+            if (!heap)
+                continue;
+
+            stats.heaps++;
+            stats.heapBytes += heap->allocator.getSize();
+            stats.placedBytes += heap->allocator.getUsed();
+            stats.placed += heap->allocator.getAllocationCount();
+        }
+    }
+    stats.dedicated = dedicated;
+    stats.dedicatedBytes = dedicatedBytes;
+    return stats;
+}
+
+void GpuAllocator::logStats() const {
+    GpuAllocatorStats stats = getStats();
+    LOG_INFO(L"GpuAllocator -> %zu placed resources in %.1f / %.1f MB across %zu heaps, %zu committed (%.1f MB)",
+        stats.placed, stats.placedBytes / MEGABYTE, stats.heapBytes / MEGABYTE, stats.heaps,
+        stats.dedicated, stats.dedicatedBytes / MEGABYTE);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "utils/tlsf_allocator.h"
+
+#include <mutex>
+
+class GpuAllocator;
+
+struct GpuAllocatorStats {
+    size_t heaps = 0;
+    uint64_t heapBytes = 0;
+    uint64_t placedBytes = 0;    // taken by live placed resources, alignment included
+    size_t placed = 0;           // live placed resources
+    size_t dedicated = 0;        // live committed resources, too large for a heap
+    uint64_t dedicatedBytes = 0;
+};
+
+// A resource and the heap range under it. Move only; the range goes back to
+// the allocator when this is destroyed, so it has to outlive every use of the
+// resource, GPU side included.
+class GpuAllocation {
+    public:
+        GpuAllocation() = default;
+        ~GpuAllocation();
+
+        GpuAllocation(const GpuAllocation&) = delete;
+        GpuAllocation& operator=(const GpuAllocation&) = delete;
+
+        GpuAllocation(GpuAllocation&& other) noexcept;
+        GpuAllocation& operator=(GpuAllocation&& other) noexcept;
+
+        // Releases the resource, then its range
+        void reset();
+
+        ID3D12Resource* get() const {
+            return resource.Get();
+        }
+
+        ID3D12Resource* operator->() const {
+            return resource.Get();
+        }
+
+        ComPtr<ID3D12Resource> getResource() const {
+            return resource;
+        }
+
+        explicit operator bool() const {
+            return resource.Get() != nullptr;
+        }
+
+    private:
+        friend class GpuAllocator;
+
+        ComPtr<ID3D12Resource> resource;
+        GpuAllocator* owner = nullptr;
+        uint32_t pool = 0;
+        uint32_t heap = 0;
+        uint32_t block = TlsfAllocator::INVALID_BLOCK; // INVALID_BLOCK for committed
+        UINT64 size = 0;
+};
+
+// Places buffers and textures in large ID3D12Heaps instead of giving every one
+// its own committed resource (its own OS allocation and 64 KB heap). Each heap
+// is managed by a TlsfAllocator. Buffers and textures live in separate pools,
+// as resource heap tier 1 requires, and upload buffers in a pool of their own.
+// Small textures get the 4 KB placement alignment when the device allows it.
+// Anything over a quarter of a heap is still committed.
+//
+// Process-wide like the thread pool; call trim() before the device goes away.
+class GpuAllocator {
+    public:
+        static GpuAllocator& instance();
+
+        GpuAllocator(const GpuAllocator&) = delete;
+        GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+        // heapType is UPLOAD or DEFAULT
+        GpuAllocation createBuffer(
+            ComPtr<ID3D12Device2> device,
+            D3D12_HEAP_TYPE heapType,
+            UINT64 size,
+            D3D12_RESOURCE_STATES initialState
+        );
+
+        // Textures without render target or depth flags, in a DEFAULT heap
+        GpuAllocation createTexture(
+            ComPtr<ID3D12Device2> device,
+            const D3D12_RESOURCE_DESC& desc,
+            D3D12_RESOURCE_STATES initialState
+        );
+
+        // Releases heaps nothing is placed in anymore
+        void trim();
+
+        GpuAllocatorStats getStats() const;
+
+        void logStats() const;
+
+    private:
+        GpuAllocator() = default;
+
+        struct Heap {
+            ComPtr<ID3D12Heap> heap;
+            TlsfAllocator allocator;
+
+            explicit Heap(UINT64 size) : allocator(size) {}
+        };
+
+        struct Pool {
+            D3D12_HEAP_TYPE type;
+            D3D12_HEAP_FLAGS flags;
+            std::vector<std::unique_ptr<Heap>> heaps; // null once trimmed, indices stay valid
+        };
+
+        enum PoolIndex : uint32_t {
+            UPLOAD_BUFFERS,
+            DEFAULT_BUFFERS,
+            TEXTURES,
+            POOL_COUNT
+        };
+
+        GpuAllocation place(
+            ComPtr<ID3D12Device2> device,
+            uint32_t poolIndex,
+            const D3D12_RESOURCE_DESC& desc,
+            const D3D12_RESOURCE_ALLOCATION_INFO& info,
+            D3D12_RESOURCE_STATES initialState
+        );
+
+        GpuAllocation commit(
+            ComPtr<ID3D12Device2> device,
+            uint32_t poolIndex,
+            const D3D12_RESOURCE_DESC& desc,
+            UINT64 size,
+            D3D12_RESOURCE_STATES initialState
+        );
+
+        // Called by GpuAllocation
+        void free(const GpuAllocation& allocation);
+
+    private:
+        Pool pools[POOL_COUNT] = {
+            { D3D12_HEAP_TYPE_UPLOAD,  D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, {} },
+            { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, {} },
+            { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES, {} },
+        };
+
+        size_t dedicated = 0;
+        uint64_t dedicatedBytes = 0;
+
+        // Models may load on other threads than the one drawing
+        mutable std::mutex mutex;
+
+        friend class GpuAllocation;
+};
@@ -2,33 +2,41 @@
 
 IndexBuffer::IndexBuffer(
     ComPtr<ID3D12Device2> device, 
-    const std::vector<uint32_t>& indices
+    UINT capacity,
+    DXGI_FORMAT format
 ) {
-    count = static_cast<UINT>(indices.size());
-    sizeInBytes = static_cast<UINT>(sizeof(uint32_t) * count);
-
-    CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeInBytes);
+    const UINT indexSize = format == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+    sizeInBytes = std::max((indexSize * capacity + 3) & ~3u, 4u);
 
-    throwFailed(device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&buffer)
-    ));
+    buffer = GpuAllocator::instance().createBuffer(device, D3D12_HEAP_TYPE_UPLOAD, sizeInBytes, D3D12_RESOURCE_STATE_GENERIC_READ);
 
+    // Upload heap, stays mapped for the buffer's lifetime
     void* pData;
-
     throwFailed(buffer->Map(0, nullptr, &pData));
-    memcpy(pData, indices.data(), sizeInBytes);
-    buffer->Unmap(0, nullptr);
+    mapped = static_cast<uint8_t*>(pData);
 
     bufferView.BufferLocation = buffer->GetGPUVirtualAddress();
-    bufferView.Format = DXGI_FORMAT_R32_UINT;
-    bufferView.SizeInBytes = sizeInBytes;
-
-    LOG_INFO(L" -> Index buffer created with %d indices", count);
+    bufferView.Format = format;
+    bufferView.SizeInBytes = 0;
 }
 
+void IndexBuffer::update(std::span<const uint32_t> indices) {
+    const UINT indexSize = bufferView.Format == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const UINT bytes = static_cast<UINT>(indices.size()) * indexSize;
+    if (bytes > sizeInBytes) {
+        LOG_ERROR(L"IndexBuffer -> update() of %zu indices overflows the buffer", indices.size());
+        throw std::runtime_error("IndexBuffer overflow");
+    }
+
+    if (indexSize == sizeof(uint16_t)) {
+        uint16_t* dst = reinterpret_cast<uint16_t*>(mapped);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            dst[i] = static_cast<uint16_t>(indices[i]);
+        }
+    } else {
+        memcpy(mapped, indices.data(), bytes);
+    }
+
+    count = static_cast<UINT>(indices.size());
+    bufferView.SizeInBytes = bytes;
+}
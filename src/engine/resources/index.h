@@ -1,17 +1,28 @@
 #pragma once
 
 #include "utils/pch.h"
+#include "gpu_allocator.h"
 
+#include <span>
+
+// Persistently mapped upload buffer for up to capacity indices, rewritten
+// from the CPU with update(). Static indices live in the GeometryPool.
 class IndexBuffer {
     public:
+        // Starts out empty
         IndexBuffer(
             ComPtr<ID3D12Device2> device, 
-            const std::vector<uint32_t>& indices
+            UINT capacity,
+            DXGI_FORMAT format
         );
+
         ~IndexBuffer() = default;
 
+        // The caller makes sure the GPU is done with the old contents
+        void update(std::span<const uint32_t> indices);
+
         ComPtr<ID3D12Resource> getBuffer() const { 
-            return buffer; 
+            return buffer.getResource(); 
         }
 
         UINT getSize() const { 
@@ -22,13 +33,19 @@ class IndexBuffer {
             return count; 
         }
 
+        DXGI_FORMAT getFormat() const {
+            return bufferView.Format;
+        }
+
         D3D12_INDEX_BUFFER_VIEW getView() const {
             return bufferView;
         }
 
     private:
         D3D12_INDEX_BUFFER_VIEW bufferView{};
-        ComPtr<ID3D12Resource> buffer;
+        GpuAllocation buffer;
         UINT sizeInBytes = 0;
         UINT count = 0;
+
+        uint8_t* mapped = nullptr;
 };
\ No newline at end of file
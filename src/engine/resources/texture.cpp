@@ -1,40 +1,188 @@
 
 #include "texture.h"
+#include "upload_ring.h"
 #include "engine/descriptor_heap.h"
+#include "engine/imaging/image_decoder.h"
+#include "engine/imaging/mip_generator.h"
+#include "engine/imaging/texture_file.h"
+#include "utils/mapped_file.h"
 
 Texture::Texture(
     ComPtr<ID3D12Device2> device,
-    ComPtr<ID3D12GraphicsCommandList> cmdList,
+    UploadRing* uploads,
     DescriptorHeap* srvHeap,
     const std::wstring& path,
     UINT descriptorIndex
 ) {
     LOG_INFO(L"[Texture] Descriptor index used: %u", descriptorIndex);
-    loadFromFile(device, cmdList, srvHeap, path, descriptorIndex);
+    loadFromFile(device, uploads, srvHeap, path, descriptorIndex);
     LOG_INFO(L"[Texture] -> after loadFromFile Function ->  Descriptor index used: %u", descriptorIndex);
 
 }
 
 void Texture::loadFromFile(
     ComPtr<ID3D12Device2> device,
-    ComPtr<ID3D12GraphicsCommandList> cmdList,
+    UploadRing* uploads,
     DescriptorHeap* srvHeap,
     const std::wstring& path,
     UINT descriptorIndex
 ) {
     LOG_INFO(L"Texture -> Loading texture from: %s", path.c_str());
 
+    // Cooked DDS / KTX2: no decode, levels stream into upload memory
+    TextureFileLayout layout;
+    if (readTextureFileLayout(std::filesystem::path(path), layout)) {
+        createFromFile(device, uploads, srvHeap, path, layout, descriptorIndex);
+        LOG_INFO(L"Texture -> Successfully streamed %s", path.c_str());
+        return;
+    }
+
     // Load an image file from disk
     ScratchImage image;
-    HRESULT hr = LoadFromWICFile(
-        path.c_str(),
+    HRESULT hr = decode(path, image);
+    
+    if (FAILED(hr)) throw std::runtime_error("Failed to load image with DirectXTex.");
+
+    createFromImage(device, uploads, srvHeap, image, descriptorIndex);
+
+    LOG_INFO(L"Texture -> Successfully loaded %s", path.c_str());
+}
+
+namespace {
+    // WIC needs COM on every thread that decodes. Kept for the thread's lifetime;
+    // a thread already in another apartment (RPC_E_CHANGED_MODE) works as is.
+    struct ComScope {
+        HRESULT result;
+
+        ComScope() : result(CoInitializeEx(nullptr, COINIT_MULTITHREADED)) {}
+
+        ~ComScope() {
+            if (SUCCEEDED(result))
+                CoUninitialize();
+        }
+    };
+
+    void ensureCom() {
+        thread_local ComScope scope;
+    }
+
+    // Asked once, there is only the one device
+    bool supportsUnalignedBlockTextures(ID3D12Device2* device) {
+        static const bool supported = [device]() {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS8 options = {};
+            return SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS8, &options, sizeof(options))) &&
+                options.UnalignedBlockTexturesSupported;
+        }();
+        return supported;
+    }
+
+    // Chain for what the RGBA mip generator doesn't take. DirectXTex has no
+    // Kaiser filter, cubic is the closest.
+    HRESULT generateMipChain(ScratchImage& image, MipFilter mips) {
+        ScratchImage chain;
+        HRESULT hr = GenerateMipMaps(
+            *image.GetImage(0, 0, 0),
+            mips == MipFilter::Kaiser ? TEX_FILTER_CUBIC : TEX_FILTER_BOX,
+            0,
+            chain
+        );
+        if (SUCCEEDED(hr))
+            image = std::move(chain);
+
+        return hr;
+    }
+}
+
+HRESULT Texture::decode(const std::wstring& path, ScratchImage& image, MipFilter mips) {
+    MappedFile file;
+    if (!file.open(std::filesystem::path(path).string()))
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+    return decode(file.getData(), file.getSize(), image, mips);
+}
+
+HRESULT Texture::decode(const void* data, size_t size, ScratchImage& image, MipFilter mips) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    // DDS files the streaming path can't take (arrays, cubes, other formats)
+    if (size >= 4 && std::memcmp(bytes, "DDS ", 4) == 0)
+        return LoadFromDDSMemory(data, size, DDS_FLAGS_NONE, nullptr, image);
+
+    // JPEG / PNG / BMP decode straight into the scratch image, tagged sRGB the
+    // same way WIC_FLAGS_FORCE_SRGB tags WIC's RGBA output. Grayscale stays one
+    // linear channel, the R8_UNORM WIC gives for it.
+    ImageInfo info;
+    if (readImageInfo(bytes, size, info)) {
+        const bool gray = info.channels == 1;
+        const uint32_t levels = mips == MipFilter::None || gray ? 1 : mipLevelCount(info.width, info.height);
+
+        HRESULT hr = image.Initialize2D(gray ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, info.width, info.height, 1, levels);
+        if (FAILED(hr))
+            return hr;
+
+        const Image* target = image.GetImage(0, 0, 0);
+        std::string error;
+        if (decodeImage(bytes, size, info, target->pixels, target->rowPitch, &error)) {
+            if (gray)
+                return mips == MipFilter::None ? S_OK : generateMipChain(image, mips);
+
+            std::vector<MipSurface> surfaces(levels);
+            for (uint32_t level = 0; level < levels; ++level) {
+                const Image* mip = image.GetImage(level, 0, 0);
+                surfaces[level] = { mip->pixels, static_cast<uint32_t>(mip->width), static_cast<uint32_t>(mip->height), mip->rowPitch };
+            }
+            generateMips(surfaces.data(), levels, true, mips);
+            return S_OK;
+        }
+
+        LOG_WARNING(L"Texture -> Portable decode failed (%hs), falling back to WIC", error.c_str());
+        image.Release();
+    }
+
+    // Everything else (TGA, TIFF, 16-bit PNG, CMYK JPEG, ...) still goes through WIC
+    ensureCom();
+    HRESULT hr = LoadFromWICMemory(
+        data,
+        size,
         WIC_FLAGS_FORCE_SRGB,
         nullptr,
         image
     );
-    
-    if (FAILED(hr)) throw std::runtime_error("Failed to load image with DirectXTex.");
+    if (FAILED(hr) || mips == MipFilter::None || image.GetMetadata().mipLevels > 1 || IsCompressed(image.GetMetadata().format))
+        return hr;
+
+    return generateMipChain(image, mips);
+}
+
+Texture::Texture(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    const ScratchImage& image,
+    UINT descriptorIndex
+) {
+    createFromImage(device, uploads, srvHeap, image, descriptorIndex);
+}
 
+Texture::Texture(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    const std::wstring& path,
+    const TextureFileLayout& layout,
+    UINT descriptorIndex,
+    UINT firstMip
+) {
+    createFromFile(device, uploads, srvHeap, path, layout, descriptorIndex, firstMip);
+}
+
+void Texture::createFromImage(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    const ScratchImage& image,
+    UINT descriptorIndex
+) {
     const TexMetadata& meta = image.GetMetadata();
     const Image* img = image.GetImage(0, 0, 0);
 
@@ -52,37 +200,16 @@ void Texture::loadFromFile(
     texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
     texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    // Create GPU texture
-    CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
-    hr = device->CreateCommittedResource(
-        &defaultHeap,
-        D3D12_HEAP_FLAG_NONE,
-        &texDesc,
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        nullptr,
-        IID_PPV_ARGS(&resource)
-    );
-    if (FAILED(hr)) throw std::runtime_error("Failed to create texture resource.");
+    // Create GPU texture, placed in one of the allocator's texture heaps
+    resource = GpuAllocator::instance().createTexture(device, texDesc, D3D12_RESOURCE_STATE_COPY_DEST);
 
-    // Create upload buffer
-    UINT64 uploadBufferSize = GetRequiredIntermediateSize(
-        resource.Get(), 
-        0, 
-        static_cast<UINT>(meta.mipLevels)
-    );
-
-    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
-    auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-
-    hr = device->CreateCommittedResource(
-        &uploadHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &uploadBufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&uploadHeap)
-    );
-    if (FAILED(hr)) throw std::runtime_error("Failed to create texture upload heap.");
+    // Subresource layout in upload memory, offsets relative to where it lands
+    const UINT subresourceCount = static_cast<UINT>(image.GetImageCount());
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+    std::vector<UINT> rowCounts(subresourceCount);
+    std::vector<UINT64> rowSizes(subresourceCount);
+    UINT64 uploadBufferSize = 0;
+    device->GetCopyableFootprints(&texDesc, 0, subresourceCount, 0, layouts.data(), rowCounts.data(), rowSizes.data(), &uploadBufferSize);
 
     // Prepare subresources
     std::vector<D3D12_SUBRESOURCE_DATA> subresources;
@@ -95,19 +222,189 @@ void Texture::loadFromFile(
     );
 
     // Upload
-    UpdateSubresources(
-        cmdList.Get(), 
-        resource.Get(), 
-        uploadHeap.Get(), 
-        0, 
-        0, 
-        static_cast<UINT>(subresources.size()), 
-        subresources.data()
+    UploadAllocation upload = uploads->allocate(uploadBufferSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    auto cmdList = uploads->getCommandList();
+
+    for (UINT i = 0; i < subresourceCount; ++i) {
+        D3D12_MEMCPY_DEST dest = {
+            upload.cpu + layouts[i].Offset,
+            layouts[i].Footprint.RowPitch,
+            SIZE_T(layouts[i].Footprint.RowPitch) * rowCounts[i]
+        };
+        MemcpySubresource(&dest, &subresources[i], static_cast<SIZE_T>(rowSizes[i]), rowCounts[i], layouts[i].Footprint.Depth);
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT placed = layouts[i];
+        placed.Offset += upload.offset;
+
+        CD3DX12_TEXTURE_COPY_LOCATION dst(resource.get(), i);
+        CD3DX12_TEXTURE_COPY_LOCATION src(upload.buffer, placed);
+        cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    }
+
+    createView(device, uploads, srvHeap, meta.format, static_cast<UINT>(meta.mipLevels), descriptorIndex);
+}
+
+void Texture::createFromFile(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    const std::wstring& path,
+    const TextureFileLayout& layout,
+    UINT descriptorIndex,
+    UINT firstMip
+) {
+    sourcePath = path;
+    fileLayout = layout;
+
+    // Block compressed resources can only start where the level is whole blocks
+    const UINT mipCount = getMipCount();
+    residentMip = std::min(firstMip, mipCount - 1);
+    while (residentMip > 0 && !isValidTopLevel(fileLayout, residentMip))
+        residentMip--;
+
+    resource = createFileResource(device, residentMip);
+    uploadFileLevels(device, uploads, resource.get(), sliceTextureLevels(fileLayout, residentMip, mipCount - residentMip), 0);
+
+    createView(device, uploads, srvHeap, static_cast<DXGI_FORMAT>(layout.dxgiFormat), mipCount - residentMip, descriptorIndex);
+}
+
+Texture::Retired Texture::setResidentMip(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    UINT topMip
+) {
+    Retired retired;
+    if (!isStreamable())
+        return retired;
+
+    const UINT mipCount = getMipCount();
+    topMip = std::min(topMip, mipCount - 1);
+    while (topMip > 0 && !isValidTopLevel(fileLayout, topMip))
+        topMip--;
+
+    if (topMip == residentMip)
+        return retired;
+
+    GpuAllocation next = createFileResource(device, topMip);
+
+    // Levels both resources hold are copied on the GPU
+    auto cmdList = uploads->getCommandList();
+    CD3DX12_RESOURCE_BARRIER toSource = CD3DX12_RESOURCE_BARRIER::Transition(
+        resource.get(),
+        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+        D3D12_RESOURCE_STATE_COPY_SOURCE
     );
+    cmdList->ResourceBarrier(1, &toSource);
+
+    for (UINT level = std::max(topMip, residentMip); level < mipCount; ++level) {
+        CD3DX12_TEXTURE_COPY_LOCATION dst(next.get(), level - topMip);
+        CD3DX12_TEXTURE_COPY_LOCATION src(resource.get(), level - residentMip);
+        cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    }
+
+    // The rest come from the file
+    if (topMip < residentMip)
+        uploadFileLevels(device, uploads, next.get(), sliceTextureLevels(fileLayout, topMip, residentMip - topMip), 0);
+
+    retired.resource = std::move(resource);
+    retired.descriptorIndex = descriptorIndex;
 
+    resource = std::move(next);
+    residentMip = topMip;
+    createView(device, uploads, srvHeap, static_cast<DXGI_FORMAT>(fileLayout.dxgiFormat), mipCount - topMip, srvHeap->allocate());
+
+    return retired;
+}
+
+uint64_t Texture::getChainBytes(UINT topMip) const {
+    uint64_t bytes = 0;
+    for (size_t level = topMip; level < fileLayout.levels.size(); ++level) {
+        bytes += static_cast<uint64_t>(fileLayout.levels[level].rowBytes) * fileLayout.levels[level].rowCount;
+    }
+    return bytes;
+}
+
+GpuAllocation Texture::createFileResource(ComPtr<ID3D12Device2> device, UINT topMip) {
+    const TextureFileLevel& top = fileLayout.levels[topMip];
+
+    // Streaming only ever picks aligned levels past 0, so this is an unaligned cooked mip 0
+    if (!isValidTopLevel(fileLayout, topMip) && !supportsUnalignedBlockTextures(device.Get())) {
+        LOG_ERROR(L"Texture -> %s is %ux%u, block compressed sizes must be multiples of 4 on this GPU, cook it again",
+            sourcePath.c_str(), top.width, top.height);
+        throw std::runtime_error("Block compressed texture size isn't a multiple of 4");
+    }
+    const UINT16 mipLevels = static_cast<UINT16>(fileLayout.levels.size() - topMip);
+
+    D3D12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(fileLayout.dxgiFormat), top.width, top.height, 1, mipLevels);
+
+    return GpuAllocator::instance().createTexture(device, texDesc, D3D12_RESOURCE_STATE_COPY_DEST);
+}
+
+void Texture::uploadFileLevels(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    ID3D12Resource* target,
+    const TextureFileLayout& levels,
+    UINT firstSubresource
+) {
+    const DXGI_FORMAT format = static_cast<DXGI_FORMAT>(levels.dxgiFormat);
+    const UINT levelCount = static_cast<UINT>(levels.levels.size());
+
+    // Same layout GetCopyableFootprints would give, computed without the device
+    std::vector<UploadFootprint> footprints;
+    UINT64 uploadBufferSize = computeUploadFootprints(levels, 0, footprints);
+
+#ifdef _DEBUG
+    D3D12_RESOURCE_DESC targetDesc = target->GetDesc();
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> expected(levelCount);
+    UINT64 expectedSize = 0;
+    device->GetCopyableFootprints(&targetDesc, firstSubresource, levelCount, 0, expected.data(), nullptr, nullptr, &expectedSize);
+    for (UINT i = 0; i < levelCount; ++i) {
+        if (expected[i].Offset != footprints[i].offset || expected[i].Footprint.RowPitch != footprints[i].rowPitch)
+            LOG_WARNING(L"Texture -> Footprint %u differs from the device (offset %llu vs %llu)", i, footprints[i].offset, expected[i].Offset);
+    }
+    if (expectedSize != uploadBufferSize)
+        LOG_WARNING(L"Texture -> Upload size %llu differs from the device (%llu)", uploadBufferSize, expectedSize);
+#endif
+
+    // Mip data goes from the file straight into the mapped ring
+    UploadAllocation upload = uploads->allocate(uploadBufferSize, UPLOAD_PLACEMENT_ALIGNMENT);
+
+    std::string error;
+    if (!readTextureLevels(std::filesystem::path(sourcePath), levels, footprints, upload.cpu, &error)) {
+        LOG_ERROR(L"Texture -> Failed to read %s (%hs)", sourcePath.c_str(), error.c_str());
+        throw std::runtime_error("Failed to read texture file.");
+    }
+
+    auto cmdList = uploads->getCommandList();
+    for (UINT i = 0; i < levelCount; ++i) {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT placed = {};
+        placed.Offset = upload.offset + footprints[i].offset;
+        placed.Footprint.Format = format;
+        placed.Footprint.Width = footprints[i].width;
+        placed.Footprint.Height = footprints[i].height;
+        placed.Footprint.Depth = 1;
+        placed.Footprint.RowPitch = footprints[i].rowPitch;
+
+        CD3DX12_TEXTURE_COPY_LOCATION dst(target, firstSubresource + i);
+        CD3DX12_TEXTURE_COPY_LOCATION src(upload.buffer, placed);
+        cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    }
+}
+
+void Texture::createView(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    DXGI_FORMAT format,
+    UINT mipLevels,
+    UINT descriptorIndex
+) {
     // Transition to PIXEL_SHADER_RESOURCE
+    auto cmdList = uploads->getCommandList();
     CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        resource.Get(),
+        resource.get(),
         D3D12_RESOURCE_STATE_COPY_DEST,
         D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
     );
@@ -116,16 +413,15 @@ void Texture::loadFromFile(
     // Create SRV in descriptor heap
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Format = meta.format;
+    srvDesc.Format = format;
     srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = static_cast<UINT>(meta.mipLevels);
+    srvDesc.Texture2D.MipLevels = mipLevels;
 
     auto cpuHandle = srvHeap->getCPUHandle(descriptorIndex);
+    this->descriptorIndex = descriptorIndex;
 
-    device->CreateShaderResourceView(resource.Get(), &srvDesc, cpuHandle);
+    device->CreateShaderResourceView(resource.get(), &srvDesc, cpuHandle);
 
     gpuHandle = srvHeap->getGPUHandle(descriptorIndex);
     LOG_INFO(L"[Texture] GPU handle after SRV creation = 0x%llX", gpuHandle.ptr);
-
-    LOG_INFO(L"Texture -> Successfully loaded %s", path.c_str());
 }
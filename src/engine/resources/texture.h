@@ -1,42 +1,183 @@
 #pragma once
 
 #include "utils/pch.h"
+#include "gpu_allocator.h"
+#include "engine/imaging/mip_generator.h"
+#include "engine/imaging/texture_file.h"
 
 class DescriptorHeap;
+class UploadRing;
 
 class Texture {
     public:
         Texture(
             ComPtr<ID3D12Device2> device,
-            ComPtr<ID3D12GraphicsCommandList> cmdList,
+            UploadRing* uploads,
             DescriptorHeap* srvHeap,
             const std::wstring& path,
             UINT descriptorIndex
         );
 
+        // From an image decode() already produced, e.g. on a worker thread
+        Texture(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            const ScratchImage& image,
+            UINT descriptorIndex
+        );
+
+        // Cooked DDS / KTX2 streamed from disk into upload memory, see createFromFile
+        Texture(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            const std::wstring& path,
+            const TextureFileLayout& layout,
+            UINT descriptorIndex,
+            UINT firstMip = 0
+        );
+
+        // What a change of resident mips leaves behind. Still referenced by frames
+        // in flight, so it is released once the GPU is past them.
+        struct Retired {
+            GpuAllocation resource;
+            UINT descriptorIndex = UINT_MAX;
+        };
+
+        // CPU half of loading, no device access. Safe on any thread. JPEG, PNG and
+        // BMP use the portable decoder; other formats go through WIC, with COM set
+        // up for the calling thread on first use. Unless mips is None the image
+        // comes back with its full mip chain, filtered in linear space.
+        static HRESULT decode(const std::wstring& path, ScratchImage& image, MipFilter mips = MipFilter::Box);
+        static HRESULT decode(const void* data, size_t size, ScratchImage& image, MipFilter mips = MipFilter::Box);
+
         ~Texture() = default;
 
         void loadFromFile(
             ComPtr<ID3D12Device2> device,
-            ComPtr<ID3D12GraphicsCommandList> cmdList,
+            UploadRing* uploads,
             DescriptorHeap* srvHeap,
             const std::wstring& path,
             UINT descriptorIndex
         );
 
+        // GPU half: copies the image into ring memory, records the upload and writes the SRV
+        void createFromImage(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            const ScratchImage& image,
+            UINT descriptorIndex
+        );
+
+        // For cooked files: footprints are computed from the header, then every
+        // mip is read from disk directly into ring memory at its row
+        // pitch and copied with CopyTextureRegion. No ScratchImage in between.
+        // firstMip > 0 leaves the larger levels on disk, the resource then starts
+        // at that level and setResidentMip() can bring the rest in later.
+        void createFromFile(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            const std::wstring& path,
+            const TextureFileLayout& layout,
+            UINT descriptorIndex,
+            UINT firstMip = 0
+        );
+
+        // Cooked textures only. Records a move to a resource holding levels
+        // [topMip, mip count): levels both have are copied on the GPU, newly
+        // resident ones are read from the file. The SRV moves to a new slot so
+        // frames in flight keep sampling the old one; the caller releases what
+        // comes back once those frames are done.
+        Retired setResidentMip(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            UINT topMip
+        );
+
         ComPtr<ID3D12Resource> getResource() const { 
-            return resource; 
+            return resource.getResource(); 
         }
 
         D3D12_GPU_DESCRIPTOR_HANDLE getGPUHandle() const { 
             return gpuHandle; 
         }
 
+        // Changes when the resident mips do, the owner releases whatever it is last
+        UINT getDescriptorIndex() const {
+            return descriptorIndex;
+        }
+
+        // Cooked files keep their layout so mips can be loaded later
+        bool isStreamable() const {
+            return !sourcePath.empty();
+        }
+
+        const TextureFileLayout& getFileLayout() const {
+            return fileLayout;
+        }
+
+        UINT getMipCount() const {
+            return static_cast<UINT>(fileLayout.levels.size());
+        }
+
+        // Most detailed level on the GPU, 0 when the whole chain is
+        UINT getResidentMip() const {
+            return residentMip;
+        }
+
+        // Bytes of levels [topMip, mip count) as stored in the file
+        uint64_t getChainBytes(UINT topMip) const;
+
+        // Most detailed mip some draw wants this frame, the smallest request wins
+        void requestMip(UINT mip) {
+            requestedMip = std::min(requestedMip, mip);
+        }
+
+        // This frame's request, UINT_MAX when nothing asked. Clears it.
+        UINT takeRequestedMip() {
+            UINT mip = requestedMip;
+            requestedMip = UINT_MAX;
+            return mip;
+        }
+
     private:
-        ComPtr<ID3D12Resource> resource;
-        ComPtr<ID3D12Resource> uploadHeap;
+        GpuAllocation resource;
 
         D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle;
+        UINT descriptorIndex = UINT_MAX;
+
+        // Cooked files: where the levels are and which of them are resident
+        std::wstring sourcePath;
+        TextureFileLayout fileLayout;
+        UINT residentMip = 0;
+        UINT requestedMip = UINT_MAX;
 
         void loadFromFile(ComPtr<ID3D12Device2> device, const std::wstring& path);
+
+        // Reads levels from the file into ring memory and records their copies
+        // into target starting at firstSubresource
+        void uploadFileLevels(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            ID3D12Resource* target,
+            const TextureFileLayout& levels,
+            UINT firstSubresource
+        );
+
+        // Texture for levels [topMip, mip count) of fileLayout, in COPY_DEST
+        GpuAllocation createFileResource(ComPtr<ID3D12Device2> device, UINT topMip);
+
+        // Barrier to PIXEL_SHADER_RESOURCE and the SRV, shared by both upload paths
+        void createView(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            DXGI_FORMAT format,
+            UINT mipLevels,
+            UINT descriptorIndex
+        );
 };
\ No newline at end of file
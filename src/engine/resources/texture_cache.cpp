@@ -0,0 +1,400 @@
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "engine/descriptor_heap.h"
+#include "engine/imaging/rect_packer.h"
+#include "utils/hash.h"
+#include "utils/mapped_file.h"
+#include "utils/thread_pool.h"
+
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // Atlas candidates are at most this size on both sides
+    constexpr uint32_t ATLAS_MAX_IMAGE_SIZE = 512;
+    constexpr uint32_t ATLAS_MAX_SIZE = 2048;
+
+    // Gutter around each image and cell alignment. Cells on an 8-texel grid stay
+    // separate through three 2x2 reductions, and an 8-texel gutter still leaves
+    // one texel for bilinear taps at the third, so the atlas keeps four levels.
+    constexpr uint32_t ATLAS_PADDING = 8;
+    constexpr uint32_t ATLAS_ALIGNMENT = 8;
+    constexpr uint32_t ATLAS_MIP_LEVELS = 4;
+
+    uint32_t alignUp(uint32_t value, uint32_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Copies image into the cell at (x, y), the padding around it clamped to its edges
+    void blitPadded(const Image& image, uint8_t* atlas, size_t atlasPitch, const PackRect& cell) {
+        const int width = static_cast<int>(image.width);
+        const int height = static_cast<int>(image.height);
+
+        for (uint32_t row = 0; row < cell.height; ++row) {
+            int srcY = std::clamp(static_cast<int>(row) - static_cast<int>(ATLAS_PADDING), 0, height - 1);
+            const uint32_t* src = reinterpret_cast<const uint32_t*>(image.pixels + srcY * image.rowPitch);
+            uint32_t* dst = reinterpret_cast<uint32_t*>(atlas + (cell.y + row) * atlasPitch) + cell.x;
+
+            for (uint32_t column = 0; column < cell.width; ++column) {
+                int srcX = std::clamp(static_cast<int>(column) - static_cast<int>(ATLAS_PADDING), 0, width - 1);
+                dst[column] = src[srcX];
+            }
+        }
+    }
+
+    // Same file, same key: resolves ./ and ../, and case on Windows
+    std::wstring canonicalKey(const std::wstring& path) {
+        std::error_code ec;
+        fs::path canonical = fs::weakly_canonical(fs::path(path), ec);
+        std::wstring key = ec ? fs::path(path).lexically_normal().wstring() : canonical.wstring();
+
+#ifdef _WIN32
+        std::transform(key.begin(), key.end(), key.begin(), [](wchar_t c) { return static_cast<wchar_t>(towlower(c)); });
+#endif
+        return key;
+    }
+}
+
+TextureCache::TextureCache(
+    ComPtr<ID3D12Device2> device,
+    DescriptorHeap* srvHeap,
+    bool hashContents,
+    MipFilter mipFilter,
+    TextureStreamer* streamer
+) :
+    device(device),
+    srvHeap(srvHeap),
+    hashContents(hashContents),
+    mipFilter(mipFilter),
+    streamer(streamer)
+{}
+
+TextureCache::DecodedImage TextureCache::decode(const std::wstring& path, bool hashContents, MipFilter mipFilter) {
+    DecodedImage decoded;
+
+    // One read of the file serves both the content hash and the decoder
+    MappedFile file;
+    if (!file.open(fs::path(path).string())) {
+        decoded.result = HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+        return decoded;
+    }
+
+    if (hashContents) {
+        decoded.contentHash = hashCombine(hashBytes(file.getData(), file.getSize()), file.getSize());
+    }
+
+    if (parseTextureFile(file.getData(), file.getSize(), file.getSize(), decoded.layout)) {
+        decoded.cooked = true;
+        decoded.result = S_OK;
+        return decoded;
+    }
+
+    decoded.result = Texture::decode(file.getData(), file.getSize(), decoded.image, mipFilter);
+    return decoded;
+}
+
+void TextureCache::prefetch(const std::wstring& path) {
+    const std::wstring key = canonicalKey(path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = byPath.find(key);
+    if ((it != byPath.end() && !it->second.expired()) || pending.count(key))
+        return;
+
+    const bool hash = hashContents;
+    const MipFilter filter = mipFilter;
+    pending.emplace(key, ThreadPool::instance().submit([path, hash, filter]() {
+        return decode(path, hash, filter);
+    }));
+}
+
+std::shared_ptr<Texture> TextureCache::get(
+    UploadRing* uploads,
+    const std::wstring& path
+) {
+    const std::wstring key = canonicalKey(path);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = byPath.find(key);
+        if (it != byPath.end()) {
+            if (std::shared_ptr<Texture> texture = it->second.lock()) {
+                stats.hits++;
+                return texture;
+            }
+            byPath.erase(it);
+        }
+    }
+
+    DecodedImage decoded = takeDecoded(key, path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Copies of one image under different names (common in exported asset folders)
+    if (decoded.contentHash != 0) {
+        auto contentIt = byContent.find(decoded.contentHash);
+        if (contentIt != byContent.end()) {
+            if (std::shared_ptr<Texture> texture = contentIt->second.lock()) {
+                stats.contentHits++;
+                byPath[key] = texture;
+                return texture;
+            }
+            byContent.erase(contentIt);
+        }
+    }
+
+    if (FAILED(decoded.result)) {
+        LOG_ERROR(L"TextureCache -> Failed to decode %s (0x%08X)", path.c_str(), static_cast<unsigned>(decoded.result));
+        throw std::runtime_error("Failed to load image with DirectXTex.");
+    }
+
+    if (decoded.cooked) {
+        LOG_INFO(L"TextureCache -> Streaming %s (%ux%u, %zu mips)", path.c_str(), decoded.layout.width, decoded.layout.height, decoded.layout.levels.size());
+        stats.streamed++;
+    } else {
+        const TexMetadata& meta = decoded.image.GetMetadata();
+        LOG_INFO(L"TextureCache -> Uploading %s (%zux%zu, %zu mips)", path.c_str(), meta.width, meta.height, meta.mipLevels);
+    }
+
+    std::shared_ptr<Texture> texture = create(uploads, path, decoded);
+    stats.misses++;
+
+    byPath[key] = texture;
+    if (decoded.contentHash != 0)
+        byContent[decoded.contentHash] = texture;
+
+    return texture;
+}
+
+TextureCache::DecodedImage TextureCache::takeDecoded(const std::wstring& key, const std::wstring& path) {
+    std::future<DecodedImage> future;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto pendingIt = pending.find(key);
+        if (pendingIt != pending.end()) {
+            future = std::move(pendingIt->second);
+            pending.erase(pendingIt);
+        }
+    }
+
+    if (!future.valid())
+        return decode(path, hashContents, mipFilter);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    DecodedImage decoded = future.get();
+    stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    stats.prefetched++;
+    return decoded;
+}
+
+TextureAtlas TextureCache::getAtlas(
+    UploadRing* uploads,
+    std::span<const std::wstring> paths
+) {
+    TextureAtlas atlas;
+    atlas.regions.resize(paths.size());
+
+    std::vector<std::wstring> keys;
+    std::wstring atlasKey;
+    for (const std::wstring& path : paths) {
+        keys.push_back(canonicalKey(path));
+        atlasKey += keys.back() + L"|";
+    }
+
+    // Candidates: small RGBA images nothing has uploaded on its own yet
+    std::vector<size_t> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto atlasIt = atlases.find(atlasKey);
+        if (atlasIt != atlases.end()) {
+            if (std::shared_ptr<Texture> texture = atlasIt->second.texture.lock()) {
+                stats.hits++;
+                atlas.texture = texture;
+                atlas.regions = atlasIt->second.regions;
+
+                // Images left out are live on their own unless they went away since
+                for (size_t i = 0; i < paths.size(); ++i) {
+                    if (atlas.regions[i].packed) {
+                        atlas.regions[i].texture = texture;
+                    } else if (auto it = byPath.find(keys[i]); it != byPath.end()) {
+                        atlas.regions[i].texture = it->second.lock();
+                    }
+                }
+                return atlas;
+            }
+            atlases.erase(atlasIt);
+        }
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            auto it = byPath.find(keys[i]);
+            if (it != byPath.end())
+                atlas.regions[i].texture = it->second.lock();
+
+            if (atlas.regions[i].texture) {
+                stats.hits++;
+            } else {
+                candidates.push_back(i);
+            }
+        }
+    }
+
+    std::vector<DecodedImage> decoded(paths.size());
+    std::vector<PackRect> cells;
+    std::vector<size_t> cellImages;
+    uint64_t cellArea = 0;
+
+    for (size_t i : candidates) {
+        decoded[i] = takeDecoded(keys[i], paths[i]);
+        if (FAILED(decoded[i].result) || decoded[i].cooked)
+            continue;
+
+        const TexMetadata& meta = decoded[i].image.GetMetadata();
+        if (meta.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || meta.arraySize != 1 ||
+            meta.width > ATLAS_MAX_IMAGE_SIZE || meta.height > ATLAS_MAX_IMAGE_SIZE)
+            continue;
+
+        PackRect cell;
+        cell.width = alignUp(static_cast<uint32_t>(meta.width) + 2 * ATLAS_PADDING, ATLAS_ALIGNMENT);
+        cell.height = alignUp(static_cast<uint32_t>(meta.height) + 2 * ATLAS_PADDING, ATLAS_ALIGNMENT);
+        cellArea += static_cast<uint64_t>(cell.width) * cell.height;
+        cells.push_back(cell);
+        cellImages.push_back(i);
+    }
+
+    // Smallest power of two square that takes everything, past the limit whatever fits
+    size_t packedCount = 0;
+    uint32_t size = 256;
+    if (cells.size() >= 2) {
+        while (static_cast<uint64_t>(size) * size < cellArea && size < ATLAS_MAX_SIZE)
+            size *= 2;
+
+        packedCount = packRects(cells, size, size);
+        while (packedCount < cells.size() && size < ATLAS_MAX_SIZE) {
+            size *= 2;
+            packedCount = packRects(cells, size, size);
+        }
+    }
+
+    if (packedCount >= 2) {
+        DecodedImage atlasImage;
+        const uint32_t levels = std::min(ATLAS_MIP_LEVELS, mipLevelCount(size, size));
+        throwFailed(atlasImage.image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, size, size, 1, levels));
+
+        const Image* target = atlasImage.image.GetImage(0, 0, 0);
+        std::memset(target->pixels, 0, target->slicePitch);
+
+        for (size_t c = 0; c < cells.size(); ++c) {
+            if (!cells[c].packed)
+                continue;
+
+            const size_t i = cellImages[c];
+            const TexMetadata& meta = decoded[i].image.GetMetadata();
+            blitPadded(*decoded[i].image.GetImage(0, 0, 0), target->pixels, target->rowPitch, cells[c]);
+
+            AtlasRegion& region = atlas.regions[i];
+            region.packed = true;
+            region.offset = { static_cast<float>(cells[c].x + ATLAS_PADDING) / size, static_cast<float>(cells[c].y + ATLAS_PADDING) / size };
+            region.scale = { static_cast<float>(meta.width) / size, static_cast<float>(meta.height) / size };
+        }
+
+        std::vector<MipSurface> surfaces(levels);
+        for (uint32_t level = 0; level < levels; ++level) {
+            const Image* mip = atlasImage.image.GetImage(level, 0, 0);
+            surfaces[level] = { mip->pixels, static_cast<uint32_t>(mip->width), static_cast<uint32_t>(mip->height), mip->rowPitch };
+        }
+        generateMips(surfaces.data(), levels, true, MipFilter::Box);
+
+        LOG_INFO(L"TextureCache -> Packed %zu of %zu images into a %ux%u atlas", packedCount, paths.size(), size, size);
+        atlas.texture = create(uploads, L"", atlasImage);
+
+        stats.atlases++;
+        stats.atlased += packedCount;
+    }
+
+    // Everything decoded but not packed is uploaded on its own now, so the decode isn't lost
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i : candidates) {
+        if (atlas.regions[i].packed) {
+            atlas.regions[i].texture = atlas.texture;
+            continue;
+        }
+        if (FAILED(decoded[i].result))
+            continue;
+
+        std::shared_ptr<Texture> texture = create(uploads, paths[i], decoded[i]);
+        stats.misses++;
+
+        byPath[keys[i]] = texture;
+        if (decoded[i].contentHash != 0)
+            byContent[decoded[i].contentHash] = texture;
+        atlas.regions[i].texture = std::move(texture);
+    }
+
+    if (atlas.texture) {
+        AtlasEntry& entry = atlases[atlasKey];
+        entry.texture = atlas.texture;
+        entry.regions = atlas.regions;
+        for (AtlasRegion& region : entry.regions)
+            region.texture.reset();
+    }
+
+    return atlas;
+}
+
+std::shared_ptr<Texture> TextureCache::create(
+    UploadRing* uploads,
+    const std::wstring& path,
+    const DecodedImage& decoded
+) {
+    UINT descriptorIndex = srvHeap->allocate();
+
+    Texture* texture = nullptr;
+    try {
+        if (decoded.cooked) {
+            const UINT firstMip = streamer ? TextureStreamer::baseMip(decoded.layout) : 0;
+            texture = new Texture(device, uploads, srvHeap, path, decoded.layout, descriptorIndex, firstMip);
+        } else {
+            texture = new Texture(device, uploads, srvHeap, decoded.image, descriptorIndex);
+        }
+    } catch (...) {
+        srvHeap->release(descriptorIndex);
+        throw;
+    }
+
+    // The SRV slot goes back to the heap with the last reference. Callers release
+    // textures only once the GPU is done with them (model unload after a flush).
+    // Streaming moves the SRV, so the slot is whichever the texture holds last.
+    DescriptorHeap* heap = srvHeap;
+    std::shared_ptr<Texture> shared(texture, [heap](Texture* t) {
+        heap->release(t->getDescriptorIndex());
+        delete t;
+    });
+
+    if (streamer && decoded.cooked)
+        streamer->add(shared);
+
+    return shared;
+}
+
+size_t TextureCache::getLiveCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Content hits put several paths on one texture, count each texture once
+    std::unordered_set<const Texture*> live;
+    for (const auto& [key, texture] : byPath) {
+        if (std::shared_ptr<Texture> shared = texture.lock())
+            live.insert(shared.get());
+    }
+    return live.size();
+}
+
+void TextureCache::logStats() const {
+    LOG_INFO(L"TextureCache -> %zu hits, %zu content hits, %zu misses (%zu decoded ahead, %zu streamed, %.2f ms waited), %zu images in %zu atlases, %zu live textures, %u descriptors in use",
+        stats.hits, stats.contentHits, stats.misses, stats.prefetched, stats.streamed, stats.waitMs, stats.atlased, stats.atlases, getLiveCount(), srvHeap->getAllocatedCount());
+}
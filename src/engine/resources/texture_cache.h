@@ -0,0 +1,142 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "texture.h"
+
+#include <future>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+class DescriptorHeap;
+class TextureStreamer;
+class UploadRing;
+
+struct TextureCacheStats {
+    size_t hits = 0;        // same canonical path as a live texture
+    size_t contentHits = 0; // different path, identical file bytes
+    size_t misses = 0;      // decoded and uploaded
+    size_t streamed = 0;    // misses that were cooked files read straight into upload memory
+    size_t prefetched = 0;  // misses whose decode had already run on the thread pool
+    size_t atlases = 0;     // atlas textures built
+    size_t atlased = 0;     // images packed into them
+    double waitMs = 0.0;    // get() blocked on unfinished decodes
+};
+
+// Where one image landed in an atlas: atlas uv = offset + uv * scale
+struct AtlasRegion {
+    bool packed = false;
+    XMFLOAT2 offset = { 0.0f, 0.0f };
+    XMFLOAT2 scale = { 1.0f, 1.0f };
+
+    // What to bind for the image: the atlas when packed, else its own texture.
+    // Null when it couldn't be loaded.
+    std::shared_ptr<Texture> texture;
+};
+
+struct TextureAtlas {
+    std::shared_ptr<Texture> texture; // null when nothing was packed
+    std::vector<AtlasRegion> regions; // one per path asked for, same order
+};
+
+// Shared textures across meshes and models. Entries are keyed by canonical
+// path and, optionally, by a hash of the file contents. The cache only holds
+// weak references: a texture and its SRV slot go away with the last
+// shared_ptr, so unloading a model frees what nothing else uses.
+//
+// Decoding is the slow part, so callers prefetch() paths as soon as they know
+// them (model import does it per mesh) and the thread pool decodes while the
+// import carries on. get() later only waits for whatever isn't done yet, then
+// records the uploads back to back. Mip chains are built as part of the
+// decode, so the cache holds and uploads every level. With a streamer, cooked
+// files only upload their small mips and the streamer manages the rest.
+class TextureCache {
+    public:
+        TextureCache(
+            ComPtr<ID3D12Device2> device,
+            DescriptorHeap* srvHeap,
+            bool hashContents = false,
+            MipFilter mipFilter = MipFilter::Box,
+            TextureStreamer* streamer = nullptr
+        );
+
+        ~TextureCache() = default;
+
+        // Starts decoding on the thread pool unless the texture is live or already
+        // queued. Thread safe, no device access.
+        void prefetch(const std::wstring& path);
+
+        // On a miss the upload is recorded into the ring's open batch, which must
+        // be submitted before the texture is sampled. Throws if the image can't be loaded.
+        // Call from the thread that records the upload.
+        std::shared_ptr<Texture> get(
+            UploadRing* uploads,
+            const std::wstring& path
+        );
+
+        // Packs the small RGBA images among paths into one atlas texture, with
+        // edge-replicated gutters and cells aligned so the four mips the atlas
+        // keeps filter without bleeding between neighbours. Images that are too
+        // large, cooked, already live or don't fit are left out (packed = false)
+        // and uploaded as their own textures, handed back in their regions.
+        // The same set of paths gets the same atlas while it is alive.
+        TextureAtlas getAtlas(
+            UploadRing* uploads,
+            std::span<const std::wstring> paths
+        );
+
+        const TextureCacheStats& getStats() const {
+            return stats;
+        }
+
+        // Live textures, and the SRV slots they hold
+        size_t getLiveCount() const;
+
+        void logStats() const;
+
+    private:
+        struct DecodedImage {
+            ScratchImage image;
+            uint64_t contentHash = 0; // 0 when not hashed or unreadable
+            HRESULT result = E_FAIL;
+
+            // Cooked DDS / KTX2: only the header is parsed, get() streams the levels
+            bool cooked = false;
+            TextureFileLayout layout;
+        };
+
+        static DecodedImage decode(const std::wstring& path, bool hashContents, MipFilter mipFilter);
+
+        // The prefetched decode if there is one (waiting for it), else decodes now
+        DecodedImage takeDecoded(const std::wstring& key, const std::wstring& path);
+
+        std::shared_ptr<Texture> create(
+            UploadRing* uploads,
+            const std::wstring& path,
+            const DecodedImage& decoded
+        );
+
+    private:
+        ComPtr<ID3D12Device2> device;
+        DescriptorHeap* srvHeap = nullptr;
+        bool hashContents = false;
+        MipFilter mipFilter = MipFilter::Box;
+        TextureStreamer* streamer = nullptr;
+
+        std::unordered_map<std::wstring, std::weak_ptr<Texture>> byPath;
+        std::unordered_map<uint64_t, std::weak_ptr<Texture>> byContent;
+        std::unordered_map<std::wstring, std::future<DecodedImage>> pending;
+
+        // Keyed by the canonical paths packed, in order. Regions keep no textures,
+        // the cache only holds weak references.
+        struct AtlasEntry {
+            std::weak_ptr<Texture> texture;
+            std::vector<AtlasRegion> regions;
+        };
+        std::unordered_map<std::wstring, AtlasEntry> atlases;
+
+        // prefetch() runs on import workers while get() runs on the main thread
+        mutable std::mutex mutex;
+
+        TextureCacheStats stats;
+};
@@ -0,0 +1,211 @@
+#include "texture_streamer.h"
+#include "upload_ring.h"
+#include "engine/command_queue.h"
+#include "engine/descriptor_heap.h"
+
+namespace {
+    // Levels this size and smaller come with the texture and are never evicted
+    constexpr uint32_t STREAM_BASE_SIZE = 64;
+
+    // Disk reads per update, a camera cut spreads over a few frames instead of one long one
+    constexpr uint64_t STREAM_UPLOAD_PER_UPDATE = 32ull << 20;
+
+    constexpr double MEGABYTE = 1024.0 * 1024.0;
+}
+
+TextureStreamer::TextureStreamer(
+    ComPtr<ID3D12Device2> device,
+    UploadRing* uploads,
+    DescriptorHeap* srvHeap,
+    uint64_t budgetBytes
+) :
+    device(device),
+    uploads(uploads),
+    srvHeap(srvHeap)
+{
+    stats.budgetBytes = budgetBytes;
+}
+
+TextureStreamer::~TextureStreamer() {
+    releaseRetired(true);
+}
+
+UINT TextureStreamer::baseMip(const TextureFileLayout& layout) {
+    UINT mip = 0;
+    while (mip + 1 < layout.levels.size() && std::max(layout.levels[mip].width, layout.levels[mip].height) > STREAM_BASE_SIZE) {
+        mip++;
+    }
+
+    // Block compressed textures have to start at whole blocks
+    while (mip > 0 && !isValidTopLevel(layout, mip)) {
+        mip--;
+    }
+    return mip;
+}
+
+void TextureStreamer::add(const std::shared_ptr<Texture>& texture) {
+    Entry entry;
+    entry.texture = texture;
+    entry.baseMip = baseMip(texture->getFileLayout());
+    entry.wantedMip = entry.baseMip;
+    entry.lastRequested = frame;
+    entries.push_back(entry);
+}
+
+void TextureStreamer::update() {
+    frame++;
+    releaseRetired(false);
+
+    // This frame's requests, dropping textures nothing uses anymore
+    std::vector<std::shared_ptr<Texture>> live;
+    live.reserve(entries.size());
+
+    uint64_t resident = 0;
+    uint64_t requested = 0;
+    size_t kept = 0;
+    for (Entry& entry : entries) {
+        std::shared_ptr<Texture> texture = entry.texture.lock();
+        if (!texture)
+            continue;
+
+        UINT request = texture->takeRequestedMip();
+        if (request != UINT_MAX) {
+            entry.wantedMip = std::min(request, entry.baseMip);
+            entry.lastRequested = frame;
+        }
+
+        resident += texture->getChainBytes(texture->getResidentMip());
+        requested += texture->getChainBytes(entry.wantedMip);
+
+        entries[kept++] = entry;
+        live.push_back(std::move(texture));
+    }
+    entries.resize(kept);
+
+    // What a texture can give back: detail beyond this frame's request, or
+    // everything above the base when nothing asked for it this frame
+    auto evictTarget = [&](size_t i) {
+        return entries[i].lastRequested == frame ? entries[i].wantedMip : entries[i].baseMip;
+    };
+
+    std::vector<size_t> victims;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (live[i]->getResidentMip() < evictTarget(i))
+            victims.push_back(i);
+    }
+
+    // Unneeded detail on visible textures first, then least recently requested
+    std::sort(victims.begin(), victims.end(), [&](size_t a, size_t b) {
+        const bool visibleA = entries[a].lastRequested == frame;
+        const bool visibleB = entries[b].lastRequested == frame;
+        if (visibleA != visibleB)
+            return visibleA;
+        return entries[a].lastRequested < entries[b].lastRequested;
+    });
+
+    size_t nextVictim = 0;
+    auto evictOne = [&]() {
+        if (nextVictim == victims.size())
+            return false;
+
+        const size_t i = victims[nextVictim++];
+        Texture& texture = *live[i];
+        const uint64_t before = texture.getChainBytes(texture.getResidentMip());
+        setResidentMip(texture, evictTarget(i));
+        resident -= before - texture.getChainBytes(texture.getResidentMip());
+        stats.evictions++;
+        return true;
+    };
+
+    std::vector<size_t> upgrades;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].lastRequested == frame && entries[i].wantedMip < live[i]->getResidentMip())
+            upgrades.push_back(i);
+    }
+
+    // Furthest from what they should show first
+    std::sort(upgrades.begin(), upgrades.end(), [&](size_t a, size_t b) {
+        return live[a]->getResidentMip() - entries[a].wantedMip > live[b]->getResidentMip() - entries[b].wantedMip;
+    });
+
+    uint64_t uploaded = 0;
+    for (size_t i : upgrades) {
+        Texture& texture = *live[i];
+        const UINT current = texture.getResidentMip();
+        const uint64_t currentBytes = texture.getChainBytes(current);
+
+        UINT target = entries[i].wantedMip;
+        if (uploaded > 0 && uploaded + texture.getChainBytes(target) - currentBytes > STREAM_UPLOAD_PER_UPDATE)
+            continue;
+
+        // Make room, or settle for fewer levels once nothing else can give any back
+        while (target < current && resident + texture.getChainBytes(target) - currentBytes > stats.budgetBytes) {
+            if (!evictOne())
+                target++;
+        }
+        if (target == current)
+            continue;
+
+        setResidentMip(texture, target);
+
+        const uint64_t added = texture.getChainBytes(texture.getResidentMip()) - currentBytes;
+        resident += added;
+        uploaded += added;
+        stats.upgrades++;
+    }
+
+    // A lowered budget, or more textures than it fits
+    while (resident > stats.budgetBytes && evictOne()) {}
+
+    if (!pendingRetired.empty()) {
+        UINT64 fenceValue = uploads->submit();
+
+        LOG_INFO(L"TextureStreamer -> %zu textures changed, %.1f MB uploaded, %.1f / %.1f MB resident",
+            pendingRetired.size(), uploaded / MEGABYTE, resident / MEGABYTE, stats.budgetBytes / MEGABYTE);
+
+        retired.push_back({ fenceValue, std::move(pendingRetired) });
+        pendingRetired.clear();
+    }
+
+    stats.textures = live.size();
+    stats.fullyResident = std::count_if(live.begin(), live.end(), [](const std::shared_ptr<Texture>& texture) {
+        return texture->getResidentMip() == 0;
+    });
+    stats.residentBytes = resident;
+    stats.requestedBytes = requested;
+}
+
+void TextureStreamer::setResidentMip(Texture& texture, UINT topMip) {
+    const UINT before = texture.getResidentMip();
+    Texture::Retired old = texture.setResidentMip(device, uploads, srvHeap, topMip);
+    if (!old.resource)
+        return;
+
+    if (texture.getResidentMip() < before)
+        stats.uploadedBytes += texture.getChainBytes(texture.getResidentMip()) - texture.getChainBytes(before);
+
+    pendingRetired.push_back(std::move(old));
+}
+
+void TextureStreamer::releaseRetired(bool wait) {
+    CommandQueue* queue = uploads->getQueue();
+    while (!retired.empty()) {
+        RetiredBatch& batch = retired.front();
+        if (!queue->isFenceComplete(batch.fenceValue)) {
+            if (!wait)
+                break;
+            queue->fenceWait(batch.fenceValue);
+        }
+
+        for (const Texture::Retired& texture : batch.textures) {
+            srvHeap->release(texture.descriptorIndex);
+        }
+        retired.pop_front();
+    }
+}
+
+void TextureStreamer::logStats() const {
+    LOG_INFO(L"TextureStreamer -> %zu textures (%zu at full resolution), %.1f MB resident of %.1f MB budget, %.1f MB requested, %zu upgrades, %zu evictions, %.1f MB uploaded",
+        stats.textures, stats.fullyResident, stats.residentBytes / MEGABYTE, stats.budgetBytes / MEGABYTE, stats.requestedBytes / MEGABYTE,
+        stats.upgrades, stats.evictions, stats.uploadedBytes / MEGABYTE);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "texture.h"
+
+#include <deque>
+
+class DescriptorHeap;
+class UploadRing;
+
+struct TextureStreamingStats {
+    size_t textures = 0;         // registered and still alive
+    size_t fullyResident = 0;    // with mip 0 on the GPU
+    uint64_t residentBytes = 0;  // mips on the GPU across registered textures
+    uint64_t requestedBytes = 0; // what the latest requests would take without a budget
+    uint64_t budgetBytes = 0;
+    size_t upgrades = 0;         // totals since start
+    size_t evictions = 0;
+    uint64_t uploadedBytes = 0;
+};
+
+// Mip streaming for cooked textures. The cache creates them with only the
+// levels of 64 texels and under resident; after that draws request the mip
+// they need each frame (Model::requestTextureMips) and update() moves every
+// texture towards its request while keeping the resident total under the
+// budget. Room is made by trimming textures that hold more than they were
+// asked for, then by dropping the least recently requested ones back to their
+// base mips.
+//
+// Changes go through the upload ring, submitted on the render queue ahead of
+// the frame. Old resources and SRV slots are held until the frames sampling
+// them have finished.
+class TextureStreamer {
+    public:
+        TextureStreamer(
+            ComPtr<ID3D12Device2> device,
+            UploadRing* uploads,
+            DescriptorHeap* srvHeap,
+            uint64_t budgetBytes
+        );
+
+        // Waits for and releases whatever is still retired
+        ~TextureStreamer();
+
+        // The mip a texture is first created with and never evicted past
+        static UINT baseMip(const TextureFileLayout& layout);
+
+        // Only a weak reference is kept, textures go away with their last user
+        void add(const std::shared_ptr<Texture>& texture);
+
+        // Once per frame, after this frame's mip requests and before recording it
+        void update();
+
+        void setBudget(uint64_t bytes) {
+            stats.budgetBytes = bytes;
+        }
+
+        const TextureStreamingStats& getStats() const {
+            return stats;
+        }
+
+        void logStats() const;
+
+    private:
+        struct Entry {
+            std::weak_ptr<Texture> texture;
+            UINT baseMip = 0;
+            UINT wantedMip = 0;
+            uint64_t lastRequested = 0; // frame of the last request
+        };
+
+        struct RetiredBatch {
+            UINT64 fenceValue = 0;
+            std::vector<Texture::Retired> textures;
+        };
+
+        // Records the move into the ring's open batch
+        void setResidentMip(Texture& texture, UINT topMip);
+
+        void releaseRetired(bool wait);
+
+    private:
+        ComPtr<ID3D12Device2> device;
+        UploadRing* uploads = nullptr;
+        DescriptorHeap* srvHeap = nullptr;
+
+        std::vector<Entry> entries;
+        std::deque<RetiredBatch> retired;
+
+        // This update's changes, retired once the ring submits them
+        std::vector<Texture::Retired> pendingRetired;
+
+        uint64_t frame = 0;
+        TextureStreamingStats stats;
+};
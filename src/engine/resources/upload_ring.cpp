@@ -0,0 +1,156 @@
+#include "upload_ring.h"
+#include "engine/command_queue.h"
+
+namespace {
+    constexpr double MEGABYTE = 1024.0 * 1024.0;
+}
+
+UploadRing::UploadRing(
+    ComPtr<ID3D12Device2> device,
+    CommandQueue* queue,
+    UINT64 capacity,
+    UINT64 batchBytes
+) :
+    device(device),
+    queue(queue),
+    ring(capacity),
+    batchBytes(batchBytes)
+{
+    CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+
+    HRESULT hr = device->CreateCommittedResource(
+        &uploadHeapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&buffer)
+    );
+    if (FAILED(hr)) throw std::runtime_error("Failed to create upload ring.");
+
+    // Upload heaps can stay mapped for their whole lifetime
+    CD3DX12_RANGE readRange(0, 0);
+    throwFailed(buffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+}
+
+UploadRing::~UploadRing() {
+    flush();
+    buffer->Unmap(0, nullptr);
+}
+
+UploadAllocation UploadRing::allocate(UINT64 size, UINT64 alignment) {
+    release();
+
+    // Keep batches bounded, the open one goes out before it grows past the limit
+    if (recordedBytes > 0 && recordedBytes + size > batchBytes)
+        submit();
+
+    UploadAllocation allocation;
+    if (size > ring.getCapacity()) {
+        ComPtr<ID3D12Resource> oversized;
+        CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+        auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+
+        HRESULT hr = device->CreateCommittedResource(
+            &uploadHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&oversized)
+        );
+        if (FAILED(hr)) throw std::runtime_error("Failed to create upload buffer.");
+
+        CD3DX12_RANGE readRange(0, 0);
+        throwFailed(oversized->Map(0, &readRange, reinterpret_cast<void**>(&allocation.cpu)));
+        allocation.buffer = oversized.Get();
+
+        pendingBuffers.push_back(std::move(oversized));
+        recordedBytes += size;
+        stats.uploadedBytes += size;
+        stats.oversized++;
+        return allocation;
+    }
+
+    UINT64 offset = ring.allocate(size, alignment);
+    while (offset == RingAllocator::INVALID_OFFSET) {
+        // Our own batch holds the space: send it, then wait for the oldest
+        if (ring.getPending() > 0) {
+            submit();
+        } else {
+            queue->fenceWait(ring.getOldestFence());
+            stats.stalls++;
+        }
+
+        release();
+        offset = ring.allocate(size, alignment);
+    }
+
+    recordedBytes += size;
+    stats.uploadedBytes += size;
+
+    allocation.cpu = mapped + offset;
+    allocation.buffer = buffer.Get();
+    allocation.offset = offset;
+    return allocation;
+}
+
+ComPtr<ID3D12GraphicsCommandList2> UploadRing::getCommandList() {
+    if (!cmdList)
+        cmdList = queue->getCommandList();
+    return cmdList;
+}
+
+void UploadRing::copyToBuffer(ID3D12Resource* dst, UINT64 dstOffset, const void* data, UINT64 size) {
+    if (size == 0)
+        return;
+
+    UploadAllocation upload = allocate(size, sizeof(uint32_t));
+    memcpy(upload.cpu, data, size);
+
+    getCommandList()->CopyBufferRegion(dst, dstOffset, upload.buffer, upload.offset, size);
+}
+
+UINT64 UploadRing::submit() {
+    if (!cmdList && recordedBytes == 0)
+        return 0;
+
+    UINT64 fenceValue = queue->executeCommandList(getCommandList());
+    cmdList.Reset();
+
+    ring.submit(fenceValue);
+    for (ComPtr<ID3D12Resource>& oversized : pendingBuffers) {
+        oversized->Unmap(0, nullptr);
+        retiredBuffers.push_back({ fenceValue, std::move(oversized) });
+    }
+    pendingBuffers.clear();
+
+    LOG_INFO(L"UploadRing -> Submitted %.1f MB (fence=%llu), %.1f / %.1f MB in flight",
+        recordedBytes / MEGABYTE, fenceValue, ring.getUsed() / MEGABYTE, ring.getCapacity() / MEGABYTE);
+
+    recordedBytes = 0;
+    lastFence = fenceValue;
+    stats.submissions++;
+    return fenceValue;
+}
+
+void UploadRing::flush() {
+    submit();
+    queue->flush();
+    release();
+}
+
+void UploadRing::release() {
+    const UINT64 completed = queue->getFence()->GetCompletedValue();
+    ring.release(completed);
+
+    while (!retiredBuffers.empty() && retiredBuffers.front().fenceValue <= completed) {
+        retiredBuffers.pop_front();
+    }
+}
+
+void UploadRing::logStats() const {
+    LOG_INFO(L"UploadRing -> %zu submissions, %.1f MB uploaded, %zu stalls, %zu oversized allocations",
+        stats.submissions, stats.uploadedBytes / MEGABYTE, stats.stalls, stats.oversized);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "utils/pch.h"
+#include "utils/ring_allocator.h"
+
+#include <deque>
+
+class CommandQueue;
+
+// Where an allocation landed: copy from buffer at offset, write through cpu
+struct UploadAllocation {
+    uint8_t* cpu = nullptr;
+    ID3D12Resource* buffer = nullptr;
+    UINT64 offset = 0;
+};
+
+struct UploadRingStats {
+    size_t submissions = 0;
+    size_t stalls = 0;         // allocations that had to wait for the GPU
+    size_t oversized = 0;      // allocations larger than the ring
+    uint64_t uploadedBytes = 0;
+};
+
+// Staging memory for uploads into default heaps: one persistently mapped
+// upload buffer used as a ring (RingAllocator). Copies are recorded into the
+// ring's open command list and submitted in batches of about batchBytes, so a
+// huge import goes out in pieces instead of one list. A batch's space comes
+// back once its fence has passed; allocations larger than the whole ring get a
+// buffer of their own that is dropped the same way.
+//
+// Textures go through a ring on the direct queue. Geometry uses one on the
+// copy queue, whose readers wait on getLastFence() (CommandQueue::waitForQueue).
+//
+// allocate() may submit the open batch, so fetch getCommandList() after it
+// instead of holding on to the list across allocations.
+class UploadRing {
+    public:
+        UploadRing(
+            ComPtr<ID3D12Device2> device,
+            CommandQueue* queue,
+            UINT64 capacity,
+            UINT64 batchBytes
+        );
+
+        // Submits what is recorded and waits for all of it
+        ~UploadRing();
+
+        // alignment is a power of two, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT for textures
+        UploadAllocation allocate(UINT64 size, UINT64 alignment);
+
+        // The open batch, started on first use
+        ComPtr<ID3D12GraphicsCommandList2> getCommandList();
+
+        // Stages size bytes and records a copy to dst at dstOffset. Buffers are
+        // created in COMMON and promoted by the copy, on any queue type.
+        void copyToBuffer(ID3D12Resource* dst, UINT64 dstOffset, const void* data, UINT64 size);
+
+        // Executes the open batch, returns its fence or 0 when nothing was recorded
+        UINT64 submit();
+
+        // Fence of the latest submission; everything allocated before it is done once it passes
+        UINT64 getLastFence() const {
+            return lastFence;
+        }
+
+        // Submits and waits for every batch
+        void flush();
+
+        CommandQueue* getQueue() const {
+            return queue;
+        }
+
+        const UploadRingStats& getStats() const {
+            return stats;
+        }
+
+        void logStats() const;
+
+    private:
+        // Gives back the space of batches the GPU has finished
+        void release();
+
+    private:
+        struct RetiredBuffer {
+            UINT64 fenceValue = 0;
+            ComPtr<ID3D12Resource> buffer;
+        };
+
+        ComPtr<ID3D12Device2> device;
+        CommandQueue* queue = nullptr;
+
+        ComPtr<ID3D12Resource> buffer;
+        uint8_t* mapped = nullptr;
+        RingAllocator ring;
+        UINT64 batchBytes = 0;
+
+        ComPtr<ID3D12GraphicsCommandList2> cmdList;
+        UINT64 recordedBytes = 0; // allocated into the open batch
+        UINT64 lastFence = 0;
+
+        // Oversized allocations, the open batch's and those still in flight
+        std::vector<ComPtr<ID3D12Resource>> pendingBuffers;
+        std::deque<RetiredBuffer> retiredBuffers;
+
+        UploadRingStats stats;
+};
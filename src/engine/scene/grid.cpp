@@ -6,11 +6,13 @@
 #include "engine/mesh.h"
 #include "engine/pipeline.h"
 #include "engine/material.h"
-#include "engine/resources/constant.h"
+#include "engine/resources/constant_allocator.h"
+#include "engine/geometry/vertex_format.h"
 
 Grid::Grid(
     ComPtr<ID3D12Device2> device,
     CommandQueue* commandQueue,
+    GeometryPool* geometry,
     DescriptorHeap* srvHeap
 ) : device(device)
 {
@@ -25,19 +27,14 @@ Grid::Grid(
     std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
 
     auto mat = std::make_shared<Material>();
-    mesh = std::make_unique<Mesh>(device, vertices, indices, mat);
+    mesh = std::make_unique<Mesh>(device, geometry, vertices, indices, mat);
 
     // Load shaders
     Shader vs(L"assets/shaders/grid_vs.cso");
     Shader ps(L"assets/shaders/grid_ps.cso");
 
     // Input layout
-    std::vector<D3D12_INPUT_ELEMENT_DESC> layout = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TANGENT",  0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-    };
+    std::vector<D3D12_INPUT_ELEMENT_DESC> layout = getInputLayout(VertexFormat::Full);
 
     // Root signature — MVP (b0) and GridParams (b1)
     CD3DX12_ROOT_PARAMETER mvpParam;
@@ -66,35 +63,27 @@ Grid::Grid(
 
     // Disable culling to make it visible from below
     pipeline->getRasterizerDesc().CullMode = D3D12_CULL_MODE_NONE;
-
-    // Constant buffers
-    mvpBuffer = std::make_unique<ConstantBuffer>(device, static_cast<UINT>(sizeof(MVPConstantStruct)));
-    gridParamsBuffer = std::make_unique<ConstantBuffer>(device, static_cast<UINT>(sizeof(GridParams)));
 }
 
 void Grid::updateMVP(const XMMATRIX& viewProj)
 {
-    MVPConstantStruct mvp{};
     mvp.model = XMMatrixTranspose(XMMatrixIdentity());
     mvp.viewProj = XMMatrixTranspose(viewProj);
-    mvpBuffer->update(&mvp, sizeof(MVPConstantStruct));
 }
 
 void Grid::updateGridParams(const XMFLOAT3& camPos, float fadeDistance)
 {
-    GridParams params{};
     params.cameraPos = camPos;
     params.gridFadeDistance = fadeDistance;
-    gridParamsBuffer->update(&params, sizeof(GridParams));
 }
 
-void Grid::draw(ID3D12GraphicsCommandList* cmdList)
+void Grid::draw(ID3D12GraphicsCommandList* cmdList, ConstantAllocator& constants)
 {
     cmdList->SetPipelineState(pipeline->getPipelineState().Get());
     cmdList->SetGraphicsRootSignature(pipeline->getRootSignature().Get());
 
-    cmdList->SetGraphicsRootConstantBufferView(0, mvpBuffer->getGPUAddress());
-    cmdList->SetGraphicsRootConstantBufferView(1, gridParamsBuffer->getGPUAddress());
+    cmdList->SetGraphicsRootConstantBufferView(0, constants.push(mvp));
+    cmdList->SetGraphicsRootConstantBufferView(1, constants.push(params));
 
-    mesh->draw(cmdList, 0);
+    mesh->draw(cmdList, MaterialSlots{});
 }
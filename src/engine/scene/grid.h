@@ -4,9 +4,10 @@
 
 class CommandQueue;
 class DescriptorHeap;
+class GeometryPool;
 class Mesh;
 class Pipeline;
-class ConstantBuffer;
+class ConstantAllocator;
 
 struct GridParams
 {
@@ -19,12 +20,14 @@ class Grid {
         Grid(
             ComPtr<ID3D12Device2> device,
             CommandQueue* commandQueue,
+            GeometryPool* geometry,
             DescriptorHeap* srvHeap
         );
 
         ~Grid() = default;
 
-        void draw(ID3D12GraphicsCommandList* cmdList);
+        // Constants go into this frame's region of constants
+        void draw(ID3D12GraphicsCommandList* cmdList, ConstantAllocator& constants);
 
         void updateMVP(const XMMATRIX& viewProj);
 
@@ -34,6 +37,6 @@ class Grid {
         ComPtr<ID3D12Device2> device;
         std::unique_ptr<Mesh> mesh;
         std::unique_ptr<Pipeline> pipeline;
-        std::unique_ptr<ConstantBuffer> mvpBuffer;
-        std::unique_ptr<ConstantBuffer> gridParamsBuffer;
+        MVPConstantStruct mvp {};
+        GridParams params {};
 };
\ No newline at end of file
@@ -1,13 +1,6 @@
 #include "lighting.h"
 
-Lighting::Lighting(
-    ComPtr<ID3D12Device2> device
-) {
-    lightCBV = std::make_unique<ConstantBuffer>(
-        device,
-        static_cast<UINT>(sizeof(LightBufferData))
-    );
-
+Lighting::Lighting() {
     lightData.numLights = 0;
     lightData.globalAmbient = XMFLOAT4(0.1f, 0.1f, 0.1f, 1.0f);
     lightData.eyePosition = XMFLOAT4(0, 0, -5, 1); // arbitrary until updated
@@ -45,8 +38,8 @@ void Lighting::setLight(
     }
 }
 
-void Lighting::updateGPU() {
-    lightCBV->update(&lightData, sizeof(LightBufferData));
+void Lighting::updateGPU(ConstantAllocator& constants) {
+    gpuAddress = constants.push(lightData);
     LOG_INFO(L"Lighting -> Updated GPU Successfully.");
 }
 
@@ -1,13 +1,11 @@
 #pragma once
 
 #include "utils/pch.h"
-#include "engine/resources/constant.h"
+#include "engine/resources/constant_allocator.h"
 
 class Lighting {
 public:
-    Lighting(
-        ComPtr<ID3D12Device2> device
-    );
+    Lighting();
 
     void setLight(
         UINT index,
@@ -21,12 +19,12 @@ public:
         float intensity
     );
 
-    // Update GPU buffer
-    void updateGPU();
+    // Copies the light data into this frame's constants
+    void updateGPU(ConstantAllocator& constants);
 
-    // Get GPU handle
-    ConstantBuffer* getCBV() { 
-        return lightCBV.get(); 
+    // Where the last updateGPU() put it, valid for that frame
+    D3D12_GPU_VIRTUAL_ADDRESS getGPUAddress() const { 
+        return gpuAddress; 
     }
 
     void setEyePosition(const XMFLOAT3& eyePos) {
@@ -43,5 +41,5 @@ public:
 
 private:
     LightBufferData lightData {};
-    std::unique_ptr<ConstantBuffer> lightCBV;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
 };
\ No newline at end of file
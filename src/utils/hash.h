@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit hash that consumes 8 bytes per step. Not cryptographic -> used to key
+// cooked caches and to dedupe content, so speed on large files matters more.
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0x9E3779B97F4A7C15ull) {
+    constexpr uint64_t prime = 0x100000001B3ull;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (size * prime);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        word *= 0xFF51AFD7ED558CCDull;
+        word ^= word >> 32;
+        h = (h ^ word) * prime;
+        h ^= h >> 29;
+    }
+
+    for (; i < size; ++i) {
+        h = (h ^ bytes[i]) * prime;
+    }
+
+    // final avalanche
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t hashCombine(uint64_t a, uint64_t b) {
+    return a ^ (b + 0x9E3779B97F4A7C15ull + (a << 6) + (a >> 2));
+}
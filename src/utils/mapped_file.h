@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+// Windows uses a file mapping object, everything else mmap.
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // Returns false if the file is missing or can't be mapped
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const {
+            return opened;
+        }
+
+        const uint8_t* getData() const {
+            return data;
+        }
+
+        size_t getSize() const {
+            return size;
+        }
+
+    private:
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        bool opened = false;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fd = -1;
+#endif
+};
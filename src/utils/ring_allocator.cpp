@@ -0,0 +1,51 @@
+#include "ring_allocator.h"
+
+RingAllocator::RingAllocator(uint64_t capacity) :
+    capacity(capacity)
+{
+}
+
+uint64_t RingAllocator::allocate(uint64_t size, uint64_t alignment) {
+    if (size == 0 || size > capacity)
+        return INVALID_OFFSET;
+
+    uint64_t offset = (head + alignment - 1) & ~(alignment - 1);
+    uint64_t padding = offset - head;
+
+    // Doesn't fit before the end: waste the rest and start again at 0
+    if (offset + size > capacity) {
+        offset = 0;
+        padding = capacity - head;
+    }
+
+    // The free space runs from head around to the oldest allocation in one piece
+    if (used + padding + size > capacity)
+        return INVALID_OFFSET;
+
+    head = offset + size;
+    if (head == capacity)
+        head = 0;
+
+    used += padding + size;
+    pending += padding + size;
+    return offset;
+}
+
+void RingAllocator::submit(uint64_t fenceValue) {
+    if (pending == 0)
+        return;
+
+    submissions.push_back({ fenceValue, pending });
+    pending = 0;
+}
+
+void RingAllocator::release(uint64_t completedValue) {
+    while (!submissions.empty() && submissions.front().fenceValue <= completedValue) {
+        used -= submissions.front().bytes;
+        submissions.pop_front();
+    }
+
+    // Nothing in flight, start over so the next allocations don't wrap early
+    if (used == 0)
+        head = 0;
+}
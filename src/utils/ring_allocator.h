@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Offsets into a fixed-size ring, handed out in order and given back in order
+// once the fence value they were submitted under has completed. Knows nothing
+// about the GPU: fences are plain numbers, so wrap-around and retirement can be
+// driven and checked without a device.
+class RingAllocator {
+    public:
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        explicit RingAllocator(uint64_t capacity);
+
+        // size bytes at an offset aligned to alignment (a power of two). An
+        // allocation never straddles the end, the tail is skipped instead.
+        // INVALID_OFFSET when it doesn't fit until older submissions are released.
+        uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+        // Everything allocated since the last submit belongs to fenceValue.
+        // Fence values must not decrease.
+        void submit(uint64_t fenceValue);
+
+        // Gives back every submission whose fence is <= completedValue
+        void release(uint64_t completedValue);
+
+        // Fence to wait for before the oldest submission can be released, 0 if none
+        uint64_t getOldestFence() const {
+            return submissions.empty() ? 0 : submissions.front().fenceValue;
+        }
+
+        uint64_t getCapacity() const {
+            return capacity;
+        }
+
+        // Bytes in use, padding and skipped tails included
+        uint64_t getUsed() const {
+            return used;
+        }
+
+        // Allocated since the last submit
+        uint64_t getPending() const {
+            return pending;
+        }
+
+    private:
+        struct Submission {
+            uint64_t fenceValue = 0;
+            uint64_t bytes = 0;
+        };
+
+        uint64_t capacity = 0;
+        uint64_t head = 0;    // next free byte
+        uint64_t used = 0;    // from the oldest live allocation up to head
+        uint64_t pending = 0;
+
+        std::deque<Submission> submissions;
+};
@@ -18,6 +18,7 @@ struct WindowConfig {
     bool useWarp;
     bool fullscreen = false;
     bool resizable = true;
+    uint32_t framesInFlight = 2; // 1 (CPU and GPU in lockstep) to FRAMEBUFFERCOUNT
 };
 
 struct alignas(16) VertexStruct {
@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    threadCount = std::max<size_t>(1, threadCount);
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::defaultThreadCount() {
+    // leave one core for the main/render thread
+    size_t cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 1;
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wakeup.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+            if (stopping && jobs.empty())
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0)
+        return;
+
+    if (count == 1) {
+        fn(0);
+        return;
+    }
+
+    // Shared with helper jobs, which may only start after we've returned
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        size_t count = 0;
+        const std::function<void(size_t)>* fn = nullptr;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+
+        void run() {
+            for (;;) {
+                size_t i = next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= count)
+                    return;
+
+                try {
+                    (*fn)(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                }
+
+                if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = &fn;
+
+    const size_t helpers = std::min(workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        enqueue([state]() { state->run(); });
+    }
+
+    state->run();
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&]() { return state->done.load(std::memory_order_acquire) == count; });
+    }
+
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
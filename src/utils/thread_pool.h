@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads fed from one FIFO queue.
+// Pure C++ so the offline tools can share it with the engine.
+class ThreadPool {
+    public:
+        explicit ThreadPool(size_t threadCount = defaultThreadCount());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Process-wide pool used by the import/cook pipelines
+        static ThreadPool& instance();
+
+        static size_t defaultThreadCount();
+
+        size_t getThreadCount() const {
+            return workers.size();
+        }
+
+        // Queue a job; the future carries its result or exception
+        template<typename F>
+        auto submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+            using Result = std::invoke_result_t<std::decay_t<F>>;
+
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+            std::future<Result> future = task->get_future();
+            enqueue([task]() { (*task)(); });
+            return future;
+        }
+
+        // Runs fn(i) for i in [0, count) across the workers and blocks until all are done.
+        // The calling thread takes items too, so nesting inside a pool job can't deadlock.
+        // Rethrows the first exception after every claimed item has finished.
+        void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    private:
+        void enqueue(std::function<void()> job);
+        void workerLoop();
+
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        bool stopping = false;
+};
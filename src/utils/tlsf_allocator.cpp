@@ -0,0 +1,260 @@
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+    uint32_t highestBit(uint64_t value) {
+        return 63 - static_cast<uint32_t>(std::countl_zero(value));
+    }
+
+    uint32_t lowestBit(uint64_t value) {
+        return static_cast<uint32_t>(std::countr_zero(value));
+    }
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+TlsfAllocator::TlsfAllocator(uint64_t size) :
+    size(size)
+{
+    for (auto& lists : freeLists) {
+        std::fill(std::begin(lists), std::end(lists), INVALID_BLOCK);
+    }
+
+    if (size == 0)
+        return;
+
+    uint32_t whole = newBlock();
+    blocks[whole].size = size;
+    insertFree(whole);
+}
+
+TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t bytes, uint64_t alignment) {
+    Allocation allocation;
+    if (bytes == 0 || bytes > size)
+        return allocation;
+
+    // The good-fit class first, its head is often aligned already. Otherwise
+    // look for a block that fits even with the worst-case padding in front.
+    uint32_t block = findFit(bytes);
+    if (block != INVALID_BLOCK && alignUp(blocks[block].offset, alignment) + bytes > blocks[block].offset + blocks[block].size)
+        block = alignment > 1 && bytes + alignment - 1 <= size ? findFit(bytes + alignment - 1) : INVALID_BLOCK;
+
+    if (block == INVALID_BLOCK)
+        return allocation;
+
+    removeFree(block);
+
+    // Padding in front becomes a free block of its own. Free blocks never
+    // border each other, so the one before is in use and nothing merges.
+    const uint64_t aligned = alignUp(blocks[block].offset, alignment);
+    if (aligned > blocks[block].offset) {
+        uint32_t front = newBlock();
+        Block& padding = blocks[front];
+        Block& current = blocks[block];
+
+        padding.offset = current.offset;
+        padding.size = aligned - current.offset;
+        padding.prevPhysical = current.prevPhysical;
+        padding.nextPhysical = block;
+        if (padding.prevPhysical != INVALID_BLOCK)
+            blocks[padding.prevPhysical].nextPhysical = front;
+
+        current.prevPhysical = front;
+        current.offset = aligned;
+        current.size -= padding.size;
+        insertFree(front);
+    }
+
+    // Same for the rest behind
+    if (blocks[block].size > bytes) {
+        uint32_t back = newBlock();
+        Block& rest = blocks[back];
+        Block& current = blocks[block];
+
+        rest.offset = current.offset + bytes;
+        rest.size = current.size - bytes;
+        rest.prevPhysical = block;
+        rest.nextPhysical = current.nextPhysical;
+        if (rest.nextPhysical != INVALID_BLOCK)
+            blocks[rest.nextPhysical].prevPhysical = back;
+
+        current.nextPhysical = back;
+        current.size = bytes;
+        insertFree(back);
+    }
+
+    used += bytes;
+    allocationCount++;
+
+    allocation.offset = blocks[block].offset;
+    allocation.block = block;
+    return allocation;
+}
+
+void TlsfAllocator::free(uint32_t block) {
+    if (block >= blocks.size() || blocks[block].free || blocks[block].size == 0)
+        return;
+
+    used -= blocks[block].size;
+    allocationCount--;
+
+    // Merge into a free block before
+    const uint32_t prev = blocks[block].prevPhysical;
+    if (prev != INVALID_BLOCK && blocks[prev].free) {
+        removeFree(prev);
+        blocks[prev].size += blocks[block].size;
+        blocks[prev].nextPhysical = blocks[block].nextPhysical;
+        if (blocks[prev].nextPhysical != INVALID_BLOCK)
+            blocks[blocks[prev].nextPhysical].prevPhysical = prev;
+
+        releaseBlock(block);
+        block = prev;
+    }
+
+    // And swallow a free block after
+    const uint32_t next = blocks[block].nextPhysical;
+    if (next != INVALID_BLOCK && blocks[next].free) {
+        removeFree(next);
+        blocks[block].size += blocks[next].size;
+        blocks[block].nextPhysical = blocks[next].nextPhysical;
+        if (blocks[block].nextPhysical != INVALID_BLOCK)
+            blocks[blocks[block].nextPhysical].prevPhysical = block;
+
+        releaseBlock(next);
+    }
+
+    insertFree(block);
+}
+
+uint64_t TlsfAllocator::getLargestFree() const {
+    if (flBitmap == 0)
+        return 0;
+
+    // Blocks in the top class differ in size, so that one list gets walked
+    const uint32_t fl = highestBit(flBitmap);
+    const uint32_t sl = highestBit(slBitmap[fl]);
+
+    uint64_t largest = 0;
+    for (uint32_t block = freeLists[fl][sl]; block != INVALID_BLOCK; block = blocks[block].nextFree) {
+        largest = std::max(largest, blocks[block].size);
+    }
+    return largest;
+}
+
+uint64_t TlsfAllocator::getFitSize(uint64_t bytes, uint64_t alignment) {
+    uint64_t fit = bytes + alignment - 1;
+    if (fit < SL_COUNT)
+        return fit;
+
+    fit += (1ull << (highestBit(fit) - SL_BITS)) - 1;
+    const uint32_t shift = highestBit(fit) - SL_BITS;
+    return fit >> shift << shift;
+}
+
+void TlsfAllocator::mapping(uint64_t bytes, uint32_t& fl, uint32_t& sl) {
+    if (bytes < SL_COUNT) {
+        fl = 0;
+        sl = static_cast<uint32_t>(bytes);
+        return;
+    }
+
+    const uint32_t log = highestBit(bytes);
+    fl = log - SL_BITS + 1;
+    sl = static_cast<uint32_t>(bytes >> (log - SL_BITS)) - SL_COUNT;
+}
+
+uint32_t TlsfAllocator::findFree(uint32_t fl, uint32_t sl) const {
+    uint32_t slMap = slBitmap[fl] & (~0u << sl);
+    if (slMap == 0) {
+        const uint64_t flMap = fl + 1 < 64 ? flBitmap & (~0ull << (fl + 1)) : 0;
+        if (flMap == 0)
+            return INVALID_BLOCK;
+
+        fl = lowestBit(flMap);
+        slMap = slBitmap[fl];
+    }
+    return freeLists[fl][lowestBit(slMap)];
+}
+
+uint32_t TlsfAllocator::findFit(uint64_t bytes) const {
+    // Round up to the next class boundary so any block found is large enough
+    if (bytes >= SL_COUNT) {
+        const uint64_t round = (1ull << (highestBit(bytes) - SL_BITS)) - 1;
+        if (bytes > UINT64_MAX - round)
+            return INVALID_BLOCK;
+        bytes += round;
+    }
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(bytes, fl, sl);
+    if (fl >= FL_COUNT)
+        return INVALID_BLOCK;
+
+    return findFree(fl, sl);
+}
+
+void TlsfAllocator::insertFree(uint32_t block) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(blocks[block].size, fl, sl);
+
+    Block& entry = blocks[block];
+    entry.free = true;
+    entry.prevFree = INVALID_BLOCK;
+    entry.nextFree = freeLists[fl][sl];
+    if (entry.nextFree != INVALID_BLOCK)
+        blocks[entry.nextFree].prevFree = block;
+
+    freeLists[fl][sl] = block;
+    flBitmap |= 1ull << fl;
+    slBitmap[fl] |= 1u << sl;
+    freeBlockCount++;
+}
+
+void TlsfAllocator::removeFree(uint32_t block) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(blocks[block].size, fl, sl);
+
+    Block& entry = blocks[block];
+    if (entry.prevFree != INVALID_BLOCK)
+        blocks[entry.prevFree].nextFree = entry.nextFree;
+    else
+        freeLists[fl][sl] = entry.nextFree;
+
+    if (entry.nextFree != INVALID_BLOCK)
+        blocks[entry.nextFree].prevFree = entry.prevFree;
+
+    if (freeLists[fl][sl] == INVALID_BLOCK) {
+        slBitmap[fl] &= ~(1u << sl);
+        if (slBitmap[fl] == 0)
+            flBitmap &= ~(1ull << fl);
+    }
+
+    entry.free = false;
+    entry.prevFree = INVALID_BLOCK;
+    entry.nextFree = INVALID_BLOCK;
+    freeBlockCount--;
+}
+
+uint32_t TlsfAllocator::newBlock() {
+    if (!unusedBlocks.empty()) {
+        uint32_t block = unusedBlocks.back();
+        unusedBlocks.pop_back();
+        blocks[block] = Block{};
+        return block;
+    }
+
+    blocks.emplace_back();
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void TlsfAllocator::releaseBlock(uint32_t block) {
+    blocks[block] = Block{};
+    unusedBlocks.push_back(block);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit (TLSF) allocator over an abstract range of bytes,
+// used to carve placed resources out of GPU heaps. Block bookkeeping lives on
+// the side rather than in the managed memory, so it works for memory the CPU
+// never sees. allocate() and free() are constant time: a couple of bitmap
+// scans and list splices, with free neighbours merged straight away.
+//
+// Size classes: 16 linear ones below 16 bytes, then every power of two split
+// into 16. A request only looks at classes whose every block is big enough
+// (good fit), so worst-case waste per class is 1/16th.
+class TlsfAllocator {
+    public:
+        static constexpr uint32_t INVALID_BLOCK = UINT32_MAX;
+
+        struct Allocation {
+            uint64_t offset = 0;
+            uint32_t block = INVALID_BLOCK; // handle for free()
+        };
+
+        explicit TlsfAllocator(uint64_t size);
+
+        // alignment is a power of two. block is INVALID_BLOCK when nothing fits.
+        Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+        void free(uint32_t block);
+
+        uint64_t getSize() const {
+            return size;
+        }
+
+        // Bytes handed out, alignment padding goes back to the free blocks
+        uint64_t getUsed() const {
+            return used;
+        }
+
+        size_t getAllocationCount() const {
+            return allocationCount;
+        }
+
+        bool empty() const {
+            return allocationCount == 0;
+        }
+
+        size_t getFreeBlockCount() const {
+            return freeBlockCount;
+        }
+
+        // Largest allocation without alignment that would succeed right now
+        uint64_t getLargestFree() const;
+
+        // Smallest free block allocate(bytes, alignment) always succeeds in: the
+        // worst-case padding added, rounded up to the class findFit() starts at.
+        // Size a heap with this to be sure of one allocation.
+        static uint64_t getFitSize(uint64_t bytes, uint64_t alignment = 1);
+
+    private:
+        static constexpr uint32_t SL_BITS = 4;
+        static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+        static constexpr uint32_t FL_COUNT = 64 - SL_BITS + 1;
+
+        struct Block {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhysical = INVALID_BLOCK;
+            uint32_t nextPhysical = INVALID_BLOCK;
+            uint32_t prevFree = INVALID_BLOCK;
+            uint32_t nextFree = INVALID_BLOCK;
+            bool free = false;
+        };
+
+        static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+        // First free block in a class at least as large as (fl, sl)
+        uint32_t findFree(uint32_t fl, uint32_t sl) const;
+
+        // Smallest class whose blocks all hold size bytes, INVALID_BLOCK if none is free
+        uint32_t findFit(uint64_t size) const;
+
+        void insertFree(uint32_t block);
+        void removeFree(uint32_t block);
+
+        uint32_t newBlock();
+        void releaseBlock(uint32_t block);
+
+    private:
+        uint64_t size = 0;
+        uint64_t used = 0;
+        size_t allocationCount = 0;
+        size_t freeBlockCount = 0;
+
+        std::vector<Block> blocks;
+        std::vector<uint32_t> unusedBlocks;
+
+        uint64_t flBitmap = 0;
+        uint32_t slBitmap[FL_COUNT] = {};
+        uint32_t freeLists[FL_COUNT][SL_COUNT];
+};
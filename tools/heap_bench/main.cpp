@@ -0,0 +1,180 @@
+// Exercises the TLSF core behind GpuAllocator with resource-like sizes and
+// prints allocate/free throughput and how fragmented the heap ends up.
+// CPU only, no device: after every fill the live offsets are checked for
+// overlap and alignment, so it doubles as a sanity check of the allocator.
+//
+// Each round fills the heap up to --fill, then frees and replaces a random
+// half of what is live, like models being swapped in and out.
+//
+// usage: heap_bench [--heap <MB>] [--rounds <n>] [--fill <0..1>] [--seed <n>]
+
+#include "utils/tlsf_allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // D3D12 placement alignments: buffers and textures, small textures
+    constexpr uint64_t DEFAULT_ALIGNMENT = 64 * 1024;
+    constexpr uint64_t SMALL_ALIGNMENT = 4 * 1024;
+
+    struct Live {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint64_t alignment = 1;
+        uint32_t block = TlsfAllocator::INVALID_BLOCK;
+    };
+
+    struct Request {
+        uint64_t size = 0;
+        uint64_t alignment = 1;
+    };
+
+    // Mostly small vertex / index buffers, some textures from 4 KB tiles to 16 MB
+    Request randomRequest(std::mt19937_64& rng) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const double pick = unit(rng);
+
+        Request request;
+        if (pick < 0.6) {
+            request.size = 256 + rng() % (256 * 1024);
+            request.alignment = DEFAULT_ALIGNMENT;
+        } else if (pick < 0.85) {
+            request.size = SMALL_ALIGNMENT * (1 + rng() % 16);
+            request.alignment = SMALL_ALIGNMENT;
+        } else {
+            const uint64_t side = 64ull << (rng() % 7);
+            request.size = side * side * 4 * 4 / 3;
+            request.alignment = DEFAULT_ALIGNMENT;
+        }
+
+        request.size = (request.size + request.alignment - 1) & ~(request.alignment - 1);
+        return request;
+    }
+
+    double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Misaligned, out of range or overlapping allocations
+    size_t countErrors(std::vector<Live> live, uint64_t heapSize) {
+        std::sort(live.begin(), live.end(), [](const Live& a, const Live& b) {
+            return a.offset < b.offset;
+        });
+
+        size_t errors = 0;
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (live[i].offset % live[i].alignment != 0 || live[i].offset + live[i].size > heapSize)
+                errors++;
+            if (i > 0 && live[i - 1].offset + live[i - 1].size > live[i].offset)
+                errors++;
+        }
+        return errors;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t heapMb = 256;
+    int rounds = 50;
+    double fill = 0.9;
+    uint64_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--heap") {
+            heapMb = std::max<uint64_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+        } else if (arg == "--rounds") {
+            rounds = std::max(1, std::atoi(argv[i + 1]));
+        } else if (arg == "--fill") {
+            fill = std::clamp(std::atof(argv[i + 1]), 0.1, 1.0);
+        } else if (arg == "--seed") {
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            std::printf("usage: heap_bench [--heap <MB>] [--rounds <n>] [--fill <0..1>] [--seed <n>]\n");
+            return 1;
+        }
+    }
+
+    const uint64_t heapSize = heapMb << 20;
+    TlsfAllocator allocator(heapSize);
+    std::mt19937_64 rng(seed);
+    std::vector<Live> live;
+
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t failures = 0;
+    size_t errors = 0;
+    double allocMs = 0.0;
+    double freeMs = 0.0;
+    double worstFragmentation = 0.0;
+
+    std::printf("%-6s %10s %10s %12s %12s %8s %10s\n", "round", "live", "used MB", "largest MB", "free blocks", "frag", "failures");
+
+    for (int round = 0; round < rounds; ++round) {
+        // Fill up to the target, requests drawn up front so only the allocator is timed
+        std::vector<Request> requests;
+        uint64_t requested = allocator.getUsed();
+        while (requested < static_cast<uint64_t>(heapSize * fill)) {
+            requests.push_back(randomRequest(rng));
+            requested += requests.back().size;
+        }
+
+        size_t roundFailures = 0;
+        auto fillStart = std::chrono::high_resolution_clock::now();
+        for (const Request& request : requests) {
+            TlsfAllocator::Allocation allocation = allocator.allocate(request.size, request.alignment);
+            if (allocation.block == TlsfAllocator::INVALID_BLOCK) {
+                roundFailures++;
+                continue;
+            }
+
+            live.push_back({ allocation.offset, request.size, request.alignment, allocation.block });
+        }
+        allocMs += elapsedMs(fillStart);
+        allocations += requests.size() - roundFailures;
+        failures += roundFailures;
+
+        errors += countErrors(live, heapSize);
+
+        // Free space that isn't in the largest block can't take a large resource
+        const uint64_t freeBytes = heapSize - allocator.getUsed();
+        const uint64_t largest = allocator.getLargestFree();
+        const double fragmentation = freeBytes > 0 ? 1.0 - static_cast<double>(largest) / freeBytes : 0.0;
+        worstFragmentation = std::max(worstFragmentation, fragmentation);
+
+        std::printf("%-6d %10zu %10.1f %12.1f %12zu %7.1f%% %10zu\n",
+            round, live.size(), allocator.getUsed() / 1048576.0, largest / 1048576.0,
+            allocator.getFreeBlockCount(), fragmentation * 100.0, roundFailures);
+
+        // Swap out a random half
+        std::shuffle(live.begin(), live.end(), rng);
+        const size_t keep = live.size() / 2;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = keep; i < live.size(); ++i) {
+            allocator.free(live[i].block);
+        }
+        freeMs += elapsedMs(start);
+
+        frees += live.size() - keep;
+        live.resize(keep);
+    }
+
+    for (const Live& allocation : live) {
+        allocator.free(allocation.block);
+    }
+    if (allocator.getUsed() != 0 || allocator.getFreeBlockCount() != 1 || allocator.getLargestFree() != heapSize)
+        errors++;
+
+    std::printf("%zu allocations in %.2f ms (%.1f M/s), %zu frees in %.2f ms (%.1f M/s)\n",
+        allocations, allocMs, allocMs > 0.0 ? allocations / allocMs / 1000.0 : 0.0,
+        frees, freeMs, freeMs > 0.0 ? frees / freeMs / 1000.0 : 0.0);
+    std::printf("worst fragmentation %.1f%%, %zu failed allocations, %zu errors\n", worstFragmentation * 100.0, failures, errors);
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+// Times the portable JPEG/PNG/BMP decoder over every image under a folder.
+// On Windows it also decodes through WIC (WIC_FLAGS_FORCE_SRGB, as the texture
+// path did) and prints the speedup and the largest per-channel difference.
+//
+// usage: image_bench [textures dir] [--runs <n>]
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+    #include <DirectXTex.h>
+#endif
+
+#include "engine/imaging/image_decoder.h"
+#include "utils/mapped_file.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    bool isImageFile(const fs::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+    }
+
+    double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Best of runs, header parse included
+    double timePortable(const MappedFile& file, int runs, std::vector<uint8_t>& pixels, ImageInfo& info, std::string& error) {
+        double best = DBL_MAX;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            if (!readImageInfo(file.getData(), file.getSize(), info)) {
+                error = "unsupported";
+                return -1.0;
+            }
+            pixels.resize(static_cast<size_t>(info.width) * info.height * info.channels);
+            if (!decodeImage(file.getData(), file.getSize(), info, pixels.data(), static_cast<size_t>(info.width) * info.channels, &error))
+                return -1.0;
+
+            best = std::min(best, elapsedMs(start));
+        }
+        return best;
+    }
+
+#ifdef _WIN32
+    double timeWic(const MappedFile& file, int runs, DirectX::ScratchImage& image) {
+        double best = DBL_MAX;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            HRESULT hr = DirectX::LoadFromWICMemory(file.getData(), file.getSize(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+            if (FAILED(hr))
+                return -1.0;
+
+            best = std::min(best, elapsedMs(start));
+        }
+        return best;
+    }
+
+    // -1 when WIC picked a different format (16-bit, 5551) and bytes don't line up
+    int maxDifference(const std::vector<uint8_t>& pixels, const ImageInfo& info, const DirectX::ScratchImage& image) {
+        const DirectX::Image* wic = image.GetImage(0, 0, 0);
+        const DXGI_FORMAT expected = info.channels == 1 ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        if (!wic || wic->format != expected || wic->width != info.width || wic->height != info.height)
+            return -1;
+
+        const size_t rowBytes = static_cast<size_t>(info.width) * info.channels;
+        int maxDiff = 0;
+        for (uint32_t y = 0; y < info.height; ++y) {
+            const uint8_t* a = pixels.data() + y * rowBytes;
+            const uint8_t* b = wic->pixels + y * wic->rowPitch;
+            for (size_t i = 0; i < rowBytes; ++i)
+                maxDiff = std::max(maxDiff, std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+        }
+        return maxDiff;
+    }
+#endif
+}
+
+int main(int argc, char** argv) {
+    std::string root = "assets/textures";
+    int runs = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            root = arg;
+        }
+    }
+
+    std::vector<fs::path> images;
+    std::error_code ec;
+    for (const auto& entry : fs::recursive_directory_iterator(root, ec)) {
+        if (entry.is_regular_file() && isImageFile(entry.path()))
+            images.push_back(entry.path());
+    }
+    std::sort(images.begin(), images.end());
+
+    if (images.empty()) {
+        std::printf("No images found under %s\n", root.c_str());
+        return 1;
+    }
+
+#ifdef _WIN32
+    if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+        std::printf("CoInitializeEx failed\n");
+        return 1;
+    }
+    std::printf("%-40s %12s %10s %10s %8s %8s\n", "image", "size", "wic ms", "ms", "speedup", "max diff");
+#else
+    std::printf("%-40s %12s %10s %10s\n", "image", "size", "ms", "MPix/s");
+#endif
+
+    double totalPortable = 0.0;
+    double totalWic = 0.0;
+    int failed = 0;
+
+    for (const fs::path& path : images) {
+        MappedFile file;
+        if (!file.open(path.string())) {
+            std::printf("%s: can't open\n", path.string().c_str());
+            failed++;
+            continue;
+        }
+
+        std::vector<uint8_t> pixels;
+        ImageInfo info;
+        std::string error;
+        double ms = timePortable(file, runs, pixels, info, error);
+        if (ms < 0.0) {
+            std::printf("%-40s %s\n", path.filename().string().c_str(), error.c_str());
+            failed++;
+            continue;
+        }
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%ux%u", info.width, info.height);
+
+#ifdef _WIN32
+        DirectX::ScratchImage image;
+        double wicMs = timeWic(file, runs, image);
+        if (wicMs < 0.0) {
+            std::printf("%-40s %12s %10s %10.2f\n", path.filename().string().c_str(), size, "failed", ms);
+            continue;
+        }
+
+        int diff = maxDifference(pixels, info, image);
+        std::printf("%-40s %12s %10.2f %10.2f %7.2fx %8s\n",
+            path.filename().string().c_str(), size, wicMs, ms, ms > 0.0 ? wicMs / ms : 0.0,
+            diff < 0 ? "format" : std::to_string(diff).c_str());
+
+        totalWic += wicMs;
+#else
+        double mpix = static_cast<double>(info.width) * info.height / 1.0e6;
+        std::printf("%-40s %12s %10.2f %10.1f\n", path.filename().string().c_str(), size, ms, ms > 0.0 ? mpix * 1000.0 / ms : 0.0);
+#endif
+
+        totalPortable += ms;
+    }
+
+    if (totalWic > 0.0 && totalPortable > 0.0) {
+        std::printf("total: wic %.2f ms, portable %.2f ms (%.2fx)\n", totalWic, totalPortable, totalWic / totalPortable);
+    } else {
+        std::printf("total: %.2f ms\n", totalPortable);
+    }
+
+#ifdef _WIN32
+    CoUninitialize();
+#endif
+
+    return failed ? 1 : 0;
+}
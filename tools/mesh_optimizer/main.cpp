@@ -0,0 +1,180 @@
+// Runs the import pipeline (weld + vertex cache / overdraw / fetch ordering)
+// over every model under a folder and prints ACMR/ATVR per mesh.
+// --compare-obj instead times the native OBJ loader against Assimp on every .obj.
+//
+// usage: mesh_optimizer [models dir] [--threshold <overdraw threshold>] [--no-weld] [--compare-obj]
+
+#include "utils/pch.h"
+#include "engine/geometry/model_importer.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    bool isModelFile(const fs::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext == ".obj" || ext == ".fbx" || ext == ".gltf" || ext == ".glb" || ext == ".dae" || ext == ".3ds";
+    }
+
+    struct LoadTiming {
+        double ms = 0.0;
+        size_t meshes = 0;
+        size_t vertices = 0;
+        size_t triangles = 0;
+    };
+
+    // Best of a few runs, loading only: weld, optimization, meshlets and LODs are off
+    LoadTiming timeLoad(const fs::path& path, bool nativeObj) {
+        ImportSettings settings;
+        settings.nativeObj = nativeObj;
+        settings.weldVertices = false;
+        settings.optimizeMeshes = false;
+        settings.buildMeshlets = false;
+        settings.lodCount = 1;
+
+        LoadTiming timing;
+        timing.ms = DBL_MAX;
+
+        for (int run = 0; run < 3; ++run) {
+            ModelImporter importer(settings);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<MeshData> meshes = importer.import(path.string());
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            timing.ms = std::min(timing.ms, ms);
+            timing.meshes = meshes.size();
+            timing.vertices = 0;
+            timing.triangles = 0;
+            for (const MeshData& mesh : meshes) {
+                timing.vertices += mesh.vertices.size();
+                timing.triangles += mesh.indices.size() / 3;
+            }
+        }
+
+        return timing;
+    }
+
+    int compareObjLoaders(const std::vector<fs::path>& models) {
+        std::printf("%-40s %10s %10s %8s %10s %10s %10s\n", "model", "assimp ms", "native ms", "speedup", "triangles", "vertices", "vertices'");
+
+        double totalAssimp = 0.0;
+        double totalNative = 0.0;
+        int failed = 0;
+
+        for (const fs::path& path : models) {
+            if (path.extension() != ".obj" && path.extension() != ".OBJ")
+                continue;
+
+            try {
+                LoadTiming assimp = timeLoad(path, false);
+                LoadTiming native = timeLoad(path, true);
+
+                // Assimp's vertex count is unwelded, the native loader's is welded per (v, vt, vn)
+                std::printf("%-40s %10.2f %10.2f %7.2fx %10zu %10zu %10zu\n",
+                    path.filename().string().c_str(),
+                    assimp.ms, native.ms, native.ms > 0.0 ? assimp.ms / native.ms : 0.0,
+                    native.triangles, assimp.vertices, native.vertices);
+
+                if (assimp.triangles != native.triangles) {
+                    std::printf("  triangle count differs: assimp %zu, native %zu\n", assimp.triangles, native.triangles);
+                }
+
+                totalAssimp += assimp.ms;
+                totalNative += native.ms;
+            } catch (const std::exception& e) {
+                std::printf("%s: %s\n", path.string().c_str(), e.what());
+                failed++;
+            }
+        }
+
+        if (totalNative > 0.0) {
+            std::printf("total: assimp %.2f ms, native %.2f ms (%.2fx)\n", totalAssimp, totalNative, totalAssimp / totalNative);
+        }
+
+        return failed ? 1 : 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string root = "assets/models";
+    ImportSettings settings;
+    bool compareObj = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc) {
+            settings.overdrawThreshold = std::stof(argv[++i]);
+        } else if (arg == "--no-weld") {
+            settings.weldVertices = false;
+        } else if (arg == "--compare-obj") {
+            compareObj = true;
+        } else {
+            root = arg;
+        }
+    }
+
+    std::vector<fs::path> models;
+    std::error_code ec;
+    for (const auto& entry : fs::recursive_directory_iterator(root, ec)) {
+        if (entry.is_regular_file() && isModelFile(entry.path()))
+            models.push_back(entry.path());
+    }
+    std::sort(models.begin(), models.end());
+
+    if (models.empty()) {
+        std::printf("No models found under %s\n", root.c_str());
+        return 1;
+    }
+
+    if (compareObj) {
+        return compareObjLoaders(models);
+    }
+
+    std::printf("%-40s %10s %10s %8s %8s %8s %8s\n", "mesh", "triangles", "vertices", "ACMR", "ACMR'", "ATVR", "ATVR'");
+
+    size_t totalTriangles = 0;
+    size_t missesBefore = 0;
+    size_t missesAfter = 0;
+    int failed = 0;
+
+    for (const fs::path& path : models) {
+        ModelImporter importer(settings);
+        std::vector<MeshData> meshes;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        try {
+            meshes = importer.import(path.string());
+        } catch (const std::exception& e) {
+            std::printf("%s: %s\n", path.string().c_str(), e.what());
+            failed++;
+            continue;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::printf("%s (%zu meshes, %.2f ms)\n", path.string().c_str(), meshes.size(), ms);
+
+        const std::vector<MeshImportStats>& stats = importer.getStats();
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const MeshImportStats& s = stats[i];
+            std::printf("  %-38s %10zu %10zu %8.3f %8.3f %8.3f %8.3f\n",
+                meshes[i].name.c_str(),
+                s.cacheAfter.triangles, s.cacheAfter.vertices,
+                s.cacheBefore.acmr, s.cacheAfter.acmr,
+                s.cacheBefore.atvr, s.cacheAfter.atvr);
+
+            totalTriangles += s.cacheAfter.triangles;
+            missesBefore += s.cacheBefore.misses;
+            missesAfter += s.cacheAfter.misses;
+        }
+    }
+
+    if (totalTriangles) {
+        std::printf("total: %zu triangles, ACMR %.3f -> %.3f\n",
+            totalTriangles,
+            static_cast<double>(missesBefore) / totalTriangles,
+            static_cast<double>(missesAfter) / totalTriangles);
+    }
+
+    return failed ? 1 : 0;
+}
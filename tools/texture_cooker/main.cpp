@@ -0,0 +1,563 @@
+// Cooks source textures (JPEG/PNG/BMP) into block-compressed DDS files with
+// full mip chains, written next to the source as <name>.dds. Model picks the
+// .dds up in place of the source when it exists.
+//
+//   albedo          BC1 (BC3 with alpha) in --fast, BC7 otherwise, sRGB
+//   normal maps     BC5, X/Y only; the pixel shader rebuilds Z
+//   single channel  BC4 (roughness, AO, metalness, specular, height, masks)
+//
+// Single-channel maps of one material are also packed together into
+// <key>_mask.dds (BC5 for two maps, BC7 for three or four) with a
+// <key>_mask.txt descriptor saying which channel holds which map, see
+// channel_pack.h. The renderer samples that one texture instead of one per map.
+//
+// The kind comes from the file name (see classify) unless forced with --kind.
+// Blocks are encoded on the CPU, in strips of rows across the thread pool,
+// so this runs the same on Linux hosts with no GPU.
+//
+// usage: texture_cooker [textures dir] [--fast] [--force] [--no-pack] [--kind albedo|normal|mask]
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+#endif
+
+#include <DirectXTex.h>
+
+#include "engine/imaging/channel_pack.h"
+#include "engine/imaging/image_decoder.h"
+#include "engine/imaging/mip_generator.h"
+#include "utils/mapped_file.h"
+#include "utils/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace DirectX;
+
+namespace {
+    // Rows of blocks per thread pool item
+    constexpr size_t STRIP_BLOCK_ROWS = 16;
+
+    enum class TextureKind {
+        Albedo,
+        Normal,
+        Mask
+    };
+
+    const char* kindName(TextureKind kind) {
+        switch (kind) {
+            case TextureKind::Normal: return "normal";
+            case TextureKind::Mask:   return "mask";
+            default:                  return "albedo";
+        }
+    }
+
+    const char* formatName(DXGI_FORMAT format) {
+        switch (format) {
+            case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1";
+            case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3";
+            case DXGI_FORMAT_BC4_UNORM:      return "BC4";
+            case DXGI_FORMAT_BC5_UNORM:      return "BC5";
+            case DXGI_FORMAT_BC7_UNORM:      return "BC7";
+            case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7";
+            default:                         return "?";
+        }
+    }
+
+    std::string lowercase(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    bool isImageFile(const fs::path& path) {
+        std::string ext = lowercase(path.extension().string());
+        return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+    }
+
+    bool endsWith(const std::string& s, const char* suffix) {
+        size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    // Naming conventions seen in the bundled assets: brackNM, Cat_bump,
+    // Wood_Tower_Nor, *_Normal_OpenGL, *_Roughness, *_AmbientOcclusion, *_spec
+    TextureKind classify(const fs::path& path) {
+        std::string stem = lowercase(path.stem().string());
+
+        static const char* NORMAL_HINTS[] = { "normal", "bump" };
+        static const char* NORMAL_SUFFIXES[] = { "nm", "_n", "_nor", "_nrm", "normal_opengl", "normal_directx" };
+        static const char* MASK_HINTS[] = { "rough", "occlusion", "metal", "gloss", "spec", "height", "displace", "mask" };
+        static const char* MASK_SUFFIXES[] = { "_ao", "_r", "_m", "_disp" };
+
+        for (const char* hint : NORMAL_HINTS)
+            if (stem.find(hint) != std::string::npos) return TextureKind::Normal;
+        for (const char* suffix : NORMAL_SUFFIXES)
+            if (endsWith(stem, suffix)) return TextureKind::Normal;
+        for (const char* hint : MASK_HINTS)
+            if (stem.find(hint) != std::string::npos) return TextureKind::Mask;
+        for (const char* suffix : MASK_SUFFIXES)
+            if (endsWith(stem, suffix)) return TextureKind::Mask;
+
+        return TextureKind::Albedo;
+    }
+
+    uint32_t alignToBlock(uint32_t size) {
+        return (size + 3) & ~3u;
+    }
+
+    bool hasAlpha(const Image& image) {
+        for (size_t y = 0; y < image.height; ++y) {
+            const uint8_t* row = image.pixels + y * image.rowPitch;
+            for (size_t x = 0; x < image.width; ++x) {
+                if (row[x * 4 + 3] != 255)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Box-filtered normals come out short; put them back on the unit sphere
+    void renormalize(const Image& image) {
+        for (size_t y = 0; y < image.height; ++y) {
+            uint8_t* row = image.pixels + y * image.rowPitch;
+            for (size_t x = 0; x < image.width; ++x) {
+                uint8_t* p = row + x * 4;
+                float n[3] = { p[0] / 127.5f - 1.0f, p[1] / 127.5f - 1.0f, p[2] / 127.5f - 1.0f };
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length < 1e-4f)
+                    continue;
+                for (int c = 0; c < 3; ++c)
+                    p[c] = static_cast<uint8_t>(std::clamp((n[c] / length + 1.0f) * 127.5f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    }
+
+    // Decodes with the portable decoder and builds the mip chain in the format
+    // the kind wants: sRGB for color, linear for data
+    bool loadSource(const fs::path& path, TextureKind kind, MipFilter filter, ScratchImage& image, std::string& error) {
+        MappedFile file;
+        if (!file.open(path.string())) {
+            error = "can't open";
+            return false;
+        }
+
+        ImageInfo info;
+        if (!readImageInfo(file.getData(), file.getSize(), info)) {
+            error = "unsupported image";
+            return false;
+        }
+        info.channels = 4; // grayscale replicated, the kind picks the format
+
+        // BC blocks are 4x4 and a mip 0 that isn't a multiple of 4 only loads
+        // where the GPU supports unaligned block textures. Such sources are
+        // stretched to the next multiple, which keeps UVs covering the image.
+        const uint32_t width = alignToBlock(info.width);
+        const uint32_t height = alignToBlock(info.height);
+        const bool resized = width != info.width || height != info.height;
+
+        const bool srgb = kind == TextureKind::Albedo;
+        const DXGI_FORMAT format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        const uint32_t levels = filter == MipFilter::None ? 1 : mipLevelCount(width, height);
+        if (FAILED(image.Initialize2D(format, width, height, 1, levels))) {
+            error = "out of memory";
+            return false;
+        }
+
+        const Image* base = image.GetImage(0, 0, 0);
+        if (resized) {
+            ScratchImage decoded;
+            if (FAILED(decoded.Initialize2D(format, info.width, info.height, 1, 1))) {
+                error = "out of memory";
+                return false;
+            }
+
+            const Image* source = decoded.GetImage(0, 0, 0);
+            if (!decodeImage(file.getData(), file.getSize(), info, source->pixels, source->rowPitch, &error))
+                return false;
+
+            ScratchImage stretched;
+            if (FAILED(Resize(*source, width, height, TEX_FILTER_CUBIC, stretched))) {
+                error = "resize failed";
+                return false;
+            }
+
+            const Image* result = stretched.GetImage(0, 0, 0);
+            for (uint32_t y = 0; y < height; ++y)
+                std::memcpy(base->pixels + y * base->rowPitch, result->pixels + y * result->rowPitch, static_cast<size_t>(width) * 4);
+        } else if (!decodeImage(file.getData(), file.getSize(), info, base->pixels, base->rowPitch, &error)) {
+            return false;
+        }
+
+        std::vector<MipSurface> surfaces(levels);
+        for (uint32_t level = 0; level < levels; ++level) {
+            const Image* mip = image.GetImage(level, 0, 0);
+            surfaces[level] = { mip->pixels, static_cast<uint32_t>(mip->width), static_cast<uint32_t>(mip->height), mip->rowPitch };
+        }
+        generateMips(surfaces.data(), levels, srgb, filter);
+
+        if (kind == TextureKind::Normal) {
+            for (uint32_t level = resized ? 0 : 1; level < levels; ++level)
+                renormalize(*image.GetImage(level, 0, 0));
+        }
+
+        return true;
+    }
+
+    // DirectXTex's own parallel path needs OpenMP; strips of block rows on the
+    // thread pool instead, each compressed into its slice of the destination
+    HRESULT compressParallel(const ScratchImage& source, DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, ScratchImage& compressed) {
+        const TexMetadata& meta = source.GetMetadata();
+        HRESULT hr = compressed.Initialize2D(format, meta.width, meta.height, 1, meta.mipLevels);
+        if (FAILED(hr))
+            return hr;
+
+        struct Strip {
+            size_t level;
+            size_t firstBlockRow;
+            size_t blockRows;
+        };
+
+        std::vector<Strip> strips;
+        for (size_t level = 0; level < meta.mipLevels; ++level) {
+            const size_t blockRows = (source.GetImage(level, 0, 0)->height + 3) / 4;
+            for (size_t row = 0; row < blockRows; row += STRIP_BLOCK_ROWS)
+                strips.push_back({ level, row, std::min(STRIP_BLOCK_ROWS, blockRows - row) });
+        }
+
+        std::atomic<HRESULT> result(S_OK);
+        ThreadPool::instance().parallelFor(strips.size(), [&](size_t i) {
+            const Strip& strip = strips[i];
+            const Image* src = source.GetImage(strip.level, 0, 0);
+            const Image* dst = compressed.GetImage(strip.level, 0, 0);
+
+            const size_t firstRow = strip.firstBlockRow * 4;
+            Image slice = *src;
+            slice.height = std::min(strip.blockRows * 4, src->height - firstRow);
+            slice.pixels = src->pixels + firstRow * src->rowPitch;
+            slice.slicePitch = slice.rowPitch * slice.height;
+
+            ScratchImage encoded;
+            HRESULT stripResult = Compress(slice, format, flags, TEX_THRESHOLD_DEFAULT, encoded);
+            if (FAILED(stripResult)) {
+                result = stripResult;
+                return;
+            }
+
+            const Image* blocks = encoded.GetImage(0, 0, 0);
+            for (size_t row = 0; row < strip.blockRows; ++row) {
+                std::memcpy(
+                    dst->pixels + (strip.firstBlockRow + row) * dst->rowPitch,
+                    blocks->pixels + row * blocks->rowPitch,
+                    std::min(dst->rowPitch, blocks->rowPitch)
+                );
+            }
+        });
+
+        return result;
+    }
+
+    struct CookResult {
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        size_t width = 0;
+        size_t height = 0;
+        size_t mipLevels = 0;
+        uintmax_t sourceBytes = 0;
+        uintmax_t cookedBytes = 0;
+        double ms = 0.0;
+    };
+
+    bool cook(const fs::path& path, const fs::path& output, TextureKind kind, bool fast, CookResult& cooked, std::string& error) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Kaiser keeps detail the box filter blurs out of the smaller levels
+        ScratchImage source;
+        if (!loadSource(path, kind, fast ? MipFilter::Box : MipFilter::Kaiser, source, error))
+            return false;
+
+        TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
+        switch (kind) {
+            case TextureKind::Albedo:
+                if (fast) {
+                    cooked.format = hasAlpha(*source.GetImage(0, 0, 0)) ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM_SRGB;
+                } else {
+                    cooked.format = DXGI_FORMAT_BC7_UNORM_SRGB;
+                }
+                break;
+            case TextureKind::Normal:
+                cooked.format = DXGI_FORMAT_BC5_UNORM;
+                break;
+            case TextureKind::Mask:
+                cooked.format = DXGI_FORMAT_BC4_UNORM;
+                break;
+        }
+
+        if (fast) {
+            flags |= TEX_COMPRESS_BC7_QUICK;
+        } else {
+            flags |= TEX_COMPRESS_BC7_USE_3SUBSETS;
+            if (cooked.format == DXGI_FORMAT_BC1_UNORM_SRGB || cooked.format == DXGI_FORMAT_BC3_UNORM_SRGB)
+                flags |= TEX_COMPRESS_DITHER;
+        }
+
+        ScratchImage compressed;
+        HRESULT hr = compressParallel(source, cooked.format, flags, compressed);
+        if (FAILED(hr)) {
+            error = "compression failed";
+            return false;
+        }
+
+        hr = SaveToDDSFile(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(), DDS_FLAGS_NONE, output.wstring().c_str());
+        if (FAILED(hr)) {
+            error = "can't write " + output.string();
+            return false;
+        }
+
+        std::error_code ec;
+        const TexMetadata& meta = compressed.GetMetadata();
+        cooked.width = meta.width;
+        cooked.height = meta.height;
+        cooked.mipLevels = meta.mipLevels;
+        cooked.sourceBytes = fs::file_size(path, ec);
+        cooked.cookedBytes = fs::file_size(output, ec);
+        cooked.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return true;
+    }
+
+    bool isUpToDate(const fs::path& source, const fs::path& output) {
+        std::error_code ec;
+        if (!fs::exists(output, ec))
+            return false;
+        return fs::last_write_time(output, ec) >= fs::last_write_time(source, ec);
+    }
+
+    // One material's single-channel maps into output, channels in MaskChannel
+    // order. Maps of different sizes are resampled to the largest, which
+    // loadSource already made a multiple of 4.
+    bool cookPacked(const std::vector<fs::path>& sources, const fs::path& output, const fs::path& layoutPath, bool fast, CookResult& cooked, std::string& error) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        ScratchImage images[MASK_CHANNEL_COUNT];
+        ChannelSource channels[MASK_CHANNEL_COUNT];
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        for (const fs::path& path : sources) {
+            MaskChannel channel;
+            classifyMaskChannel(path, channel);
+            const size_t map = static_cast<size_t>(channel);
+
+            if (!loadSource(path, TextureKind::Mask, MipFilter::None, images[map], error)) {
+                error = path.filename().string() + ": " + error;
+                return false;
+            }
+
+            const Image* image = images[map].GetImage(0, 0, 0);
+            channels[map] = { image->pixels, static_cast<uint32_t>(image->width), static_cast<uint32_t>(image->height), image->rowPitch };
+            width = std::max(width, channels[map].width);
+            height = std::max(height, channels[map].height);
+            std::error_code ec;
+            cooked.sourceBytes += fs::file_size(path, ec);
+        }
+
+        ChannelLayout layout;
+        int32_t next = 0;
+        for (size_t map = 0; map < MASK_CHANNEL_COUNT; ++map) {
+            if (channels[map].pixels)
+                layout.channels[map] = next++;
+        }
+
+        const uint32_t levels = mipLevelCount(width, height);
+        ScratchImage packed;
+        if (FAILED(packed.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, levels))) {
+            error = "out of memory";
+            return false;
+        }
+
+        const Image* base = packed.GetImage(0, 0, 0);
+        packChannels(channels, layout, base->pixels, width, height, base->rowPitch);
+
+        std::vector<MipSurface> surfaces(levels);
+        for (uint32_t level = 0; level < levels; ++level) {
+            const Image* mip = packed.GetImage(level, 0, 0);
+            surfaces[level] = { mip->pixels, static_cast<uint32_t>(mip->width), static_cast<uint32_t>(mip->height), mip->rowPitch };
+        }
+        generateMips(surfaces.data(), levels, false, fast ? MipFilter::Box : MipFilter::Kaiser);
+
+        // Two maps fit BC5's independent channels, more need BC7
+        cooked.format = layout.count() == 2 ? DXGI_FORMAT_BC5_UNORM : DXGI_FORMAT_BC7_UNORM;
+        TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
+        flags |= fast ? TEX_COMPRESS_BC7_QUICK : TEX_COMPRESS_BC7_USE_3SUBSETS;
+
+        ScratchImage compressed;
+        if (FAILED(compressParallel(packed, cooked.format, flags, compressed))) {
+            error = "compression failed";
+            return false;
+        }
+
+        if (FAILED(SaveToDDSFile(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(), DDS_FLAGS_NONE, output.wstring().c_str()))) {
+            error = "can't write " + output.string();
+            return false;
+        }
+
+        if (!writeChannelLayout(layoutPath, layout, &error))
+            return false;
+
+        std::error_code ec;
+        cooked.width = width;
+        cooked.height = height;
+        cooked.mipLevels = levels;
+        cooked.cookedBytes = fs::file_size(output, ec);
+        cooked.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string root = "assets/models";
+    bool fast = false;
+    bool force = false;
+    bool pack = true;
+    std::optional<TextureKind> forcedKind;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fast") {
+            fast = true;
+        } else if (arg == "--force") {
+            force = true;
+        } else if (arg == "--no-pack") {
+            pack = false;
+        } else if (arg == "--kind" && i + 1 < argc) {
+            std::string kind = argv[++i];
+            forcedKind = kind == "normal" ? TextureKind::Normal : kind == "mask" ? TextureKind::Mask : TextureKind::Albedo;
+        } else {
+            root = arg;
+        }
+    }
+
+    std::vector<fs::path> textures;
+    std::error_code ec;
+    if (fs::is_regular_file(root, ec)) {
+        textures.push_back(root);
+    } else {
+        for (const auto& entry : fs::recursive_directory_iterator(root, ec)) {
+            if (entry.is_regular_file() && isImageFile(entry.path()))
+                textures.push_back(entry.path());
+        }
+    }
+    std::sort(textures.begin(), textures.end());
+
+    if (textures.empty()) {
+        std::printf("No textures found under %s\n", root.c_str());
+        return 1;
+    }
+
+    std::printf("%-44s %-7s %-5s %12s %5s %10s %10s %10s\n", "texture", "kind", "fmt", "size", "mips", "source KB", "dds KB", "ms");
+
+    uintmax_t totalSource = 0;
+    uintmax_t totalCooked = 0;
+    int failed = 0;
+
+    for (const fs::path& path : textures) {
+        fs::path output = path;
+        output.replace_extension(".dds");
+
+        if (!force && isUpToDate(path, output)) {
+            std::printf("%-44s up to date\n", path.filename().string().c_str());
+            continue;
+        }
+
+        TextureKind kind = forcedKind ? *forcedKind : classify(path);
+
+        CookResult cooked;
+        std::string error;
+        if (!cook(path, output, kind, fast, cooked, error)) {
+            std::printf("%-44s %s\n", path.filename().string().c_str(), error.c_str());
+            failed++;
+            continue;
+        }
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%zux%zu", cooked.width, cooked.height);
+        std::printf("%-44s %-7s %-5s %12s %5zu %10ju %10ju %10.1f\n",
+            path.filename().string().c_str(), kindName(kind), formatName(cooked.format), size, cooked.mipLevels,
+            cooked.sourceBytes / 1024, cooked.cookedBytes / 1024, cooked.ms);
+
+        totalSource += cooked.sourceBytes;
+        totalCooked += cooked.cookedBytes;
+    }
+
+    // Maps of one material (same key in one directory), at least two distinct ones
+    std::map<std::pair<fs::path, std::string>, std::vector<fs::path>> materials;
+    if (pack && !forcedKind) {
+        for (const fs::path& path : textures) {
+            MaskChannel channel;
+            if (classify(path) == TextureKind::Mask && classifyMaskChannel(path, channel))
+                materials[{ path.parent_path(), channelPackKey(path) }].push_back(path);
+        }
+    }
+
+    for (auto& [material, paths] : materials) {
+        // First map of each channel wins
+        std::vector<fs::path> sources;
+        bool taken[MASK_CHANNEL_COUNT] = {};
+        for (const fs::path& path : paths) {
+            MaskChannel channel;
+            classifyMaskChannel(path, channel);
+            if (!taken[static_cast<size_t>(channel)]) {
+                taken[static_cast<size_t>(channel)] = true;
+                sources.push_back(path);
+            }
+        }
+        if (sources.size() < 2)
+            continue;
+
+        const fs::path output = channelPackPath(material.first, material.second);
+        const fs::path layoutPath = channelLayoutPath(material.first, material.second);
+        const std::string name = output.filename().string();
+
+        bool upToDate = !force && fs::exists(layoutPath, ec);
+        for (const fs::path& source : sources)
+            upToDate = upToDate && isUpToDate(source, output);
+
+        if (upToDate) {
+            std::printf("%-44s up to date\n", name.c_str());
+            continue;
+        }
+
+        CookResult cooked;
+        std::string error;
+        if (!cookPacked(sources, output, layoutPath, fast, cooked, error)) {
+            std::printf("%-44s %s\n", name.c_str(), error.c_str());
+            failed++;
+            continue;
+        }
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%zux%zu", cooked.width, cooked.height);
+        std::printf("%-44s %-7s %-5s %12s %5zu %10ju %10ju %10.1f\n",
+            name.c_str(), "packed", formatName(cooked.format), size, cooked.mipLevels,
+            cooked.sourceBytes / 1024, cooked.cookedBytes / 1024, cooked.ms);
+
+        totalSource += cooked.sourceBytes;
+        totalCooked += cooked.cookedBytes;
+    }
+
+    if (totalCooked) {
+        std::printf("total: %ju KB of sources -> %ju KB of DDS\n", totalSource / 1024, totalCooked / 1024);
+    }
+
+    return failed ? 1 : 0;
+}
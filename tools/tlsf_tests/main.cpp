@@ -0,0 +1,341 @@
+// Tests for the TLSF core behind GpuAllocator and GeometryPool. CPU only, so
+// it runs on any build host. Fixed cases cover merging of freed neighbours,
+// alignment, an exhausted heap and reuse after free; the randomized run keeps
+// a byte-for-byte owner map of the heap next to the allocator and checks every
+// allocation against it, plus the free block list once in a while.
+//
+// Prints each failed check and returns 1 if there was any.
+//
+// usage: tlsf_tests [--seed <n>] [--steps <n>]
+
+#include "utils/tlsf_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    size_t failures = 0;
+
+    #define CHECK(condition) check((condition), #condition, __LINE__)
+
+    bool check(bool condition, const char* expression, int line) {
+        if (!condition) {
+            std::printf("  line %d: %s\n", line, expression);
+            failures++;
+        }
+        return condition;
+    }
+
+    bool valid(const TlsfAllocator::Allocation& allocation) {
+        return allocation.block != TlsfAllocator::INVALID_BLOCK;
+    }
+
+    // Smallest free block allocate(bytes, alignment) is guaranteed to succeed
+    // with: the request plus worst-case padding, rounded up to its size class
+    uint64_t guaranteedFit(uint64_t bytes, uint64_t alignment) {
+        bytes += alignment - 1;
+        if (bytes < 16)
+            return bytes;
+
+        const uint32_t shift = 63 - std::countl_zero(bytes) - 4;
+        bytes += (1ull << shift) - 1;
+        const uint32_t classShift = 63 - std::countl_zero(bytes) - 4;
+        return bytes >> classShift << classShift;
+    }
+
+    void testCoalescing() {
+        TlsfAllocator allocator(1024);
+
+        TlsfAllocator::Allocation a = allocator.allocate(256);
+        TlsfAllocator::Allocation b = allocator.allocate(256);
+        TlsfAllocator::Allocation c = allocator.allocate(256);
+        TlsfAllocator::Allocation d = allocator.allocate(256);
+        if (!CHECK(valid(a) && valid(b) && valid(c) && valid(d)))
+            return;
+
+        CHECK(allocator.getUsed() == 1024);
+        CHECK(allocator.getFreeBlockCount() == 0);
+
+        // Two holes that don't touch stay apart
+        allocator.free(a.block);
+        allocator.free(c.block);
+        CHECK(allocator.getFreeBlockCount() == 2);
+        CHECK(allocator.getLargestFree() == 256);
+        CHECK(!valid(allocator.allocate(512)));
+
+        // Freeing what is between them joins all three
+        allocator.free(b.block);
+        CHECK(allocator.getFreeBlockCount() == 1);
+        CHECK(allocator.getLargestFree() == 768);
+
+        TlsfAllocator::Allocation merged = allocator.allocate(768);
+        CHECK(valid(merged) && merged.offset == 0);
+
+        allocator.free(merged.block);
+        allocator.free(d.block);
+        CHECK(allocator.empty());
+        CHECK(allocator.getUsed() == 0);
+        CHECK(allocator.getFreeBlockCount() == 1);
+        CHECK(allocator.getLargestFree() == 1024);
+    }
+
+    void testAlignment() {
+        const uint64_t heapSize = 1 << 20;
+        TlsfAllocator allocator(heapSize);
+
+        // Knock the next free offset off every alignment first
+        TlsfAllocator::Allocation odd = allocator.allocate(3);
+        CHECK(valid(odd) && odd.offset == 0);
+
+        std::vector<TlsfAllocator::Allocation> live;
+        uint64_t requested = 3;
+        for (uint64_t alignment = 2; alignment <= 64 * 1024; alignment *= 2) {
+            const uint64_t bytes = alignment / 2 + 5;
+            TlsfAllocator::Allocation allocation = allocator.allocate(bytes, alignment);
+            if (!CHECK(valid(allocation)))
+                continue;
+
+            CHECK(allocation.offset % alignment == 0);
+            CHECK(allocation.offset + bytes <= heapSize);
+            live.push_back(allocation);
+            requested += bytes;
+        }
+
+        // Padding goes back to the free blocks, only what was asked for counts
+        CHECK(allocator.getUsed() == requested);
+        CHECK(allocator.getAllocationCount() == live.size() + 1);
+
+        allocator.free(odd.block);
+        for (const TlsfAllocator::Allocation& allocation : live)
+            allocator.free(allocation.block);
+        CHECK(allocator.empty());
+        CHECK(allocator.getFreeBlockCount() == 1);
+        CHECK(allocator.getLargestFree() == heapSize);
+    }
+
+    void testExhausted() {
+        TlsfAllocator allocator(4096);
+
+        CHECK(!valid(allocator.allocate(0)));
+        CHECK(!valid(allocator.allocate(4097)));
+
+        TlsfAllocator::Allocation whole = allocator.allocate(4096);
+        CHECK(valid(whole) && whole.offset == 0);
+        CHECK(!valid(allocator.allocate(1)));
+        CHECK(allocator.getLargestFree() == 0);
+
+        // A failed request leaves nothing behind
+        CHECK(allocator.getUsed() == 4096);
+        CHECK(allocator.getAllocationCount() == 1);
+
+        // Room, but not once the alignment is met
+        allocator.free(whole.block);
+        TlsfAllocator::Allocation front = allocator.allocate(4000);
+        CHECK(valid(front));
+        CHECK(!valid(allocator.allocate(64, 4096)));
+
+        TlsfAllocator empty(0);
+        CHECK(!valid(empty.allocate(1)));
+
+        // A heap of getFitSize() always takes the one request, count + 1 often doesn't
+        for (uint64_t count : { 1ull, 15ull, 16ull, 1000ull, 1000000ull, 5000000ull }) {
+            for (uint64_t alignment : { 1ull, 2ull, 256ull }) {
+                const uint64_t fit = TlsfAllocator::getFitSize(count, alignment);
+                CHECK(fit == guaranteedFit(count, alignment));
+
+                TlsfAllocator dedicated(fit);
+                TlsfAllocator::Allocation allocation = dedicated.allocate(count, alignment);
+                CHECK(valid(allocation) && allocation.offset % alignment == 0);
+            }
+        }
+    }
+
+    void testReuse() {
+        TlsfAllocator allocator(64 * 1024);
+
+        TlsfAllocator::Allocation first = allocator.allocate(1000, 256);
+        CHECK(valid(first));
+        allocator.free(first.block);
+
+        // Same request on the emptied heap lands in the same place
+        TlsfAllocator::Allocation again = allocator.allocate(1000, 256);
+        CHECK(valid(again) && again.offset == first.offset);
+
+        // A second free of the same handle is ignored
+        allocator.free(again.block);
+        allocator.free(again.block);
+        CHECK(allocator.getUsed() == 0);
+        CHECK(allocator.getAllocationCount() == 0);
+
+        // Churn, every round has to end merged back into one free block
+        std::vector<TlsfAllocator::Allocation> live;
+        for (int round = 0; round < 100; ++round) {
+            for (int i = 0; i < 32; ++i)
+                live.push_back(allocator.allocate(100 + i * 10, 16));
+            for (const TlsfAllocator::Allocation& allocation : live) {
+                CHECK(valid(allocation));
+                allocator.free(allocation.block);
+            }
+            live.clear();
+
+            CHECK(allocator.getFreeBlockCount() == 1);
+            CHECK(allocator.getLargestFree() == allocator.getSize());
+        }
+    }
+
+    struct Live {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t block = TlsfAllocator::INVALID_BLOCK;
+        uint32_t id = 0;
+    };
+
+    // The owner map's free runs have to be exactly the allocator's free blocks
+    void checkFreeRuns(const TlsfAllocator& allocator, const std::vector<uint32_t>& owners) {
+        size_t runs = 0;
+        uint64_t longest = 0;
+        uint64_t run = 0;
+        for (uint32_t owner : owners) {
+            if (owner == 0) {
+                runs += run == 0;
+                run++;
+                longest = std::max(longest, run);
+            } else {
+                run = 0;
+            }
+        }
+
+        CHECK(allocator.getFreeBlockCount() == runs);
+        CHECK(allocator.getLargestFree() == longest);
+    }
+
+    void testRandomized(uint64_t seed, size_t steps) {
+        const uint64_t heapSize = 256 * 1024;
+        TlsfAllocator allocator(heapSize);
+        std::mt19937_64 rng(seed);
+
+        std::vector<uint32_t> owners(heapSize, 0);
+        std::vector<Live> live;
+        uint64_t used = 0;
+        uint32_t nextId = 1;
+        size_t allocated = 0;
+        size_t failed = 0;
+
+        for (size_t step = 0; step < steps && failures < 20; ++step) {
+            if (live.empty() || rng() % 100 < 55) {
+                const uint64_t bytes = rng() % 8 == 0 ? 1 + rng() % (32 * 1024) : 1 + rng() % 2048;
+                const uint64_t alignment = 1ull << (rng() % 13);
+
+                TlsfAllocator::Allocation allocation = allocator.allocate(bytes, alignment);
+                if (!valid(allocation)) {
+                    // Only acceptable when no free run is large enough to be sure of a fit
+                    uint64_t longest = 0;
+                    uint64_t run = 0;
+                    for (uint32_t owner : owners) {
+                        run = owner == 0 ? run + 1 : 0;
+                        longest = std::max(longest, run);
+                    }
+                    CHECK(longest < guaranteedFit(bytes, alignment));
+                    failed++;
+                    continue;
+                }
+
+                CHECK(allocation.offset % alignment == 0);
+                if (!CHECK(allocation.offset + bytes <= heapSize))
+                    continue;
+
+                bool overlaps = false;
+                for (uint64_t i = allocation.offset; i < allocation.offset + bytes; ++i) {
+                    overlaps = overlaps || owners[i] != 0;
+                    owners[i] = nextId;
+                }
+                CHECK(!overlaps);
+
+                live.push_back({ allocation.offset, bytes, allocation.block, nextId++ });
+                used += bytes;
+                allocated++;
+            } else {
+                const size_t index = rng() % live.size();
+                const Live entry = live[index];
+                live[index] = live.back();
+                live.pop_back();
+
+                // Nothing else may have written over it while it was live
+                bool intact = true;
+                for (uint64_t i = entry.offset; i < entry.offset + entry.size; ++i) {
+                    intact = intact && owners[i] == entry.id;
+                    owners[i] = 0;
+                }
+                CHECK(intact);
+
+                allocator.free(entry.block);
+                used -= entry.size;
+            }
+
+            CHECK(allocator.getUsed() == used);
+            CHECK(allocator.getAllocationCount() == live.size());
+
+            if (step % 1000 == 0)
+                checkFreeRuns(allocator, owners);
+        }
+
+        for (const Live& entry : live)
+            allocator.free(entry.block);
+        CHECK(allocator.empty());
+        CHECK(allocator.getFreeBlockCount() == 1);
+        CHECK(allocator.getLargestFree() == heapSize);
+
+        std::printf("  %zu allocations, %zu failed on a full heap\n", allocated, failed);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = 1;
+    size_t steps = 100000;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--seed") {
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (arg == "--steps") {
+            steps = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            std::printf("usage: tlsf_tests [--seed <n>] [--steps <n>]\n");
+            return 1;
+        }
+    }
+
+    struct Test {
+        const char* name;
+        std::function<void()> run;
+    };
+
+    const Test tests[] = {
+        { "coalescing", testCoalescing },
+        { "alignment", testAlignment },
+        { "exhausted", testExhausted },
+        { "reuse", testReuse },
+        { "randomized", [=]() { testRandomized(seed, steps); } },
+    };
+
+    size_t failedTests = 0;
+    for (const Test& test : tests) {
+        std::printf("%s\n", test.name);
+
+        const size_t before = failures;
+        test.run();
+        if (failures != before) {
+            std::printf("  FAILED\n");
+            failedTests++;
+        }
+    }
+
+    std::printf("%zu of %zu tests passed\n", std::size(tests) - failedTests, std::size(tests));
+    return failedTests ? 1 : 0;
+}